@@ -0,0 +1,96 @@
+#include "bench.hpp"
+#include <aggregate.hpp>
+#include <fmt/format.h>
+#include <random>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t rows = 1'000'000;
+
+struct Sample {
+  std::vector<std::int64_t> integers;
+  std::vector<double> doubles;
+  std::vector<std::string> fields;
+};
+
+const Sample& sample() {
+  static const auto sample = []() {
+    Sample sample;
+    std::mt19937_64 random{ 0 };
+    for (std::size_t row = 0; row < rows; row++) {
+      sample.integers.push_back(static_cast<std::int64_t>(random() % 1'000'000));
+      sample.doubles.push_back(static_cast<double>(random() % 1'000'000) / 100.0);
+      sample.fields.push_back(fmt::format("{}.{:02}", random() % 10'000, random() % 100));
+    }
+    return sample;
+  }();
+  return sample;
+}
+
+Totals run(Aggregator& aggregator, std::size_t begin, std::size_t end) {
+  const std::stop_source stop;
+  aggregator.Start(begin, end, nullptr, 4);
+  for (std::size_t job = 0; job < aggregator.Jobs(); job++) {
+    aggregator.Run(job, stop.get_token());
+  }
+  return aggregator.Result();
+}
+
+// Aggregates a column of integers and a column of doubles. One operation is one row.
+void aggregate_numbers(bench::state& state) {
+  const auto& data = sample();
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += rows) {
+      Aggregator aggregator;
+      aggregator.Add(Aggregator::Integers(data.integers));
+      aggregator.Add(Aggregator::Doubles(data.doubles));
+      auto totals = run(aggregator, 0, rows);
+      bench::do_not_optimize(totals);
+    }
+  });
+}
+
+// Aggregates a column of text that is parsed as numbers. One operation is one row.
+void aggregate_texts(bench::state& state) {
+  const auto& data = sample();
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += rows) {
+      Aggregator aggregator;
+      aggregator.Add(Aggregator::Texts([&](std::size_t row) noexcept { return std::string_view{ data.fields[row] }; }));
+      auto totals = run(aggregator, 0, rows);
+      bench::do_not_optimize(totals);
+    }
+  });
+}
+
+// Appends a thousandth of the rows to existing totals, or aggregates all rows again. One operation is one update.
+void aggregate_append(bench::state& state, bool incremental) {
+  const auto& data = sample();
+  constexpr auto append = rows / 1000;
+  const auto prepare = [&](Aggregator& aggregator) {
+    aggregator.Add(Aggregator::Integers(data.integers));
+    aggregator.Add(Aggregator::Doubles(data.doubles));
+  };
+  Aggregator first;
+  prepare(first);
+  const auto base = run(first, 0, rows - append);
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      Aggregator aggregator;
+      prepare(aggregator);
+      auto totals = incremental ? base : Totals{};
+      totals.Merge(run(aggregator, totals.rows, rows));
+      bench::do_not_optimize(totals);
+    }
+  });
+}
+
+BENCHMARK("aggregate/numbers/rows:1000000", 10'000'000, aggregate_numbers);
+BENCHMARK("aggregate/texts/rows:1000000", 4'000'000, aggregate_texts);
+BENCHMARK("aggregate/append/incremental", 2'000, [](bench::state& state) { aggregate_append(state, true); });
+BENCHMARK("aggregate/append/recompute", 20, [](bench::state& state) { aggregate_append(state, false); });
+
+}  // namespace
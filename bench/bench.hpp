@@ -0,0 +1,146 @@
+#pragma once
+#include <ice/context.hpp>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace bench {
+
+using clock = std::chrono::steady_clock;
+
+// State of a single benchmark repetition.
+class state {
+public:
+  explicit state(std::uint64_t operations) noexcept : operations_(operations) {
+  }
+
+  state(state&& other) = delete;
+  state(const state& other) = delete;
+  state& operator=(state&& other) = delete;
+  state& operator=(const state& other) = delete;
+
+  ~state() = default;
+
+  // Number of operations the benchmark must perform in measure.
+  std::uint64_t operations() const noexcept {
+    return operations_;
+  }
+
+  // Measures the given function. Setup and teardown outside of it are not measured.
+  template <typename Function>
+  void measure(Function&& function) {
+    const auto start = clock::now();
+    function();
+    elapsed_ += clock::now() - start;
+  }
+
+  // Reports an additional value as the median of all repetitions.
+  void counter(std::string name, double value) {
+    counters_.emplace_back(std::move(name), value);
+  }
+
+  clock::duration elapsed() const noexcept {
+    return elapsed_;
+  }
+
+  const std::vector<std::pair<std::string, double>>& counters() const noexcept {
+    return counters_;
+  }
+
+private:
+  const std::uint64_t operations_;
+  clock::duration elapsed_{};
+  std::vector<std::pair<std::string, double>> counters_;
+};
+
+using function = void (*)(bench::state& state);
+
+struct benchmark {
+  std::string name;
+  std::uint64_t operations;
+  bench::function function;
+};
+
+inline std::vector<benchmark>& registry() {
+  static std::vector<benchmark> benchmarks;
+  return benchmarks;
+}
+
+struct registration {
+  registration(std::string name, std::uint64_t operations, bench::function function) {
+    registry().push_back({ std::move(name), operations, function });
+  }
+};
+
+// Prevents the compiler from optimizing away the computation of a value.
+template <typename T>
+inline void do_not_optimize(T& value) noexcept {
+#ifdef _MSC_VER
+  const auto volatile pointer = &value;
+  (void)pointer;
+  _ReadWriteBarrier();
+#else
+  asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// Busy loop that emulates a small amount of work.
+inline void spin(std::chrono::nanoseconds duration) noexcept {
+  const auto end = clock::now() + duration;
+  while (clock::now() < end) {
+    ice::pause();
+  }
+}
+
+// Percentile of unsorted samples.
+inline double percentile(std::vector<double> samples, double percentile) noexcept {
+  if (samples.empty()) {
+    return 0.0;
+  }
+  const auto index = static_cast<std::size_t>(static_cast<double>(samples.size() - 1) * percentile / 100.0);
+  std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+  return samples[index];
+}
+
+// Runs an ice::context on its own thread.
+class context_thread {
+public:
+  context_thread() : thread_([this]() { context_.run(); }) {
+  }
+
+  context_thread(context_thread&& other) = delete;
+  context_thread(const context_thread& other) = delete;
+  context_thread& operator=(context_thread&& other) = delete;
+  context_thread& operator=(const context_thread& other) = delete;
+
+  ~context_thread() {
+    context_.stop();
+    thread_.join();
+  }
+
+  ice::context& operator*() noexcept {
+    return context_;
+  }
+
+private:
+  ice::context context_;
+  std::thread thread_;
+};
+
+}  // namespace bench
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+
+// Registers a benchmark with a name, a number of operations per repetition and a function.
+#define BENCHMARK(name, operations, function) \
+  static const bench::registration BENCH_CONCAT(registration_, __LINE__) { name, operations, function }
@@ -0,0 +1,99 @@
+#include "bench.hpp"
+#include <cells.hpp>
+#include <csv.hpp>
+#include <ice/pool.hpp>
+#include <ice/task.hpp>
+#include <ice/when_all.hpp>
+#include <fmt/format.h>
+#include <filesystem>
+#include <fstream>
+#include <latch>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Writes a temporary file with a quoted text column and returns its path.
+const std::filesystem::path& sample() {
+  static const std::filesystem::path path = []() {
+    auto path = std::filesystem::temp_directory_path() / "carta-bench.csv";
+    std::ofstream file{ path, std::ios::binary };
+    std::mt19937_64 random{ 0 };
+    file << "id,time,name,value\n";
+    std::string line;
+    for (std::size_t row = 0; row < 1'000'000; row++) {
+      line.clear();
+      fmt::format_to(std::back_inserter(line), "{},{},\"Name {}, \"\"{}\"\"\",{}.{:02}\n", row, 1'577'836'800 + row * 30,
+        random() % 1000, random() % 10, random() % 100000, random() % 100);
+      file << line;
+    }
+    return path;
+  }();
+  return path;
+}
+
+ice::task<void> scan(ice::pool& pool, std::string_view data, Csv::Chunk& chunk) {
+  co_await pool.schedule(true);
+  Csv::Scan(data, chunk);
+}
+
+ice::task<void> index(ice::pool& pool, Csv& csv, std::vector<Csv::Chunk>& chunks, std::latch& done) {
+  std::vector<ice::task<void>> scans;
+  for (auto& chunk : chunks) {
+    scans.push_back(scan(pool, csv.Data(), chunk));
+  }
+  co_await ice::when_all(scans);
+  for (const auto& chunk : chunks) {
+    csv.Append(chunk);
+  }
+  done.count_down();
+}
+
+// Builds the row index of the sample file with the given number of threads.
+// One operation is one byte of the file.
+void csv_index(bench::state& state, std::size_t threads) {
+  ice::pool pool{ threads };
+  Csv csv;
+  csv.Open(sample());
+  const auto size = static_cast<double>(csv.Data().size());
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += csv.Data().size()) {
+      csv.Open(sample());
+      auto chunks = csv.Split(1 << 20, 4 << 20);
+      std::latch done{ 1 };
+      index(pool, csv, chunks, done).detach();
+      done.wait();
+    }
+  });
+  state.counter("rows", static_cast<double>(csv.Rows()));
+  state.counter("bytes", size);
+}
+
+BENCHMARK("csv/index/threads:1", 200'000'000, [](bench::state& state) { csv_index(state, 1); });
+BENCHMARK("csv/index/threads:4", 200'000'000, [](bench::state& state) { csv_index(state, 4); });
+
+// Formats windows of 100 rows from the mapped file into cells.
+void csv_fill(bench::state& state) {
+  Csv csv;
+  csv.Open(sample());
+  auto chunks = csv.Split();
+  for (auto& chunk : chunks) {
+    Csv::Scan(csv.Data(), chunk);
+    csv.Append(chunk);
+  }
+  const auto cols = static_cast<int>(csv.Cols());
+  const auto rows = static_cast<int>(csv.Rows());
+  const auto count = static_cast<int>(state.operations() / (100 * csv.Cols()));
+  Cells cells;
+  state.measure([&]() {
+    for (int i = 0; i < count; i++) {
+      const auto min = (i * 100) % (rows - 100);
+      cells.Set(min, min + 99, cols, [&](auto& text, int row, int col) noexcept { csv.Format(text, row, col); });
+    }
+  });
+}
+
+BENCHMARK("csv/fill/rows:100/cols:4", 4'000'000, csv_fill);
+
+}  // namespace
@@ -0,0 +1,109 @@
+#include "bench.hpp"
+#include <filter.hpp>
+#include <fmt/format.h>
+#include <random>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t rows = 1'000'000;
+
+struct Sample {
+  std::vector<std::int64_t> integers;
+  std::vector<double> doubles;
+  std::vector<std::wstring> names;
+};
+
+const Sample& sample() {
+  static const auto sample = []() {
+    constexpr std::wstring_view words[] = { L"Alpha", L"Bravo", L"Charlie", L"Delta", L"Echo", L"Foxtrot", L"Golf", L"Hotel" };
+    Sample sample;
+    std::mt19937_64 random{ 0 };
+    for (std::size_t row = 0; row < rows; row++) {
+      sample.integers.push_back(static_cast<std::int64_t>(random() % 1'000'000));
+      sample.doubles.push_back(static_cast<double>(random() % 1'000'000) / 100.0);
+      sample.names.push_back(fmt::format(L"{} {} {}", words[random() % std::size(words)], words[random() % std::size(words)], random() % 100'000));
+    }
+    return sample;
+  }();
+  return sample;
+}
+
+Predicate parse(std::wstring_view text) {
+  Predicate predicate;
+  Predicate::Parse(0, text, predicate);
+  return predicate;
+}
+
+std::vector<std::uint32_t> run(Selector& selector, const Permutation& order, const std::vector<std::uint32_t>* input) {
+  const std::stop_source stop;
+  selector.Start(order, rows, input, 4);
+  for (std::size_t job = 0; job < selector.Jobs(); job++) {
+    selector.Run(job, stop.get_token());
+  }
+  return selector.Result();
+}
+
+// Selects a tenth of the rows by a range of doubles. One operation is one row.
+void filter_doubles(bench::state& state) {
+  const auto& values = sample().doubles;
+  const auto predicate = parse(L"1000..2000");
+  const Permutation order;
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += rows) {
+      Selector selector;
+      selector.Add(Selector::Doubles(predicate, values));
+      auto positions = run(selector, order, nullptr);
+      bench::do_not_optimize(positions);
+    }
+  });
+}
+
+// Selects a tenth of the rows by a range of integers. One operation is one row.
+void filter_integers(bench::state& state) {
+  const auto& values = sample().integers;
+  const auto predicate = parse(L"100000..199999");
+  const Permutation order;
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += rows) {
+      Selector selector;
+      selector.Add(Selector::Integers(predicate, values));
+      auto positions = run(selector, order, nullptr);
+      bench::do_not_optimize(positions);
+    }
+  });
+}
+
+const auto text = [](fmt::wmemory_buffer& buffer, std::size_t row) noexcept {
+  const auto& name = sample().names[row];
+  buffer.append(name.data(), name.data() + name.size());
+};
+
+// Selects rows whose text contains "echo", then refines the selection with "echo g". One operation is one row.
+void filter_texts(bench::state& state, bool refine) {
+  sample();
+  const auto broad = parse(L"echo");
+  const auto narrow = parse(L"echo g");
+  const Permutation order;
+  Selector first;
+  first.Add(Selector::Texts(broad, text));
+  const auto selection = run(first, order, nullptr);
+  state.counter("selected", static_cast<double>(selection.size()) / rows);
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += rows) {
+      Selector selector;
+      selector.Add(Selector::Texts(narrow, text));
+      auto positions = run(selector, order, refine ? &selection : nullptr);
+      bench::do_not_optimize(positions);
+    }
+  });
+}
+
+BENCHMARK("filter/doubles/rows:1000000", 20'000'000, filter_doubles);
+BENCHMARK("filter/integers/rows:1000000", 20'000'000, filter_integers);
+BENCHMARK("filter/texts/scan", 2'000'000, [](bench::state& state) { filter_texts(state, false); });
+BENCHMARK("filter/texts/refine", 2'000'000, [](bench::state& state) { filter_texts(state, true); });
+
+}  // namespace
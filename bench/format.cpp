@@ -0,0 +1,121 @@
+#include "bench.hpp"
+#include <format.hpp>
+#include <fmt/format.h>
+#include <chrono>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Runs callback(text, i) for every operation and clears the buffer every 1024 operations.
+template <typename Callback>
+void run(bench::state& state, Callback callback) {
+  fmt::wmemory_buffer text;
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      if ((i & 1023) == 0) {
+        text.clear();
+      }
+      callback(text, i);
+      text.push_back(L'\0');
+    }
+    bench::do_not_optimize(text);
+  });
+}
+
+const std::vector<std::int64_t>& integers() {
+  static const auto values = []() {
+    std::vector<std::int64_t> values(4096);
+    std::mt19937_64 random{ 0 };
+    for (auto& value : values) {
+      value = static_cast<std::int64_t>(random() % 10'000'000'000);
+    }
+    return values;
+  }();
+  return values;
+}
+
+// Formats a cell with the format string of the cache hint lambda.
+void format_cell_fmt(bench::state& state) {
+  run(state, [](auto& text, std::uint64_t i) noexcept {
+    fmt::format_to(std::back_inserter(text), L"{:09}:{:02}", static_cast<int>(i % 1'000'000'000), static_cast<int>(i % 10));
+  });
+}
+
+// Formats the same cell with the compile time formatters.
+void format_cell(bench::state& state) {
+  run(state, [](auto& text, std::uint64_t i) noexcept {
+    AppendInteger<9>(text, static_cast<int>(i % 1'000'000'000));
+    text.push_back(L':');
+    AppendInteger<2>(text, static_cast<int>(i % 10));
+  });
+}
+
+void format_int64_fmt(bench::state& state) {
+  const auto& values = integers();
+  run(state, [&](auto& text, std::uint64_t i) noexcept { fmt::format_to(std::back_inserter(text), L"{}", values[i & 4095]); });
+}
+
+void format_int64(bench::state& state) {
+  const auto& values = integers();
+  run(state, [&](auto& text, std::uint64_t i) noexcept { AppendInteger(text, values[i & 4095]); });
+}
+
+void format_decimal_fmt(bench::state& state) {
+  const auto& values = integers();
+  run(state, [&](auto& text, std::uint64_t i) noexcept {
+    fmt::format_to(std::back_inserter(text), L"{:.2f}", static_cast<double>(values[i & 4095]) / 1000.0);
+  });
+}
+
+void format_decimal(bench::state& state) {
+  const auto& values = integers();
+  run(state, [&](auto& text, std::uint64_t i) noexcept { AppendDecimal<2>(text, static_cast<double>(values[i & 4095]) / 1000.0); });
+}
+
+void format_timestamp_fmt(bench::state& state) {
+  const auto& values = integers();
+  run(state, [&](auto& text, std::uint64_t i) noexcept {
+    using namespace std::chrono;
+    const sys_time<microseconds> time{ microseconds{ values[i & 4095] * 1'000'000 } };
+    const auto days = floor<std::chrono::days>(time);
+    const year_month_day date{ days };
+    const hh_mm_ss clock{ floor<seconds>(time - days) };
+    fmt::format_to(std::back_inserter(text), L"{:04}-{:02}-{:02} {:02}:{:02}:{:02}",
+      static_cast<int>(date.year()), static_cast<unsigned>(date.month()), static_cast<unsigned>(date.day()),
+      clock.hours().count(), clock.minutes().count(), clock.seconds().count());
+  });
+}
+
+void format_timestamp(bench::state& state) {
+  const auto& values = integers();
+  run(state, [&](auto& text, std::uint64_t i) noexcept { AppendTimestamp(text, values[i & 4095] * 1'000'000); });
+}
+
+// Converts 48 byte strings. One operation is one string.
+void format_text(bench::state& state, bool utf8) {
+  constexpr std::string_view ascii = "Name 123, \"quoted\" text of a typical cell value";
+  constexpr std::string_view latin = "Caf\xE9 \x80 123, \x93quoted\x94 text of a typical cell value";
+  run(state, [&](auto& text, std::uint64_t) noexcept {
+    if (utf8) {
+      AppendUtf16(text, ascii);
+    } else {
+      AppendWindows1252(text, latin);
+    }
+  });
+}
+
+BENCHMARK("format/cell/fmt", 10'000'000, format_cell_fmt);
+BENCHMARK("format/cell", 10'000'000, format_cell);
+BENCHMARK("format/int64/fmt", 10'000'000, format_int64_fmt);
+BENCHMARK("format/int64", 10'000'000, format_int64);
+BENCHMARK("format/decimal/fmt", 10'000'000, format_decimal_fmt);
+BENCHMARK("format/decimal", 10'000'000, format_decimal);
+BENCHMARK("format/timestamp/fmt", 10'000'000, format_timestamp_fmt);
+BENCHMARK("format/timestamp", 10'000'000, format_timestamp);
+BENCHMARK("format/utf8", 10'000'000, [](bench::state& state) { format_text(state, true); });
+BENCHMARK("format/windows1252", 10'000'000, [](bench::state& state) { format_text(state, false); });
+
+}  // namespace
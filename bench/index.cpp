@@ -0,0 +1,84 @@
+#include "bench.hpp"
+#include <index.hpp>
+#include <text.hpp>
+#include <fmt/format.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t rows = 1'000'000;
+
+// Creates names that share long prefixes, like the text of a key column.
+const std::vector<std::string>& sample() {
+  static const auto names = []() {
+    constexpr std::string_view words[] = { "Alpha", "Bravo", "Charlie", "Delta", "Echo", "Foxtrot", "Golf", "Hotel" };
+    std::vector<std::string> names(rows);
+    std::mt19937_64 random{ 0 };
+    for (auto& name : names) {
+      name = fmt::format("{} {} {}", words[random() % std::size(words)], words[random() % std::size(words)], random() % 100'000);
+    }
+    return names;
+  }();
+  return names;
+}
+
+const auto text = [](auto& buffer, std::size_t row) noexcept {
+  AppendUtf16(buffer, sample()[row]);
+};
+
+// Sorts all rows in one run. One operation is one row.
+void index_sort(bench::state& state) {
+  sample();
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += rows) {
+      auto run = Index::Sort(0, rows, text);
+      bench::do_not_optimize(run);
+    }
+  });
+}
+
+// Adds rows in batches of 64k, like a file that is indexed while it loads. One operation is one row.
+void index_append(bench::state& state) {
+  sample();
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += rows) {
+      Index index;
+      for (std::size_t begin = 0; begin < rows; begin += 65536) {
+        index.Add(Index::Sort(begin, std::min(rows, begin + 65536), text), text);
+      }
+      bench::do_not_optimize(index);
+    }
+  });
+}
+
+// Looks up prefixes of different lengths.
+void index_find(bench::state& state) {
+  Index index;
+  for (std::size_t begin = 0; begin < rows; begin += 65536) {
+    index.Add(Index::Sort(begin, std::min(rows, begin + 65536), text), text);
+  }
+  std::vector<std::wstring> prefixes;
+  std::mt19937_64 random{ 1 };
+  for (std::size_t i = 0; i < 1024; i++) {
+    std::wstring prefix;
+    const auto& name = sample()[random() % rows];
+    AppendUtf16(prefix, std::string_view{ name }.substr(0, 1 + random() % name.size()));
+    prefixes.push_back(std::move(prefix));
+  }
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      const auto start = static_cast<int>((i * 7919) % rows);
+      auto row = index.Find(prefixes[i % prefixes.size()], start, start - 1, true, text);
+      bench::do_not_optimize(row);
+    }
+  });
+}
+
+BENCHMARK("index/sort/rows:1000000", 2'000'000, index_sort);
+BENCHMARK("index/append/rows:1000000", 2'000'000, index_append);
+BENCHMARK("index/find/rows:1000000", 100'000, index_find);
+
+}  // namespace
@@ -0,0 +1,120 @@
+#include "bench.hpp"
+#include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdlib>
+
+// Runs the registered benchmarks and writes one JSON object per benchmark and line to stdout.
+//
+// carta-bench [--list] [--repetitions=5] [--scale=1.0] [filter...]
+//
+// A benchmark runs if its name contains any of the filters. Each benchmark runs once with a
+// tenth of its operations for warmup and then the given number of repetitions. The reported
+// ns_per_op and counters are medians of all repetitions.
+
+namespace {
+
+struct options {
+  bool list = false;
+  int repetitions = 5;
+  double scale = 1.0;
+  std::vector<std::string_view> filters;
+};
+
+bool parse(int argc, char* argv[], options& options) {
+  for (int i = 1; i < argc; i++) {
+    const std::string_view arg{ argv[i] };
+    if (arg == "--list") {
+      options.list = true;
+    } else if (arg.starts_with("--repetitions=")) {
+      options.repetitions = std::atoi(argv[i] + 14);
+    } else if (arg.starts_with("--scale=")) {
+      options.scale = std::atof(argv[i] + 8);
+    } else if (arg.starts_with("--")) {
+      return false;
+    } else {
+      options.filters.push_back(arg);
+    }
+  }
+  return options.repetitions > 0 && options.scale > 0.0;
+}
+
+bool selected(const options& options, std::string_view name) {
+  if (options.filters.empty()) {
+    return true;
+  }
+  return std::any_of(options.filters.begin(), options.filters.end(), [&](std::string_view filter) {
+    return name.find(filter) != std::string_view::npos;
+  });
+}
+
+double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  const auto size = values.size();
+  return size % 2 ? values[size / 2] : (values[size / 2 - 1] + values[size / 2]) / 2.0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  options options;
+  if (!parse(argc, argv, options)) {
+    std::fputs("usage: carta-bench [--list] [--repetitions=5] [--scale=1.0] [filter...]\n", stderr);
+    return EXIT_FAILURE;
+  }
+
+  auto benchmarks = bench::registry();
+  std::stable_sort(benchmarks.begin(), benchmarks.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.name < rhs.name;
+  });
+
+  for (const auto& benchmark : benchmarks) {
+    if (!selected(options, benchmark.name)) {
+      continue;
+    }
+    if (options.list) {
+      fmt::print("{}\n", benchmark.name);
+      continue;
+    }
+    const auto operations = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(static_cast<double>(benchmark.operations) * options.scale));
+    {
+      bench::state warmup{ std::max<std::uint64_t>(1, operations / 10) };
+      benchmark.function(warmup);
+    }
+    std::vector<double> durations;
+    std::map<std::string, std::vector<double>> counters;
+    for (int i = 0; i < options.repetitions; i++) {
+      bench::state state{ operations };
+      benchmark.function(state);
+      const auto elapsed = std::chrono::duration<double, std::nano>(state.elapsed()).count();
+      durations.push_back(elapsed / static_cast<double>(operations));
+      for (const auto& [name, value] : state.counters()) {
+        counters[name].push_back(value);
+      }
+    }
+    const auto ns_per_op = median(durations);
+    const auto [min, max] = std::minmax_element(durations.begin(), durations.end());
+    std::string line = fmt::format(
+      R"({{"name":"{}","operations":{},"repetitions":{},"ns_per_op":{:.3f},"ns_per_op_min":{:.3f},"ns_per_op_max":{:.3f},"ops_per_second":{:.0f})",
+      benchmark.name, operations, options.repetitions, ns_per_op, *min, *max, ns_per_op > 0.0 ? 1e9 / ns_per_op : 0.0);
+    if (!counters.empty()) {
+      line += R"(,"counters":{)";
+      auto first = true;
+      for (const auto& [name, values] : counters) {
+        line += fmt::format(R"({}"{}":{:.3f})", first ? "" : ",", name, median(values));
+        first = false;
+      }
+      line += '}';
+    }
+    line += "}\n";
+    std::fputs(line.data(), stdout);
+    std::fflush(stdout);
+    fmt::print(stderr, "{:<48} {:>12.2f} ns/op\n", benchmark.name, ns_per_op);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,339 @@
+#include "bench.hpp"
+#include <ice/context.hpp>
+#include <ice/coroutine.hpp>
+#include <ice/pool.hpp>
+#include <ice/queue.hpp>
+#include <ice/scheduler.hpp>
+#include <ice/task.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+// Scheduler with a mutex, a condition variable and a queue of coroutine handles.
+class baseline_context {
+public:
+  void run() noexcept {
+    while (true) {
+      std::unique_lock lock{ mutex_ };
+      cv_.wait(lock, [this]() { return !queue_.empty() || stop_; });
+      if (queue_.empty()) {
+        return;
+      }
+      const auto awaiter = queue_.front();
+      queue_.pop_front();
+      lock.unlock();
+      awaiter.resume();
+    }
+  }
+
+  void stop() noexcept {
+    {
+      std::lock_guard lock{ mutex_ };
+      stop_ = true;
+    }
+    cv_.notify_one();
+  }
+
+  auto schedule() noexcept {
+    struct awaitable {
+      constexpr bool await_ready() const noexcept {
+        return false;
+      }
+
+      void await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+        context.post(awaiter);
+      }
+
+      constexpr void await_resume() const noexcept {
+      }
+
+      baseline_context& context;
+    };
+    return awaitable{ *this };
+  }
+
+  void post(ice::coroutine_handle<> awaiter) noexcept {
+    {
+      std::lock_guard lock{ mutex_ };
+      queue_.push_back(awaiter);
+    }
+    cv_.notify_one();
+  }
+
+private:
+  bool stop_ = false;
+  std::deque<ice::coroutine_handle<>> queue_;
+  std::condition_variable cv_;
+  std::mutex mutex_;
+};
+
+class baseline_thread {
+public:
+  baseline_thread() : thread_([this]() { context_.run(); }) {
+  }
+
+  ~baseline_thread() {
+    context_.stop();
+    thread_.join();
+  }
+
+  baseline_context& operator*() noexcept {
+    return context_;
+  }
+
+private:
+  baseline_context context_;
+  std::thread thread_;
+};
+
+ice::task<void> hop(ice::context& context, std::uint64_t count, std::latch& done) {
+  co_await context.schedule(true);
+  for (std::uint64_t i = 0; i < count; i++) {
+    co_await context.schedule(true);
+  }
+  done.count_down();
+}
+
+ice::task<void> hop(baseline_context& context, std::uint64_t count, std::latch& done) {
+  co_await context.schedule();
+  for (std::uint64_t i = 0; i < count; i++) {
+    co_await context.schedule();
+  }
+  done.count_down();
+}
+
+template <typename Context>
+ice::task<void> ping_pong(Context& a, Context& b, std::uint64_t count, std::latch& done) {
+  for (std::uint64_t i = 0; i < count; i += 2) {
+    if constexpr (std::is_same_v<Context, ice::context>) {
+      co_await a.schedule(true);
+      co_await b.schedule(true);
+    } else {
+      co_await a.schedule();
+      co_await b.schedule();
+    }
+  }
+  done.count_down();
+}
+
+// Posts and resumes a coroutine on the context thread.
+template <typename Thread>
+void post_self(bench::state& state) {
+  std::latch done{ 1 };
+  Thread thread;
+  state.measure([&]() {
+    hop(*thread, state.operations(), done).detach();
+    done.wait();
+  });
+}
+
+// Moves a coroutine back and forth between two context threads.
+template <typename Thread>
+void post_remote(bench::state& state) {
+  std::latch done{ 1 };
+  Thread a;
+  Thread b;
+  state.measure([&]() {
+    ping_pong(*a, *b, state.operations(), done).detach();
+    done.wait();
+  });
+}
+
+BENCHMARK("context/post/self", 2'000'000, post_self<bench::context_thread>);
+BENCHMARK("context/post/remote", 200'000, post_remote<bench::context_thread>);
+BENCHMARK("baseline/post/self", 2'000'000, post_self<baseline_thread>);
+BENCHMARK("baseline/post/remote", 200'000, post_remote<baseline_thread>);
+
+ice::task<void> fan_out(ice::pool& pool, std::latch& done) {
+  co_await pool.schedule(true);
+  bench::spin(std::chrono::nanoseconds(200));
+  done.count_down();
+}
+
+// Distributes short coroutines over a pool with the given number of threads.
+void pool_fan_out(bench::state& state, std::size_t threads) {
+  std::latch done{ static_cast<std::ptrdiff_t>(state.operations()) };
+  ice::pool pool{ threads };
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      fan_out(pool, done).detach();
+    }
+    done.wait();
+  });
+}
+
+BENCHMARK("pool/fan_out/threads:1", 200'000, [](bench::state& state) { pool_fan_out(state, 1); });
+BENCHMARK("pool/fan_out/threads:2", 200'000, [](bench::state& state) { pool_fan_out(state, 2); });
+BENCHMARK("pool/fan_out/threads:4", 200'000, [](bench::state& state) { pool_fan_out(state, 4); });
+BENCHMARK("pool/fan_out/threads:8", 200'000, [](bench::state& state) { pool_fan_out(state, 8); });
+
+ice::task<void> fan_out(ice::batch<ice::pool>& batch, std::latch& done) {
+  co_await batch.schedule();
+  bench::spin(std::chrono::nanoseconds(200));
+  done.count_down();
+}
+
+// Distributes short coroutines over a pool in batches that are posted with a single operation.
+void pool_fan_out_batch(bench::state& state, std::size_t threads, std::size_t size) {
+  std::latch done{ static_cast<std::ptrdiff_t>(state.operations()) };
+  ice::pool pool{ threads };
+  state.measure([&]() {
+    ice::batch batch{ pool };
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      fan_out(batch, done).detach();
+      if (batch.size() == size) {
+        batch.post();
+      }
+    }
+    batch.post();
+    done.wait();
+  });
+}
+
+BENCHMARK("pool/fan_out/threads:1/batch:64", 200'000, [](bench::state& state) { pool_fan_out_batch(state, 1, 64); });
+BENCHMARK("pool/fan_out/threads:4/batch:64", 200'000, [](bench::state& state) { pool_fan_out_batch(state, 4, 64); });
+
+ice::task<void> hop(ice::batch<ice::context>& batch, std::latch& done) {
+  co_await batch.schedule();
+  done.count_down();
+}
+
+// Posts coroutines to a context thread one at a time or in batches of the given size.
+void context_post_batch(bench::state& state, std::size_t size) {
+  std::latch done{ static_cast<std::ptrdiff_t>(state.operations()) };
+  bench::context_thread thread;
+  state.measure([&]() {
+    ice::batch batch{ *thread };
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      hop(batch, done).detach();
+      if (batch.size() == size) {
+        batch.post();
+      }
+    }
+    batch.post();
+    done.wait();
+  });
+}
+
+BENCHMARK("context/post_batch/size:1", 1'000'000, [](bench::state& state) { context_post_batch(state, 1); });
+BENCHMARK("context/post_batch/size:64", 1'000'000, [](bench::state& state) { context_post_batch(state, 64); });
+
+template <typename Scheduler>
+ice::task<void> bulk_load(Scheduler& scheduler, const std::atomic_bool& stop, std::latch& done) {
+  while (!stop.load(std::memory_order_relaxed)) {
+    co_await scheduler.schedule(ice::priority::bulk, true);
+    bench::spin(std::chrono::microseconds(2));
+  }
+  done.count_down();
+}
+
+template <typename Scheduler>
+ice::task<void> probe(ice::context& source, Scheduler& target, ice::priority priority, std::vector<double>& samples, std::latch& done) {
+  for (auto& sample : samples) {
+    co_await source.schedule(true);
+    const auto start = bench::clock::now();
+    co_await target.schedule(priority, true);
+    sample = std::chrono::duration<double, std::nano>(bench::clock::now() - start).count();
+  }
+  done.count_down();
+}
+
+// Measures the time it takes to switch to a context that is busy with bulk work.
+void latency_under_load(bench::state& state, ice::priority priority) {
+  constexpr std::size_t load = 64;
+  std::atomic_bool stop = false;
+  std::latch stopped{ load };
+  std::latch done{ 1 };
+  std::vector<double> samples(state.operations());
+  bench::context_thread source;
+  bench::context_thread target;
+  for (std::size_t i = 0; i < load; i++) {
+    bulk_load(*target, stop, stopped).detach();
+  }
+  state.measure([&]() {
+    probe(*source, *target, priority, samples, done).detach();
+    done.wait();
+  });
+  stop.store(true, std::memory_order_relaxed);
+  stopped.wait();
+  state.counter("p50_ns", bench::percentile(samples, 50));
+  state.counter("p99_ns", bench::percentile(samples, 99));
+}
+
+BENCHMARK("context/latency_under_load/interactive", 2'000, [](bench::state& state) { latency_under_load(state, ice::priority::interactive); });
+BENCHMARK("context/latency_under_load/bulk", 2'000, [](bench::state& state) { latency_under_load(state, ice::priority::bulk); });
+
+// Measures the time it takes to switch to a pool thread that is busy with bulk work, which the
+// workers repost to the shared bulk lane of the pool.
+void pool_latency_under_load(bench::state& state, ice::priority priority) {
+  constexpr std::size_t load = 64;
+  std::atomic_bool stop = false;
+  std::latch stopped{ load };
+  std::latch done{ 1 };
+  std::vector<double> samples(state.operations());
+  bench::context_thread source;
+  ice::pool target{ 1 };
+  for (std::size_t i = 0; i < load; i++) {
+    bulk_load(target, stop, stopped).detach();
+  }
+  state.measure([&]() {
+    probe(*source, target, priority, samples, done).detach();
+    done.wait();
+  });
+  stop.store(true, std::memory_order_relaxed);
+  stopped.wait();
+  state.counter("p50_ns", bench::percentile(samples, 50));
+  state.counter("p99_ns", bench::percentile(samples, 99));
+}
+
+BENCHMARK("pool/latency_under_load/interactive", 2'000, [](bench::state& state) { pool_latency_under_load(state, ice::priority::interactive); });
+BENCHMARK("pool/latency_under_load/normal", 2'000, [](bench::state& state) { pool_latency_under_load(state, ice::priority::normal); });
+BENCHMARK("pool/latency_under_load/bulk", 2'000, [](bench::state& state) { pool_latency_under_load(state, ice::priority::bulk); });
+
+struct node : ice::detail::queue_node {};
+
+// Pushes nodes from several producer threads and pops them on the current thread.
+template <typename Queue>
+void queue_producers(bench::state& state, std::size_t producers) {
+  const auto count = state.operations() / producers;
+  const auto nodes = std::make_unique<node[]>(count * producers);
+  Queue queue;
+  std::latch start{ 1 };
+  std::vector<std::thread> threads;
+  for (std::size_t i = 0; i < producers; i++) {
+    threads.emplace_back([&, i]() {
+      start.wait();
+      for (std::size_t j = 0; j < count; j++) {
+        queue.push(&nodes[i * count + j]);
+      }
+    });
+  }
+  state.measure([&]() {
+    start.count_down();
+    for (std::size_t popped = 0; popped < count * producers;) {
+      if (queue.pop()) {
+        popped++;
+      }
+    }
+  });
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+BENCHMARK("queue/mpsc/producers:1", 2'000'000, [](bench::state& state) { queue_producers<ice::mpsc_queue>(state, 1); });
+BENCHMARK("queue/mpsc/producers:4", 2'000'000, [](bench::state& state) { queue_producers<ice::mpsc_queue>(state, 4); });
+BENCHMARK("queue/mpsc/producers:16", 2'000'000, [](bench::state& state) { queue_producers<ice::mpsc_queue>(state, 16); });
+BENCHMARK("queue/stack/producers:1", 2'000'000, [](bench::state& state) { queue_producers<ice::stack_queue>(state, 1); });
+BENCHMARK("queue/stack/producers:4", 2'000'000, [](bench::state& state) { queue_producers<ice::stack_queue>(state, 4); });
+BENCHMARK("queue/stack/producers:16", 2'000'000, [](bench::state& state) { queue_producers<ice::stack_queue>(state, 16); });
+
+}  // namespace
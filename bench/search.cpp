@@ -0,0 +1,85 @@
+#include "bench.hpp"
+#include <search.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t rows = 1'000'000;
+
+// Lines of a file with three fields.
+struct Sample {
+  std::string data;
+  std::vector<std::size_t> offsets;
+};
+
+const Sample& sample() {
+  static const auto sample = []() {
+    constexpr std::string_view words[] = { "Alpha", "Bravo", "Charlie", "Delta", "Echo", "Foxtrot", "Golf", "Hotel" };
+    Sample sample;
+    std::mt19937_64 random{ 0 };
+    for (std::size_t row = 0; row < rows; row++) {
+      sample.offsets.push_back(sample.data.size());
+      fmt::format_to(std::back_inserter(sample.data), "{},{} {},{}\r\n", row, words[random() % std::size(words)],
+        words[random() % std::size(words)], random() % 100'000);
+    }
+    sample.offsets.push_back(sample.data.size());
+    return sample;
+  }();
+  return sample;
+}
+
+std::string_view line(std::size_t row) noexcept {
+  const auto& data = sample();
+  const auto begin = data.offsets[row];
+  return std::string_view{ data.data }.substr(begin, data.offsets[row + 1] - begin - 2);
+}
+
+// Counts the matches of a rare pattern in all bytes. One operation is one byte.
+void search_bytes(bench::state& state, std::wstring_view text) {
+  const std::string_view data = sample().data;
+  Needle needle;
+  Needle::Create(text, {}, needle);
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += data.size()) {
+      std::size_t count = 0;
+      for (auto pos = needle.Find(data); pos != Needle::npos; pos = needle.Find(data, pos + 1)) {
+        count++;
+      }
+      bench::do_not_optimize(count);
+    }
+  });
+}
+
+// Selects the rows that contain a pattern through the search kernel. One operation is one row.
+void search_rows(bench::state& state, bool contiguous) {
+  sample();
+  Needle needle;
+  Needle::Create(L"golf golf 99", {}, needle);
+  const auto kernel = SearchRows(needle, line);
+  std::vector<std::uint32_t> block(Selector::block);
+  std::vector<std::uint32_t> positions(Selector::block);
+  state.measure([&]() {
+    std::size_t count = 0;
+    for (std::uint64_t i = 0; i < state.operations(); i += Selector::block) {
+      const auto begin = i % (rows - Selector::block);
+      for (std::size_t j = 0; j < Selector::block; j++) {
+        block[j] = static_cast<std::uint32_t>(begin + j);
+        positions[j] = block[j];
+      }
+      count += kernel(block.data(), positions.data(), block.size(), contiguous);
+    }
+    bench::do_not_optimize(count);
+  });
+}
+
+BENCHMARK("search/bytes/rare", 200'000'000, [](bench::state& state) { search_bytes(state, L"golf golf 99"); });
+BENCHMARK("search/bytes/common", 200'000'000, [](bench::state& state) { search_bytes(state, L"echo"); });
+BENCHMARK("search/rows/contiguous", 4'000'000, [](bench::state& state) { search_rows(state, true); });
+BENCHMARK("search/rows/scattered", 4'000'000, [](bench::state& state) { search_rows(state, false); });
+
+}  // namespace
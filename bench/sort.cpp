@@ -0,0 +1,81 @@
+#include "bench.hpp"
+#include <sort.hpp>
+#include <fmt/format.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t rows = 1'000'000;
+
+const std::vector<std::int64_t>& integers() {
+  static const auto values = []() {
+    std::vector<std::int64_t> values(rows);
+    std::mt19937_64 random{ 0 };
+    std::int64_t timestamp = 1'577'836'800'000'000;
+    for (auto& value : values) {
+      timestamp += static_cast<std::int64_t>(random() % 60'000'000);
+      value = static_cast<std::int64_t>(random() % 2) ? timestamp : -timestamp;
+    }
+    return values;
+  }();
+  return values;
+}
+
+const std::vector<std::string>& strings() {
+  static const auto values = []() {
+    constexpr std::string_view words[] = { "Alpha", "Bravo", "Charlie", "Delta", "Echo", "Foxtrot", "Golf", "Hotel" };
+    std::vector<std::string> values(rows);
+    std::mt19937_64 random{ 0 };
+    for (auto& value : values) {
+      value = fmt::format("{} {} {}", words[random() % std::size(words)], words[random() % std::size(words)], random() % 100'000);
+    }
+    return values;
+  }();
+  return values;
+}
+
+// Runs the jobs of every step one after another, which measures the work without the scheduler.
+Permutation run(Sorter& sorter) {
+  do {
+    for (std::size_t job = 0; job < sorter.Jobs(); job++) {
+      sorter.Run(job);
+    }
+  } while (sorter.Next());
+  return sorter.Result();
+}
+
+// Sorts timestamps with a radix sort. One operation is one row.
+void sort_integers(bench::state& state, std::size_t jobs) {
+  const auto& values = integers();
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += rows) {
+      Sorter sorter;
+      sorter.Integers(rows, jobs, false, [&](std::size_t row) noexcept { return Sorter::Key(values[row]); });
+      auto permutation = run(sorter);
+      bench::do_not_optimize(permutation);
+    }
+  });
+}
+
+// Sorts text with a merge sort. One operation is one row.
+void sort_strings(bench::state& state, std::size_t jobs) {
+  const auto& values = strings();
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i += rows) {
+      Sorter sorter;
+      sorter.Strings(rows, jobs, false, [&](std::size_t row) noexcept { return std::string_view{ values[row] }; });
+      auto permutation = run(sorter);
+      bench::do_not_optimize(permutation);
+    }
+  });
+}
+
+BENCHMARK("sort/integers/jobs:1", 4'000'000, [](bench::state& state) { sort_integers(state, 1); });
+BENCHMARK("sort/integers/jobs:4", 4'000'000, [](bench::state& state) { sort_integers(state, 4); });
+BENCHMARK("sort/strings/jobs:1", 2'000'000, [](bench::state& state) { sort_strings(state, 1); });
+BENCHMARK("sort/strings/jobs:4", 2'000'000, [](bench::state& state) { sort_strings(state, 4); });
+
+}  // namespace
@@ -0,0 +1,66 @@
+#include "bench.hpp"
+#include <cells.hpp>
+#include <store.hpp>
+#include <random>
+#include <string_view>
+
+namespace {
+
+constexpr std::size_t rows = 1'000'000;
+
+// Creates a store with one column of every type.
+const Store& sample() noexcept {
+  static const Store store = []() {
+    Store store;
+    auto& id = store.AddColumn(L"Id", ColumnType::Int64);
+    auto& time = store.AddColumn(L"Time", ColumnType::Timestamp);
+    auto& name = store.AddColumn(L"Name", ColumnType::String);
+    auto& value = store.AddColumn(L"Value", ColumnType::Double, 2);
+    constexpr std::string_view names[] = { "Alpha", "Bravo", "Charlie", "Delta", "Echo", "Foxtrot", "Golf", "Hotel" };
+    std::mt19937_64 random{ 0 };
+    std::int64_t timestamp = 1'577'836'800'000'000;
+    for (std::size_t row = 0; row < rows; row++) {
+      timestamp += static_cast<std::int64_t>(random() % 60'000'000);
+      id.Append(static_cast<std::int64_t>(row));
+      time.Append(timestamp);
+      name.Append(names[random() % std::size(names)]);
+      value.Append(static_cast<double>(random() % 1'000'000) / 100.0);
+    }
+    return store;
+  }();
+  return store;
+}
+
+// Formats windows of 100 rows from the store into cells.
+void store_fill(bench::state& state) {
+  const auto& store = sample();
+  const auto cols = static_cast<int>(store.Cols());
+  const auto count = static_cast<int>(state.operations() / (100 * store.Cols()));
+  Cells cells;
+  state.measure([&]() {
+    for (int i = 0; i < count; i++) {
+      const auto min = (i * 100) % static_cast<int>(rows - 100);
+      cells.Set(min, min + 99, cols, [&](auto& text, int row, int col) noexcept { store.Format(text, row, col); });
+    }
+  });
+}
+
+// Sums an Int64 column.
+void store_scan(bench::state& state) {
+  const auto& store = sample();
+  const auto values = store[0].Integers();
+  state.measure([&]() {
+    std::int64_t sum = 0;
+    for (std::uint64_t i = 0; i < state.operations(); i += values.size()) {
+      for (const auto value : values) {
+        sum += value;
+      }
+    }
+    bench::do_not_optimize(sum);
+  });
+}
+
+BENCHMARK("store/fill/rows:100/cols:4", 4'000'000, store_fill);
+BENCHMARK("store/scan/int64", 100'000'000, store_scan);
+
+}  // namespace
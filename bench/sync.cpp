@@ -0,0 +1,182 @@
+#include "bench.hpp"
+#include <ice/channel.hpp>
+#include <ice/pool.hpp>
+#include <ice/sync.hpp>
+#include <ice/task.hpp>
+#include <array>
+#include <latch>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using channel = ice::channel<std::uint64_t, 64>;
+
+ice::task<void> send(ice::context& context, channel& channel, std::uint64_t count) {
+  co_await context.schedule(true);
+  for (std::uint64_t i = 0; i < count; i++) {
+    co_await channel.send(i, context);
+  }
+  channel.close();
+}
+
+ice::task<void> send_many(ice::context& context, channel& channel, std::uint64_t count) {
+  co_await context.schedule(true);
+  std::array<std::uint64_t, 32> values{};
+  for (std::uint64_t i = 0; i < count; i += values.size()) {
+    co_await channel.send_many(values, context);
+  }
+  channel.close();
+}
+
+ice::task<void> receive(ice::context& context, channel& channel, std::latch& done) {
+  co_await context.schedule(true);
+  std::uint64_t sum = 0;
+  while (const auto value = co_await channel.receive(context)) {
+    sum += *value;
+  }
+  bench::do_not_optimize(sum);
+  done.count_down();
+}
+
+ice::task<void> receive_many(ice::context& context, channel& channel, std::latch& done) {
+  co_await context.schedule(true);
+  std::array<std::uint64_t, 32> values{};
+  std::uint64_t sum = 0;
+  while (const auto size = co_await channel.receive_many(values, context)) {
+    for (std::size_t i = 0; i < size; i++) {
+      sum += values[i];
+    }
+  }
+  bench::do_not_optimize(sum);
+  done.count_down();
+}
+
+// Sends values from one context thread to another.
+template <bool Batch>
+void channel_transfer(bench::state& state) {
+  channel channel;
+  std::latch done{ 1 };
+  bench::context_thread producer;
+  bench::context_thread consumer;
+  state.measure([&]() {
+    if constexpr (Batch) {
+      receive_many(*consumer, channel, done).detach();
+      send_many(*producer, channel, state.operations()).detach();
+    } else {
+      receive(*consumer, channel, done).detach();
+      send(*producer, channel, state.operations()).detach();
+    }
+    done.wait();
+  });
+}
+
+BENCHMARK("channel/transfer/capacity:64", 1'000'000, channel_transfer<false>);
+BENCHMARK("channel/transfer_batch/capacity:64", 4'000'000, channel_transfer<true>);
+
+ice::task<void> increment(ice::pool& pool, ice::async_mutex& mutex, std::uint64_t& counter, std::uint64_t count, std::latch& done) {
+  co_await pool.schedule(true);
+  for (std::uint64_t i = 0; i < count; i++) {
+    const auto lock = co_await mutex.scoped_lock();
+    counter++;
+  }
+  done.count_down();
+}
+
+// Increments a counter from coroutines on a pool with the given number of threads.
+void async_mutex_contended(bench::state& state, std::size_t threads) {
+  ice::async_mutex mutex;
+  std::uint64_t counter = 0;
+  std::latch done{ static_cast<std::ptrdiff_t>(threads) };
+  ice::pool pool{ threads };
+  state.measure([&]() {
+    for (std::size_t i = 0; i < threads; i++) {
+      increment(pool, mutex, counter, state.operations() / threads, done).detach();
+    }
+    done.wait();
+  });
+}
+
+// Increments a counter from the given number of threads.
+void std_mutex_contended(bench::state& state, std::size_t threads) {
+  std::mutex mutex;
+  std::uint64_t counter = 0;
+  std::latch start{ 1 };
+  std::vector<std::thread> workers;
+  for (std::size_t i = 0; i < threads; i++) {
+    workers.emplace_back([&]() {
+      start.wait();
+      for (std::uint64_t i = 0; i < state.operations() / threads; i++) {
+        std::lock_guard lock{ mutex };
+        counter++;
+      }
+    });
+  }
+  state.measure([&]() {
+    start.count_down();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  });
+}
+
+ice::task<void> increment(ice::async_mutex& mutex, std::uint64_t& counter, std::uint64_t count) {
+  for (std::uint64_t i = 0; i < count; i++) {
+    co_await mutex.lock();
+    counter++;
+    mutex.unlock();
+  }
+}
+
+void async_mutex_uncontended(bench::state& state) {
+  ice::async_mutex mutex;
+  std::uint64_t counter = 0;
+  state.measure([&]() {
+    auto task = increment(mutex, counter, state.operations());
+    bench::do_not_optimize(task);
+  });
+}
+
+void std_mutex_uncontended(bench::state& state) {
+  std::mutex mutex;
+  std::uint64_t counter = 0;
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      std::lock_guard lock{ mutex };
+      counter++;
+    }
+  });
+  bench::do_not_optimize(counter);
+}
+
+BENCHMARK("mutex/async/uncontended", 20'000'000, async_mutex_uncontended);
+BENCHMARK("mutex/std/uncontended", 20'000'000, std_mutex_uncontended);
+BENCHMARK("mutex/async/threads:4", 4'000'000, [](bench::state& state) { async_mutex_contended(state, 4); });
+BENCHMARK("mutex/std/threads:4", 4'000'000, [](bench::state& state) { std_mutex_contended(state, 4); });
+
+ice::task<void> limited(ice::pool& pool, ice::async_semaphore& semaphore, std::latch& done) {
+  co_await pool.schedule(true);
+  co_await semaphore.acquire(pool);
+  bench::spin(std::chrono::nanoseconds(500));
+  semaphore.release();
+  done.count_down();
+}
+
+// Limits the number of concurrently running coroutines on a pool.
+void semaphore_limit(bench::state& state) {
+  ice::async_semaphore semaphore{ 2 };
+  std::latch done{ static_cast<std::ptrdiff_t>(state.operations()) };
+  ice::pool pool{ 4 };
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      limited(pool, semaphore, done).detach();
+    }
+    done.wait();
+  });
+}
+
+BENCHMARK("semaphore/limit:2/threads:4", 200'000, semaphore_limit);
+
+}  // namespace
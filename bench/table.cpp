@@ -0,0 +1,126 @@
+#include "bench.hpp"
+#include <cells.hpp>
+#include <prefetcher.hpp>
+#include <fmt/format.h>
+#include <array>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+#include <cstring>
+
+namespace {
+
+constexpr int rows = 100;
+constexpr int cols = 8;
+
+template <typename Buffer>
+void format_cell(Buffer& text, int row, int col) noexcept {
+  fmt::format_to(std::back_inserter(text), L"{:09}:{:02}", row, col);
+}
+
+// Formats the visible rows of a list view like a cache hint would.
+void table_fill(bench::state& state) {
+  Cells cells;
+  const auto count = static_cast<int>(state.operations() / (rows * cols));
+  state.measure([&]() {
+    for (int i = 0; i < count; i++) {
+      cells.Set(i * rows, i * rows + rows - 1, cols, format_cell<fmt::wmemory_buffer>);
+    }
+  });
+}
+
+// Copies random cells of the cached rows to a list view item buffer.
+void table_lookup(bench::state& state) {
+  Cells cells;
+  cells.Set(1000, 1000 + rows - 1, cols, format_cell<fmt::wmemory_buffer>);
+  std::mt19937 random{ 0 };
+  std::uniform_int_distribution<int> row{ 1000, 1000 + rows - 1 };
+  std::uniform_int_distribution<int> col{ 0, cols - 1 };
+  std::vector<std::pair<int, int>> lookups(4096);
+  for (auto& lookup : lookups) {
+    lookup = { row(random), col(random) };
+  }
+  std::array<wchar_t, 260> buffer{};
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      const auto [row, col] = lookups[i % lookups.size()];
+      if (cells.Contains(row)) {
+        const auto text = cells.Get(row, col);
+        const auto size = std::min(text.size(), buffer.size() - 1);
+        std::memcpy(buffer.data(), text.data(), size * sizeof(wchar_t));
+        buffer[size] = L'\0';
+      }
+      bench::do_not_optimize(buffer);
+    }
+  });
+}
+
+// Replays cache hints of a 40 row list view that scrolls by the given number of rows per hint.
+// Rows that stay visible are kept, so the cost per hint follows the rows scrolled.
+void table_scroll(bench::state& state, int step) {
+  constexpr int window = 40;
+  constexpr int total = 10'000'000;
+  Cells cells;
+  std::uint64_t formatted = 0;
+  const auto callback = [&](auto& text, int row, int col) noexcept {
+    formatted++;
+    format_cell(text, row, col);
+  };
+  state.measure([&]() {
+    auto min = 0;
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      min = (min + step) % (total - window);
+      cells.Set(min, min + window - 1, cols, callback);
+    }
+  });
+  state.counter("cells_per_hint", static_cast<double>(formatted) / static_cast<double>(state.operations()));
+}
+
+// Replays cache hints of a list view that scrolls by the given number of rows per hint.
+// Predicted windows are formatted inline here, the application formats them on the pool.
+void table_prefetch(bench::state& state, int step) {
+  constexpr int window = 40;
+  constexpr int total = 10'000'000;
+  Cells current;
+  Cells next;
+  Prefetcher prefetcher;
+  std::mt19937 random{ 0 };
+  state.measure([&]() {
+    auto min = 0;
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      if (random() % 64 == 0) {
+        step = -step;
+      }
+      min = std::clamp(min + step, 0, total - window);
+      const auto max = min + window - 1;
+      // Only hints that leave the current rows count, a hit is served from the prefetched rows.
+      if (!current.Contains(min, max)) {
+        const auto hit = next.Contains(min, max);
+        if (hit) {
+          std::swap(current, next);
+        } else {
+          current.Set(min, max, cols, format_cell<fmt::wmemory_buffer>);
+        }
+        prefetcher.Record(hit);
+      }
+      int next_min = 0;
+      int next_max = 0;
+      const auto contains = [&](int min, int max) noexcept { return current.Contains(min, max) || next.Contains(min, max); };
+      if (prefetcher.Update(min, max, total, contains, next_min, next_max)) {
+        next.Set(next_min, next_max, cols, format_cell<fmt::wmemory_buffer>);
+      }
+    }
+  });
+  const auto hints = static_cast<double>(prefetcher.Hits() + prefetcher.Misses());
+  state.counter("hit_rate", static_cast<double>(prefetcher.Hits()) / hints);
+}
+
+BENCHMARK("table/fill/rows:100/cols:8", 4'000'000, table_fill);
+BENCHMARK("table/scroll/step:1", 1'000'000, [](bench::state& state) { table_scroll(state, 1); });
+BENCHMARK("table/scroll/step:40", 100'000, [](bench::state& state) { table_scroll(state, 40); });
+BENCHMARK("table/prefetch/step:1", 100'000, [](bench::state& state) { table_prefetch(state, 1); });
+BENCHMARK("table/prefetch/step:40", 100'000, [](bench::state& state) { table_prefetch(state, 40); });
+BENCHMARK("table/lookup/rows:100/cols:8", 50'000'000, table_lookup);
+
+}  // namespace
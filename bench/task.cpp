@@ -0,0 +1,155 @@
+#include "bench.hpp"
+#include <ice/allocator.hpp>
+#include <ice/async_generator.hpp>
+#include <ice/generator.hpp>
+#include <ice/task.hpp>
+#include <ice/when_all.hpp>
+#include <array>
+#include <latch>
+#include <new>
+#include <vector>
+
+namespace {
+
+ice::task<std::uint64_t> value(std::uint64_t value) {
+  co_return value;
+}
+
+ice::task<std::uint64_t> create(std::uint64_t count) {
+  std::uint64_t sum = 0;
+  for (std::uint64_t i = 0; i < count; i++) {
+    sum += co_await value(i);
+  }
+  co_return sum;
+}
+
+// Creates, runs and destroys tasks that complete synchronously.
+void task_create(bench::state& state) {
+  state.measure([&]() {
+    auto task = create(state.operations());
+    bench::do_not_optimize(task);
+  });
+}
+
+BENCHMARK("task/create", 5'000'000, task_create);
+
+// Allocates and frees coroutine frame sized blocks with a window of live allocations.
+template <typename Allocate, typename Deallocate>
+void allocate(bench::state& state, std::size_t size, Allocate allocate, Deallocate deallocate) {
+  std::array<void*, 16> blocks{};
+  state.measure([&]() {
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      auto& block = blocks[i % blocks.size()];
+      if (block) {
+        deallocate(block, size);
+      }
+      block = allocate(size);
+      bench::do_not_optimize(block);
+    }
+  });
+  for (const auto block : blocks) {
+    if (block) {
+      deallocate(block, size);
+    }
+  }
+}
+
+void allocate_frame(bench::state& state, std::size_t size) {
+  allocate(
+    state, size, [](std::size_t size) { return ice::detail::frame_allocator::allocate(size); },
+    [](void* block, std::size_t size) { ice::detail::frame_allocator::deallocate(block, size); });
+}
+
+void allocate_new(bench::state& state, std::size_t size) {
+  allocate(
+    state, size, [](std::size_t size) { return ::operator new(size); },
+    [](void* block, std::size_t size) { ::operator delete(block, size); });
+}
+
+BENCHMARK("allocator/frame/size:128", 10'000'000, [](bench::state& state) { allocate_frame(state, 128); });
+BENCHMARK("allocator/frame/size:512", 10'000'000, [](bench::state& state) { allocate_frame(state, 512); });
+BENCHMARK("allocator/new/size:128", 10'000'000, [](bench::state& state) { allocate_new(state, 128); });
+BENCHMARK("allocator/new/size:512", 10'000'000, [](bench::state& state) { allocate_new(state, 512); });
+
+ice::task<int> scheduled(ice::context& context) {
+  co_await context.schedule(true);
+  co_return 1;
+}
+
+ice::task<void> fan_in(ice::context& context, std::uint64_t batches, std::latch& done) {
+  co_await context.schedule(true);
+  for (std::uint64_t i = 0; i < batches; i++) {
+    std::array<ice::task<int>, 16> tasks;
+    for (auto& task : tasks) {
+      task = scheduled(context);
+    }
+    co_await ice::when_all(tasks);
+  }
+  done.count_down();
+}
+
+// Waits for batches of 16 tasks that are resumed by a context.
+void when_all(bench::state& state) {
+  std::latch done{ 1 };
+  bench::context_thread context;
+  state.measure([&]() {
+    fan_in(*context, state.operations() / 16, done).detach();
+    done.wait();
+  });
+}
+
+BENCHMARK("task/when_all/tasks:16", 1'600'000, when_all);
+
+ice::generator<std::uint64_t> sequence(std::uint64_t count) {
+  for (std::uint64_t i = 0; i < count; i++) {
+    co_yield i;
+  }
+}
+
+ice::async_generator<std::uint64_t> async_sequence(std::uint64_t count) {
+  for (std::uint64_t i = 0; i < count; i++) {
+    co_yield i;
+  }
+}
+
+ice::task<std::uint64_t> async_sum(std::uint64_t count) {
+  std::uint64_t sum = 0;
+  auto generator = async_sequence(count);
+  while (const auto value = co_await generator.next()) {
+    sum += *value;
+  }
+  co_return sum;
+}
+
+void generator_loop(bench::state& state) {
+  state.measure([&]() {
+    std::uint64_t sum = 0;
+    for (std::uint64_t i = 0; i < state.operations(); i++) {
+      sum += i;
+      bench::do_not_optimize(sum);
+    }
+  });
+}
+
+void generator_sync(bench::state& state) {
+  state.measure([&]() {
+    std::uint64_t sum = 0;
+    for (const auto value : sequence(state.operations())) {
+      sum += value;
+      bench::do_not_optimize(sum);
+    }
+  });
+}
+
+void generator_async(bench::state& state) {
+  state.measure([&]() {
+    auto task = async_sum(state.operations());
+    bench::do_not_optimize(task);
+  });
+}
+
+BENCHMARK("generator/baseline", 50'000'000, generator_loop);
+BENCHMARK("generator/sync", 50'000'000, generator_sync);
+BENCHMARK("generator/async", 20'000'000, generator_async);
+
+}  // namespace
@@ -0,0 +1,328 @@
+#pragma once
+#include "filter.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <span>
+#include <stop_token>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Mixes the bits of a value, so that every bit of the result depends on every bit of the value.
+inline std::uint64_t Hash(std::uint64_t value) noexcept {
+  value ^= value >> 33;
+  value *= 0xFF51AFD7ED558CCDULL;
+  value ^= value >> 33;
+  value *= 0xC4CEB9FE1A85EC53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+// Hashes bytes eight at a time.
+inline std::uint64_t Hash(std::string_view value) noexcept {
+  auto hash = Hash(value.size());
+  std::size_t i = 0;
+  for (; i + 8 <= value.size(); i += 8) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, value.data() + i, 8);
+    hash = Hash(hash ^ word);
+  }
+  std::uint64_t word = 0;
+  std::memcpy(&word, value.data() + i, value.size() - i);
+  return Hash(hash ^ word);
+}
+
+// Estimates the number of distinct values from their hashes with a HyperLogLog sketch.
+//
+// The first bits of a hash select one of 4096 registers, which keeps the highest rank of the first
+// set bit among the remaining bits. The standard error is 1.04 / sqrt(4096), about 1.6%. Sketches
+// of different rows are merged by keeping the larger registers.
+//
+class Distinct {
+public:
+  constexpr static unsigned precision = 12;
+  constexpr static std::size_t registers = std::size_t(1) << precision;
+
+  void Add(std::uint64_t hash) noexcept {
+    auto& value = registers_[hash >> (64 - precision)];
+    const auto rank = static_cast<std::uint8_t>(std::countl_zero(hash << precision | std::uint64_t(1) << (precision - 1)) + 1);
+    value = std::max(value, rank);
+  }
+
+  void Merge(const Distinct& other) noexcept {
+    for (std::size_t i = 0; i < registers; i++) {
+      registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+  }
+
+  // Returns the estimate, which counts the empty registers while many are left.
+  std::uint64_t Estimate() const noexcept {
+    double sum = 0.0;
+    std::size_t zeros = 0;
+    for (const auto value : registers_) {
+      sum += std::ldexp(1.0, -static_cast<int>(value));
+      zeros += value == 0;
+    }
+    constexpr auto size = static_cast<double>(registers);
+    auto estimate = 0.7213 / (1.0 + 1.079 / size) * size * size / sum;
+    if (estimate <= 2.5 * size && zeros) {
+      estimate = size * std::log(size / static_cast<double>(zeros));
+    }
+    return static_cast<std::uint64_t>(std::llround(estimate));
+  }
+
+private:
+  std::array<std::uint8_t, registers> registers_{};
+};
+
+// Number, sum, minimum, maximum and distinct values of a column over a number of rows.
+// Values that are not numbers only add to the count and the distinct values.
+class Aggregate {
+public:
+  void Add(double value, std::uint64_t hash) noexcept {
+    count_++;
+    numbers_++;
+    sum_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    distinct_.Add(hash);
+  }
+
+  void Add(std::uint64_t hash) noexcept {
+    count_++;
+    distinct_.Add(hash);
+  }
+
+  void Merge(const Aggregate& other) noexcept {
+    count_ += other.count_;
+    numbers_ += other.numbers_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    distinct_.Merge(other.distinct_);
+  }
+
+  // Returns the number of values that are not empty.
+  std::uint64_t Count() const noexcept {
+    return count_;
+  }
+
+  // Returns the number of values that are numbers.
+  std::uint64_t Numbers() const noexcept {
+    return numbers_;
+  }
+
+  double Sum() const noexcept {
+    return sum_;
+  }
+
+  double Min() const noexcept {
+    return min_;
+  }
+
+  double Max() const noexcept {
+    return max_;
+  }
+
+  // Returns the estimated number of distinct values.
+  std::uint64_t Distinct() const noexcept {
+    return std::min(distinct_.Estimate(), count_);
+  }
+
+private:
+  std::uint64_t count_ = 0;
+  std::uint64_t numbers_ = 0;
+  double sum_ = 0.0;
+  double min_ = std::numeric_limits<double>::infinity();
+  double max_ = -std::numeric_limits<double>::infinity();
+  ::Distinct distinct_;
+};
+
+// Aggregates of all columns over a number of rows.
+struct Totals {
+  std::size_t rows = 0;
+  std::vector<Aggregate> cols;
+
+  // Adds the aggregates of other rows.
+  void Merge(const Totals& other) noexcept {
+    rows += other.rows;
+    cols.resize(std::max(cols.size(), other.cols.size()));
+    for (std::size_t col = 0; col < other.cols.size(); col++) {
+      cols[col].Merge(other.cols[col]);
+    }
+  }
+};
+
+// Aggregates the columns of rows in parallel jobs. Every job aggregates its own range of rows into
+// partial totals, which are merged in order once the jobs ran, so that the totals of the rows seen
+// so far can be shown while the rest is aggregated. Totals of different rows are merged the same way,
+// which keeps the totals of a growing table up to date by aggregating the appended rows only.
+//
+// Aggregator aggregator;
+// aggregator.Add(Aggregator::Doubles(column.Doubles()));
+// aggregator.Start(totals.rows, rows, nullptr, jobs);
+// for (std::size_t job = 0; job < aggregator.Jobs(); job++) {
+//   jobs.push_back(Run(aggregator, job, token));
+// }
+// co_await ice::when_all(jobs);
+// totals.Merge(aggregator.Result());
+//
+class Aggregator {
+public:
+  // Adds the values of rows to the aggregate of a column. Rows are consecutive when contiguous is true.
+  using Column = std::function<void(const std::uint32_t* rows, std::size_t size, bool contiguous, Aggregate& aggregate)>;
+
+  // Number of rows that a column aggregates at once.
+  constexpr static std::size_t block = Selector::block;
+
+  Aggregator() = default;
+
+  Aggregator(Aggregator&& other) = delete;
+  Aggregator(const Aggregator& other) = delete;
+  Aggregator& operator=(Aggregator&& other) = delete;
+  Aggregator& operator=(const Aggregator& other) = delete;
+
+  ~Aggregator() = default;
+
+  static Column Integers(std::span<const std::int64_t> values) noexcept {
+    return [values](const std::uint32_t* rows, std::size_t size, bool contiguous, Aggregate& aggregate) noexcept {
+      if (contiguous) {
+        for (const auto value : values.subspan(rows[0], size)) {
+          aggregate.Add(static_cast<double>(value), Hash(static_cast<std::uint64_t>(value)));
+        }
+        return;
+      }
+      for (std::size_t i = 0; i < size; i++) {
+        const auto value = values[rows[i]];
+        aggregate.Add(static_cast<double>(value), Hash(static_cast<std::uint64_t>(value)));
+      }
+    };
+  }
+
+  // Creates a column of doubles. NaN is counted, but is not a number.
+  static Column Doubles(std::span<const double> values) noexcept {
+    return [values](const std::uint32_t* rows, std::size_t size, bool contiguous, Aggregate& aggregate) noexcept {
+      const auto add = [&](double value) noexcept {
+        // Zero and negative zero are the same value.
+        const auto hash = Hash(std::bit_cast<std::uint64_t>(value + 0.0));
+        if (std::isnan(value)) {
+          aggregate.Add(hash);
+        } else {
+          aggregate.Add(value, hash);
+        }
+      };
+      if (contiguous) {
+        for (const auto value : values.subspan(rows[0], size)) {
+          add(value);
+        }
+        return;
+      }
+      for (std::size_t i = 0; i < size; i++) {
+        add(values[rows[i]]);
+      }
+    };
+  }
+
+  // Creates a column of dictionary codes, which are counted as distinct values.
+  static Column Codes(std::span<const std::uint32_t> codes) noexcept {
+    return [codes](const std::uint32_t* rows, std::size_t size, bool, Aggregate& aggregate) noexcept {
+      for (std::size_t i = 0; i < size; i++) {
+        aggregate.Add(Hash(std::uint64_t{ codes[rows[i]] }));
+      }
+    };
+  }
+
+  // Creates a column of text fields. Empty fields are not counted. Fields that parse as a number
+  // in full are numbers. Distinct values are counted by their bytes.
+  static Column Texts(std::function<std::string_view(std::size_t row)> field) noexcept {
+    return [field = std::move(field)](const std::uint32_t* rows, std::size_t size, bool, Aggregate& aggregate) noexcept {
+      for (std::size_t i = 0; i < size; i++) {
+        const auto value = field(rows[i]);
+        if (value.empty()) {
+          continue;
+        }
+        double number = 0.0;
+        const auto end = value.data() + value.size();
+        if (const auto [ptr, ec] = std::from_chars(value.data(), end, number); ec == std::errc{} && ptr == end && !std::isnan(number)) {
+          aggregate.Add(number, Hash(value));
+        } else {
+          aggregate.Add(Hash(value));
+        }
+      }
+    };
+  }
+
+  // Adds a column. Aggregates are returned in the order in which columns were added.
+  void Add(Column column) noexcept {
+    columns_.push_back(std::move(column));
+  }
+
+  // Prepares aggregating rows begin to end, or the rows shown at positions begin to end of a view
+  // when it is not null. The view must stay valid until the totals are complete.
+  void Start(std::size_t begin, std::size_t end, const Selection* view, std::size_t jobs) noexcept {
+    view_ = view;
+    begin_ = begin;
+    size_ = end > begin ? end - begin : 0;
+    jobs_ = std::max(std::size_t(1), std::min(jobs, size_ / block + 1));
+    results_.assign(jobs_, {});
+  }
+
+  std::size_t Jobs() const noexcept {
+    return jobs_;
+  }
+
+  // Aggregates the rows of a job. Different jobs may run concurrently. Returns early when a stop is requested.
+  void Run(std::size_t job, const std::stop_token& token) noexcept {
+    assert(job < jobs_);
+    const auto size = (size_ + jobs_ - 1) / jobs_;
+    const auto begin = std::min(size_, job * size);
+    const auto end = std::min(size_, begin + size);
+    std::vector<std::uint32_t> rows(block);
+    auto& result = results_[job];
+    result.cols.resize(columns_.size());
+    for (auto i = begin; i < end && !token.stop_requested(); i += block) {
+      const auto count = std::min(block, end - i);
+      for (std::size_t j = 0; j < count; j++) {
+        const auto position = begin_ + i + j;
+        rows[j] = static_cast<std::uint32_t>(view_ ? view_->Row(static_cast<int>(position)) : static_cast<int>(position));
+      }
+      for (std::size_t col = 0; col < columns_.size(); col++) {
+        columns_[col](rows.data(), count, !view_, result.cols[col]);
+      }
+      result.rows += count;
+    }
+  }
+
+  // Returns the merged totals of jobs 0 to jobs once those jobs ran.
+  Totals Result(std::size_t jobs) const noexcept {
+    assert(jobs <= jobs_);
+    Totals totals;
+    totals.cols.resize(columns_.size());
+    for (std::size_t job = 0; job < jobs; job++) {
+      totals.Merge(results_[job]);
+    }
+    return totals;
+  }
+
+  // Returns the merged totals once all jobs ran.
+  Totals Result() const noexcept {
+    return Result(jobs_);
+  }
+
+private:
+  std::vector<Column> columns_;
+  const Selection* view_ = nullptr;
+  std::size_t begin_ = 0;
+  std::size_t size_ = 0;
+  std::size_t jobs_ = 1;
+  std::vector<Totals> results_;
+};
@@ -0,0 +1,163 @@
+#pragma once
+#include <fmt/format.h>
+#if __has_include(<fmt/xchar.h>)
+#include <fmt/xchar.h>
+#endif
+#include <algorithm>
+#include <bit>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+
+// Text of a range of table rows stored in a single buffer.
+// Each cell is null terminated and located by its offset in the buffer.
+//
+// Rows are kept in a ring of slots indexed by row modulo the power of two number of slots.
+// Moving the range only formats rows that were not in the previous range and
+// appends them to the buffer. Text of rows that left the range is reclaimed
+// by compacting the buffer once it outgrows the text of the current rows.
+class Cells {
+public:
+  Cells() = default;
+
+  void Reset() noexcept {
+    min_ = 0;
+    max_ = -1;
+    cols_ = 0;
+    slots_ = 0;
+    size_ = 0;
+    data_ = {};
+    text_ = fmt::wmemory_buffer{};
+    swap_ = fmt::wmemory_buffer{};
+  }
+
+  // Formats rows min to max with callback(text, row, col), which appends the cell text to text.
+  // Rows that are already formatted with the same number of columns are kept.
+  template <typename Callback>
+  bool Set(int min, int max, int cols, Callback callback) noexcept {
+    if (min < 0 || max < min || cols < 0) {
+      return false;
+    }
+
+    // Drops all rows when the columns change or the ranges do not overlap.
+    if (cols != cols_ || max < min_ || min > max_) {
+      slots_ = cols != cols_ ? 0 : slots_;
+      min_ = min;
+      max_ = min - 1;
+      cols_ = cols;
+      size_ = 0;
+      text_.clear();
+    }
+
+    // Releases rows that leave the range.
+    for (auto row = min_; row < min && row <= max_; row++) {
+      size_ -= Size(row);
+    }
+    for (auto row = std::max(max + 1, min_); row <= max_; row++) {
+      size_ -= Size(row);
+    }
+
+    // Grows the ring and moves the kept rows to their new slots.
+    if (const auto slots = std::bit_ceil(static_cast<std::size_t>(max - min + 1)); slots > slots_) {
+      std::vector<std::size_t> data(slots * Stride());
+      for (auto row = std::max(min, min_); row <= std::min(max, max_); row++) {
+        const auto src = data_.begin() + static_cast<std::ptrdiff_t>(Slot(row) * Stride());
+        std::copy(src, src + static_cast<std::ptrdiff_t>(Stride()), data.begin() + static_cast<std::ptrdiff_t>(Slot(row, slots) * Stride()));
+      }
+      data_ = std::move(data);
+      slots_ = slots;
+    }
+
+    // Reclaims text of released rows once it outweighs the kept rows.
+    const auto keep_min = std::max(min, min_);
+    const auto keep_max = std::min(max, max_);
+    min_ = min;
+    max_ = max;
+    if (keep_min <= keep_max && text_.size() > 2 * size_ + 4096) {
+      Compact(keep_min, keep_max);
+    }
+
+    // Formats rows that enter the range.
+    for (auto row = min; row <= max; row++) {
+      if (row == keep_min && keep_min <= keep_max) {
+        row = keep_max;
+        continue;
+      }
+      const auto begin = text_.size();
+      auto data = data_.begin() + static_cast<std::ptrdiff_t>(Slot(row) * Stride());
+      for (int col = 0; col < cols; col++) {
+        *data++ = text_.size();
+        callback(text_, row, col);
+        text_.push_back(L'\0');
+      }
+      *data = text_.size();
+      size_ += text_.size() - begin;
+    }
+    return true;
+  }
+
+  bool Contains(int row) const noexcept {
+    return row >= min_ && row <= max_;
+  }
+
+  bool Contains(int min, int max) const noexcept {
+    return min >= min_ && max <= max_;
+  }
+
+  // Returns the text of a cell without the null terminator.
+  std::wstring_view Get(int row, int col) const noexcept {
+    assert(Contains(row));
+    assert(col >= 0 && col < cols_);
+    const auto pos = Slot(row) * Stride() + static_cast<std::size_t>(col);
+    const auto beg = data_[pos];
+    const auto end = data_[pos + 1];
+    return { text_.data() + beg, end - beg - 1 };
+  }
+
+private:
+  // Number of offsets per slot: the start of every cell and the end of the row.
+  std::size_t Stride() const noexcept {
+    return static_cast<std::size_t>(cols_) + 1;
+  }
+
+  std::size_t Slot(int row) const noexcept {
+    return Slot(row, slots_);
+  }
+
+  static std::size_t Slot(int row, std::size_t slots) noexcept {
+    return static_cast<std::size_t>(row) & (slots - 1);
+  }
+
+  // Returns the size of the text of a formatted row.
+  std::size_t Size(int row) const noexcept {
+    const auto pos = Slot(row) * Stride();
+    return data_[pos + Stride() - 1] - data_[pos];
+  }
+
+  // Copies the text of rows min to max to the start of a new buffer.
+  void Compact(int min, int max) noexcept {
+    swap_.clear();
+    for (auto row = min; row <= max; row++) {
+      const auto data = data_.begin() + static_cast<std::ptrdiff_t>(Slot(row) * Stride());
+      const auto begin = data[0];
+      const auto end = data[static_cast<std::ptrdiff_t>(Stride()) - 1];
+      const auto offset = swap_.size();
+      swap_.append(text_.data() + begin, text_.data() + end);
+      for (std::size_t i = 0; i < Stride(); i++) {
+        data[static_cast<std::ptrdiff_t>(i)] = data[static_cast<std::ptrdiff_t>(i)] - begin + offset;
+      }
+    }
+    std::swap(text_, swap_);
+  }
+
+  int min_ = 0;
+  int max_ = -1;
+  int cols_ = 0;
+  std::size_t slots_ = 0;
+  std::size_t size_ = 0;
+  fmt::wmemory_buffer text_;
+  fmt::wmemory_buffer swap_;
+  std::vector<std::size_t> data_;
+};
@@ -0,0 +1,398 @@
+#pragma once
+#include "text.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Read-only memory mapping of a whole file.
+class Mapping {
+public:
+  Mapping() noexcept = default;
+
+  Mapping(Mapping&& other) = delete;
+  Mapping(const Mapping& other) = delete;
+  Mapping& operator=(Mapping&& other) = delete;
+  Mapping& operator=(const Mapping& other) = delete;
+
+  ~Mapping() {
+    Close();
+  }
+
+  bool Open(const std::filesystem::path& path) noexcept {
+    Close();
+#ifdef _WIN32
+    constexpr DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    file_ = CreateFile(path.c_str(), GENERIC_READ, share, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file_, &size)) {
+      Close();
+      return false;
+    }
+    if (size.QuadPart == 0) {
+      return true;
+    }
+    mapping_ = CreateFileMapping(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) {
+      Close();
+      return false;
+    }
+    data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+      Close();
+      return false;
+    }
+    size_ = static_cast<std::size_t>(size.QuadPart);
+#else
+    const auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+      return false;
+    }
+    struct stat st = {};
+    if (::fstat(file, &st) < 0) {
+      ::close(file);
+      return false;
+    }
+    if (st.st_size > 0) {
+      const auto data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+      if (data == MAP_FAILED) {
+        ::close(file);
+        return false;
+      }
+      data_ = static_cast<const char*>(data);
+      size_ = static_cast<std::size_t>(st.st_size);
+    }
+    ::close(file);
+#endif
+    return true;
+  }
+
+  void Close() noexcept {
+#ifdef _WIN32
+    if (data_) {
+      UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+      CloseHandle(mapping_);
+      mapping_ = nullptr;
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+      CloseHandle(file_);
+      file_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (data_) {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  std::string_view Data() const noexcept {
+    return { data_, size_ };
+  }
+
+private:
+  const char* data_{ nullptr };
+  std::size_t size_{ 0 };
+#ifdef _WIN32
+  HANDLE file_{ INVALID_HANDLE_VALUE };
+  HANDLE mapping_{ nullptr };
+#endif
+};
+
+// Delimited text file with a row offset index.
+// The first row holds the column names. Fields are sliced from the mapping and
+// only converted to UTF-16 when a cell is formatted.
+//
+// The index is built from chunks that can be scanned in parallel and must be
+// appended in order. A newline only ends a row if it is preceded by an even
+// number of quotes, which is resolved when a chunk is appended.
+class Csv {
+public:
+  // Offsets after the newlines of a part of the file.
+  struct Chunk {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+
+    // The highest bit is set if the chunk had an odd number of quotes before the newline.
+    std::vector<std::uint64_t> lines;
+
+    // True if the chunk has an odd number of quotes.
+    bool quotes = false;
+  };
+
+  constexpr static std::uint64_t parity = std::uint64_t(1) << 63;
+
+  Csv() = default;
+
+  Csv(Csv&& other) = default;
+  Csv(const Csv& other) = delete;
+  Csv& operator=(Csv&& other) = default;
+  Csv& operator=(const Csv& other) = delete;
+
+  ~Csv() = default;
+
+  // Maps the file and reads the column names.
+  // Files without a byte order mark that do not start with valid UTF-8 are read as Windows-1252.
+  bool Open(const std::filesystem::path& path) noexcept {
+    auto mapping = std::make_shared<::Mapping>();
+    if (!mapping->Open(path)) {
+      return false;
+    }
+    mapping_ = std::move(mapping);
+    const auto data = Data();
+    std::size_t begin = data.starts_with("\xEF\xBB\xBF") ? 3 : 0;
+    utf8_ = begin || ValidUtf8(data.substr(0, 1 << 16));
+    auto end = begin;
+    auto quoted = false;
+    while (end < data.size() && (quoted || data[end] != '\n')) {
+      quoted ^= data[end++] == '"';
+    }
+    const auto header = Trim(data.substr(begin, end - begin));
+    auto extension = path.extension().wstring();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](wchar_t c) { return c >= L'A' && c <= L'Z' ? static_cast<wchar_t>(c + 32) : c; });
+    if (extension == L".tsv" || extension == L".tab") {
+      delimiter_ = '\t';
+    } else {
+      const auto count = [&](char c) { return std::count(header.begin(), header.end(), c); };
+      const auto tabs = count('\t');
+      const auto semicolons = count(';');
+      const auto commas = count(',');
+      delimiter_ = tabs > commas && tabs >= semicolons ? '\t' : semicolons > commas ? ';' : ',';
+    }
+    names_.clear();
+    for (std::size_t col = 0, pos = 0; pos <= header.size(); col++) {
+      const auto field = Next(header, pos);
+      auto& name = names_.emplace_back();
+      if (field.empty()) {
+        name = L"Column " + std::to_wstring(col + 1);
+      } else {
+        AppendField(name, field);
+      }
+    }
+    rows_.clear();
+    rows_.push_back(std::min(end + 1, data.size()));
+    quoted_ = false;
+    complete_ = rows_.back() == data.size();
+    return true;
+  }
+
+  // Returns the mapping, which scans can hold on to while the Csv is replaced.
+  std::shared_ptr<const ::Mapping> Mapping() const noexcept {
+    return mapping_;
+  }
+
+  std::string_view Data() const noexcept {
+    return mapping_ ? mapping_->Data() : std::string_view{};
+  }
+
+  // Splits the part of the file that was not indexed yet into chunks.
+  // The first chunk is smaller so that the first rows can be shown early.
+  std::vector<Chunk> Split(std::size_t first = 1 << 20, std::size_t size = 16 << 20) const noexcept {
+    std::vector<Chunk> chunks;
+    const auto end = Data().size();
+    for (std::size_t begin = rows_.back(); begin < end;) {
+      const auto next = std::min(end, begin + (chunks.empty() ? first : size));
+      auto& chunk = chunks.emplace_back();
+      chunk.begin = begin;
+      chunk.end = next;
+      begin = next;
+    }
+    return chunks;
+  }
+
+  // Finds the newlines and quotes of a chunk. Thread safe.
+  static void Scan(std::string_view data, Chunk& chunk) noexcept {
+    assert(chunk.begin <= chunk.end && chunk.end <= data.size());
+    chunk.lines.clear();
+    std::uint64_t quotes = 0;
+    auto pos = chunk.begin;
+#ifdef CARTA_SSE2
+    const auto newline = _mm_set1_epi8('\n');
+    const auto quote = _mm_set1_epi8('"');
+    for (; pos + 16 <= chunk.end; pos += 16) {
+      const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data.data() + pos));
+      auto lines = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+      const auto marks = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, quote)));
+      if (!marks) {
+        while (lines) {
+          chunk.lines.push_back((pos + Bit(lines) + 1) | (quotes << 63));
+          lines &= lines - 1;
+        }
+        continue;
+      }
+      for (auto bits = lines | marks; bits; bits &= bits - 1) {
+        const auto bit = Bit(bits);
+        if (marks & (1u << bit)) {
+          quotes ^= 1;
+        } else {
+          chunk.lines.push_back((pos + bit + 1) | (quotes << 63));
+        }
+      }
+    }
+#endif
+    for (; pos < chunk.end; pos++) {
+      if (data[pos] == '"') {
+        quotes ^= 1;
+      } else if (data[pos] == '\n') {
+        chunk.lines.push_back((pos + 1) | (quotes << 63));
+      }
+    }
+    chunk.quotes = quotes != 0;
+  }
+
+  // Appends the rows of the next scanned chunk to the index.
+  void Append(const Chunk& chunk) noexcept {
+    assert(!complete_);
+    const auto quoted = quoted_ ? parity : 0;
+    for (const auto line : chunk.lines) {
+      if ((line & parity) == quoted) {
+        rows_.push_back(line & ~parity);
+      }
+    }
+    quoted_ ^= chunk.quotes;
+    if (chunk.end == Data().size()) {
+      if (rows_.back() != chunk.end) {
+        rows_.push_back(chunk.end);
+      }
+      complete_ = true;
+    }
+  }
+
+  // Returns true if the whole file was indexed.
+  bool Complete() const noexcept {
+    return complete_;
+  }
+
+  std::size_t Cols() const noexcept {
+    return names_.size();
+  }
+
+  // Returns the character that separates fields.
+  char Delimiter() const noexcept {
+    return delimiter_;
+  }
+
+  std::size_t Rows() const noexcept {
+    return rows_.empty() ? 0 : rows_.size() - 1;
+  }
+
+  const std::wstring& Name(std::size_t col) const noexcept {
+    assert(col < names_.size());
+    return names_[col];
+  }
+
+  // Returns a row without the line break.
+  std::string_view Row(std::size_t row) const noexcept {
+    assert(row + 1 < rows_.size());
+    const auto begin = static_cast<std::size_t>(rows_[row]);
+    return Trim(Data().substr(begin, static_cast<std::size_t>(rows_[row + 1]) - begin));
+  }
+
+  // Returns a field as it is stored in the file, including quotes.
+  std::string_view Field(std::size_t row, std::size_t col) const noexcept {
+    const auto data = Row(row);
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < col && pos <= data.size(); i++) {
+      Next(data, pos);
+    }
+    return pos <= data.size() ? Next(data, pos) : std::string_view{};
+  }
+
+  template <typename Buffer>
+  void Format(Buffer& text, int row, int col) const noexcept {
+    assert(row >= 0 && static_cast<std::size_t>(row) < Rows());
+    assert(col >= 0 && static_cast<std::size_t>(col) < Cols());
+    AppendField(text, Field(static_cast<std::size_t>(row), static_cast<std::size_t>(col)));
+  }
+
+private:
+  static unsigned Bit(unsigned bits) noexcept {
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward(&index, bits);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(bits));
+#endif
+  }
+
+  static std::string_view Trim(std::string_view row) noexcept {
+    if (row.ends_with('\n')) {
+      row.remove_suffix(1);
+    }
+    if (row.ends_with('\r')) {
+      row.remove_suffix(1);
+    }
+    return row;
+  }
+
+  // Returns the field at pos and moves pos past the following delimiter.
+  // Sets pos past the end of the row after the last field.
+  std::string_view Next(std::string_view row, std::size_t& pos) const noexcept {
+    const auto begin = pos;
+    auto quoted = false;
+    while (pos < row.size() && (quoted || row[pos] != delimiter_)) {
+      quoted ^= row[pos++] == '"';
+    }
+    const auto field = row.substr(begin, pos - begin);
+    pos++;
+    return field;
+  }
+
+  // Appends a field without enclosing quotes and with escaped quotes unescaped.
+  template <typename Buffer>
+  void AppendField(Buffer& text, std::string_view field) const noexcept {
+    if (field.size() < 2 || field.front() != '"' || field.back() != '"') {
+      AppendText(text, field);
+      return;
+    }
+    field = field.substr(1, field.size() - 2);
+    for (auto pos = field.find("\"\""); pos != std::string_view::npos; pos = field.find("\"\"")) {
+      AppendText(text, field.substr(0, pos + 1));
+      field.remove_prefix(pos + 2);
+    }
+    AppendText(text, field);
+  }
+
+  template <typename Buffer>
+  void AppendText(Buffer& text, std::string_view value) const noexcept {
+    if (utf8_) {
+      AppendUtf16(text, value);
+    } else {
+      AppendWindows1252(text, value);
+    }
+  }
+
+  std::shared_ptr<::Mapping> mapping_;
+  std::vector<std::wstring> names_;
+  std::vector<std::uint64_t> rows_;
+  char delimiter_ = ',';
+  bool quoted_ = false;
+  bool complete_ = false;
+  bool utf8_ = true;
+};
@@ -40,8 +40,8 @@ public:
       return GetCurrentThreadId() == GetWindowThreadProcessId(hwnd_, nullptr);
     }
 
-    void await_suspend(std::experimental::coroutine_handle<> coroutine) noexcept {
-      PostMessage(hwnd_, WM_DIALOG_CREATE, 0, reinterpret_cast<LPARAM>(coroutine.address()));
+    void await_suspend(ice::coroutine_handle<> coroutine) noexcept {
+      PostMessage(hwnd_, WM_DIALOG_RESUME, 0, reinterpret_cast<LPARAM>(coroutine.address()));
     }
 
     constexpr void await_resume() noexcept {
@@ -284,7 +284,7 @@ private:
         return reinterpret_cast<UINT_PTR>(GetStockObject(COLOR_WINDOWFRAME));
       case WM_DIALOG_RESUME:
         if (lparam) {
-          std::experimental::coroutine_handle<>::from_address(reinterpret_cast<void*>(lparam)).resume();
+          ice::coroutine_handle<>::from_address(reinterpret_cast<void*>(lparam)).resume();
         }
         return TRUE;
       }
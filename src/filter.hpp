@@ -0,0 +1,550 @@
+#pragma once
+#include "sort.hpp"
+#include "text.hpp"
+#include <fmt/format.h>
+#if __has_include(<fmt/xchar.h>)
+#include <fmt/xchar.h>
+#endif
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// A condition on one column, parsed from the text of its filter.
+//
+// =value      equal, by value if it is a number and by text ignoring case otherwise
+// min..max    in a range that includes both bounds, either of which may be left out
+// >=min       same as min..
+// <=max       same as ..max
+// text        contains the text, ignoring case
+//
+class Predicate {
+public:
+  enum class Type { Contains, Equal, Range };
+
+  // Column of a predicate that matches rows with any column that contains its text.
+  constexpr static auto any = static_cast<std::size_t>(-1);
+
+  Predicate() = default;
+
+  // Creates a predicate that matches rows with any column that contains the text, ignoring case.
+  // Returns false if the text is empty.
+  static bool Search(std::wstring_view text, Predicate& predicate) noexcept {
+    if (text.empty()) {
+      return false;
+    }
+    predicate = {};
+    predicate.col_ = any;
+    predicate.min_ = Fold(text);
+    return true;
+  }
+
+  // Returns false if the text is empty or blank.
+  static bool Parse(std::size_t col, std::wstring_view text, Predicate& predicate) noexcept {
+    const auto blank = L" \t";
+    if (const auto begin = text.find_first_not_of(blank); begin != std::wstring_view::npos) {
+      text = text.substr(begin, text.find_last_not_of(blank) - begin + 1);
+    } else {
+      return false;
+    }
+    predicate = {};
+    predicate.col_ = col;
+    if (text.starts_with(L'=')) {
+      predicate.type_ = Type::Equal;
+      predicate.min_ = Fold(text.substr(1));
+      predicate.max_ = predicate.min_;
+    } else if (text.starts_with(L">=")) {
+      predicate.type_ = Type::Range;
+      predicate.min_ = Fold(text.substr(2));
+    } else if (text.starts_with(L"<=")) {
+      predicate.type_ = Type::Range;
+      predicate.max_ = Fold(text.substr(2));
+    } else if (const auto pos = text.find(L".."); pos != std::wstring_view::npos && text.size() > 2) {
+      predicate.type_ = Type::Range;
+      predicate.min_ = Fold(text.substr(0, pos));
+      predicate.max_ = Fold(text.substr(pos + 2));
+    } else {
+      predicate.type_ = Type::Contains;
+      predicate.min_ = Fold(text);
+      return true;
+    }
+    predicate.numeric_ = (!predicate.min_.empty() || !predicate.max_.empty()) &&
+      (predicate.min_.empty() || Number(predicate.min_, predicate.low_)) &&
+      (predicate.max_.empty() || Number(predicate.max_, predicate.high_)) &&
+      !std::isnan(predicate.low_) && !std::isnan(predicate.high_);
+    return true;
+  }
+
+  // Parses a number from text that was formatted or typed by the user.
+  static bool Number(std::wstring_view text, double& number) noexcept {
+    char buffer[64];
+    if (text.empty() || text.size() > sizeof(buffer)) {
+      return false;
+    }
+    for (std::size_t i = 0; i < text.size(); i++) {
+      if (text[i] >= 0x80) {
+        return false;
+      }
+      buffer[i] = static_cast<char>(text[i]);
+    }
+    auto begin = buffer;
+    const auto end = buffer + text.size();
+    if (*begin == '+') {
+      begin++;
+    }
+    const auto [ptr, ec] = std::from_chars(begin, end, number);
+    return ec == std::errc{} && ptr == end;
+  }
+
+  std::size_t Col() const noexcept {
+    return col_;
+  }
+
+  Type Kind() const noexcept {
+    return type_;
+  }
+
+  // Returns the folded text of a Contains or Equal predicate.
+  const std::wstring& Text() const noexcept {
+    return min_;
+  }
+
+  // Returns true if the predicate compares values as numbers.
+  bool Numeric() const noexcept {
+    return numeric_;
+  }
+
+  // Returns the inclusive bounds of a numeric predicate.
+  double Low() const noexcept {
+    return low_;
+  }
+
+  double High() const noexcept {
+    return high_;
+  }
+
+  // Returns true if a number matches a numeric predicate.
+  bool Match(double value) const noexcept {
+    return value >= low_ && value <= high_;
+  }
+
+  // Returns true if text that was folded with FoldCase matches.
+  bool Match(std::wstring_view text) const noexcept {
+    switch (type_) {
+    case Type::Contains:
+      return text.find(min_) != std::wstring_view::npos;
+    case Type::Equal:
+    case Type::Range:
+      if (numeric_) {
+        double value = 0.0;
+        return Number(text, value) && Match(value);
+      }
+      if (type_ == Type::Equal) {
+        return text == min_;
+      }
+      return (min_.empty() || text >= min_) && (max_.empty() || text <= max_);
+    }
+    return false;
+  }
+
+  // Returns true if every value that matches this predicate matches other.
+  bool Implies(const Predicate& other) const noexcept {
+    if (col_ != other.col_) {
+      return false;
+    }
+    if (type_ == other.type_ && numeric_ == other.numeric_ && min_ == other.min_ && max_ == other.max_) {
+      return true;
+    }
+    if (other.type_ == Type::Contains) {
+      return !numeric_ && type_ != Type::Range && min_.find(other.min_) != std::wstring::npos;
+    }
+    if (type_ == Type::Contains || numeric_ != other.numeric_) {
+      return false;
+    }
+    if (numeric_) {
+      return low_ >= other.low_ && high_ <= other.high_;
+    }
+    if (other.type_ == Type::Equal) {
+      return false;
+    }
+    const auto low = other.min_.empty() || (!min_.empty() && min_ >= other.min_);
+    const auto high = other.max_.empty() || (!max_.empty() && max_ <= other.max_);
+    return low && high;
+  }
+
+private:
+  static std::wstring Fold(std::wstring_view text) noexcept {
+    std::wstring folded(text.size(), L'\0');
+    std::transform(text.begin(), text.end(), folded.begin(), FoldCase);
+    return folded;
+  }
+
+  std::size_t col_ = 0;
+  Type type_ = Type::Contains;
+  bool numeric_ = false;
+  std::wstring min_;
+  std::wstring max_;
+  double low_ = -std::numeric_limits<double>::infinity();
+  double high_ = std::numeric_limits<double>::infinity();
+};
+
+// Predicates that a row must all match.
+class Filter {
+public:
+  Filter() = default;
+
+  void Add(Predicate predicate) noexcept {
+    predicates_.push_back(std::move(predicate));
+  }
+
+  bool Empty() const noexcept {
+    return predicates_.empty();
+  }
+
+  const std::vector<Predicate>& Predicates() const noexcept {
+    return predicates_;
+  }
+
+  // Returns true if every row that matches this filter matches other, so that
+  // the rows selected by this filter can be found among the rows selected by other.
+  bool Implies(const Filter& other) const noexcept {
+    return std::all_of(other.predicates_.begin(), other.predicates_.end(), [this](const Predicate& rhs) noexcept {
+      return std::any_of(predicates_.begin(), predicates_.end(), [&](const Predicate& lhs) noexcept {
+        return lhs.Implies(rhs);
+      });
+    });
+  }
+
+private:
+  std::vector<Predicate> predicates_;
+};
+
+// Rows shown by the table. Either all rows in an order, or the positions in that
+// order of the rows that match a filter, in ascending order.
+class Selection {
+public:
+  explicit Selection(std::shared_ptr<const Permutation> order) noexcept : order_(std::move(order)) {
+  }
+
+  // Creates a selection of positions that match a filter. A selection that is not complete
+  // holds the matches found so far in a prefix of the positions.
+  Selection(std::shared_ptr<const Permutation> order, ::Filter filter, std::vector<std::uint32_t> positions, bool complete = true) noexcept :
+    order_(std::move(order)), filter_(std::move(filter)), positions_(std::move(positions)), complete_(complete) {
+  }
+
+  // Returns the row shown at a position or -1 if a filter selected fewer rows.
+  int Row(int position) const noexcept {
+    if (filter_.Empty()) {
+      return order_->Row(position);
+    }
+    if (position < 0 || static_cast<std::size_t>(position) >= positions_.size()) {
+      return -1;
+    }
+    return order_->Row(static_cast<int>(positions_[static_cast<std::size_t>(position)]));
+  }
+
+  // Returns the position at which a row is shown or -1 if it does not match the filter.
+  int Position(int row) const noexcept {
+    const auto position = order_->Position(row);
+    if (filter_.Empty()) {
+      return position;
+    }
+    const auto it = std::lower_bound(positions_.begin(), positions_.end(), static_cast<std::uint32_t>(position));
+    return it != positions_.end() && *it == static_cast<std::uint32_t>(position) ? static_cast<int>(it - positions_.begin()) : -1;
+  }
+
+  // Returns the number of rows shown from a source with the given number of rows.
+  std::size_t Size(std::size_t rows) const noexcept {
+    return filter_.Empty() ? rows : positions_.size();
+  }
+
+  const std::shared_ptr<const Permutation>& Order() const noexcept {
+    return order_;
+  }
+
+  const ::Filter& Filter() const noexcept {
+    return filter_;
+  }
+
+  const std::vector<std::uint32_t>& Positions() const noexcept {
+    return positions_;
+  }
+
+  bool Complete() const noexcept {
+    return complete_;
+  }
+
+private:
+  std::shared_ptr<const Permutation> order_;
+  ::Filter filter_;
+  std::vector<std::uint32_t> positions_;
+  bool complete_ = true;
+};
+
+// Evaluates predicates over the positions of an order in parallel jobs and collects the positions that match.
+//
+// Each job loads blocks of positions and their rows and runs one kernel per predicate over them. Every kernel
+// keeps the rows that match, so later kernels only see the rows that are left. The first kernel of a block of
+// an unsorted and unfiltered table reads the rows of a column in order, which lets numeric kernels use SIMD.
+// When input is a previous selection, only its positions are evaluated.
+//
+// Selector selector;
+// selector.Add(Selector::Doubles(predicate, column.Doubles()));
+// selector.Start(order, rows, nullptr, jobs);
+// for (std::size_t job = 0; job < selector.Jobs(); job++) {
+//   jobs.push_back(Run(selector, job, token));
+// }
+// co_await ice::when_all(jobs);
+// auto positions = selector.Result();
+//
+class Selector {
+public:
+  // Keeps the rows that match and their positions at the front and returns how many are left.
+  // Rows are consecutive when contiguous is true.
+  using Kernel = std::function<std::size_t(std::uint32_t* rows, std::uint32_t* positions, std::size_t size, bool contiguous)>;
+
+  // Appends the text of a row or value.
+  using Text = std::function<void(fmt::wmemory_buffer& buffer, std::size_t row)>;
+
+  // Number of rows that a kernel evaluates at once.
+  constexpr static std::size_t block = 4096;
+
+  Selector() = default;
+
+  Selector(Selector&& other) = delete;
+  Selector(const Selector& other) = delete;
+  Selector& operator=(Selector&& other) = delete;
+  Selector& operator=(const Selector& other) = delete;
+
+  ~Selector() = default;
+
+  // Creates a kernel that matches the text of rows.
+  static Kernel Texts(const Predicate& predicate, Text text) noexcept {
+    return [predicate, text = std::move(text)](std::uint32_t* rows, std::uint32_t* positions, std::size_t size, bool) noexcept {
+      fmt::wmemory_buffer buffer;
+      std::size_t count = 0;
+      for (std::size_t i = 0; i < size; i++) {
+        buffer.clear();
+        text(buffer, rows[i]);
+        std::transform(buffer.begin(), buffer.end(), buffer.begin(), FoldCase);
+        if (predicate.Match(std::wstring_view{ buffer.data(), buffer.size() })) {
+          rows[count] = rows[i];
+          positions[count] = positions[i];
+          count++;
+        }
+      }
+      return count;
+    };
+  }
+
+  // Creates a kernel that matches integers with a numeric predicate.
+  static Kernel Integers(const Predicate& predicate, std::span<const std::int64_t> values) noexcept {
+    assert(predicate.Numeric());
+    // Every integer in [min, max] satisfies a single unsigned comparison of its distance to min.
+    constexpr auto limit = 9.2e18;
+    const auto min = predicate.Low() < -limit ? std::numeric_limits<std::int64_t>::min() : static_cast<std::int64_t>(std::ceil(predicate.Low()));
+    const auto max = predicate.High() > limit ? std::numeric_limits<std::int64_t>::max() : static_cast<std::int64_t>(std::floor(predicate.High()));
+    if (predicate.Low() > limit || predicate.High() < -limit || min > max) {
+      return [](std::uint32_t*, std::uint32_t*, std::size_t, bool) noexcept { return std::size_t(0); };
+    }
+    const auto base = static_cast<std::uint64_t>(min);
+    const auto range = static_cast<std::uint64_t>(max) - base;
+    return [values, base, range](std::uint32_t* rows, std::uint32_t* positions, std::size_t size, bool) noexcept {
+      std::size_t count = 0;
+      for (std::size_t i = 0; i < size; i++) {
+        rows[count] = rows[i];
+        positions[count] = positions[i];
+        count += static_cast<std::uint64_t>(values[rows[i]]) - base <= range;
+      }
+      return count;
+    };
+  }
+
+  // Creates a kernel that matches doubles with a numeric predicate.
+  static Kernel Doubles(const Predicate& predicate, std::span<const double> values) noexcept {
+    assert(predicate.Numeric());
+    const auto low = predicate.Low();
+    const auto high = predicate.High();
+    return [values, low, high](std::uint32_t* rows, std::uint32_t* positions, std::size_t size, bool contiguous) noexcept {
+      std::size_t count = 0;
+      std::size_t i = 0;
+#ifdef CARTA_SSE2
+      if (contiguous) {
+        const auto data = values.data() + rows[0];
+        const auto min = _mm_set1_pd(low);
+        const auto max = _mm_set1_pd(high);
+        for (; i + 4 <= size; i += 4) {
+          const auto lo = _mm_loadu_pd(data + i);
+          const auto hi = _mm_loadu_pd(data + i + 2);
+          const auto lo_mask = _mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(lo, min), _mm_cmple_pd(lo, max)));
+          const auto hi_mask = _mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(hi, min), _mm_cmple_pd(hi, max)));
+          for (auto mask = static_cast<unsigned>(lo_mask | hi_mask << 2); mask; mask &= mask - 1) {
+            const auto j = i + static_cast<std::size_t>(std::countr_zero(mask));
+            rows[count] = rows[j];
+            positions[count] = positions[j];
+            count++;
+          }
+        }
+      }
+#endif
+      for (; i < size; i++) {
+        const auto value = values[rows[i]];
+        rows[count] = rows[i];
+        positions[count] = positions[i];
+        count += value >= low && value <= high;
+      }
+      return count;
+    };
+  }
+
+  // Creates a kernel that matches dictionary codes. The predicate is evaluated once for
+  // each of the values, whose text is appended by text(buffer, code).
+  static Kernel Codes(const Predicate& predicate, std::span<const std::uint32_t> codes, std::size_t values, const Text& text) noexcept {
+    std::vector<std::uint8_t> matches(values);
+    std::vector<std::uint32_t> rows(values);
+    std::vector<std::uint32_t> positions(values);
+    for (std::uint32_t code = 0; code < values; code++) {
+      rows[code] = code;
+    }
+    const auto count = Texts(predicate, text)(rows.data(), positions.data(), values, true);
+    for (std::size_t i = 0; i < count; i++) {
+      matches[rows[i]] = 1;
+    }
+    return [codes, matches = std::move(matches)](std::uint32_t* rows, std::uint32_t* positions, std::size_t size, bool) noexcept {
+      std::size_t count = 0;
+      for (std::size_t i = 0; i < size; i++) {
+        rows[count] = rows[i];
+        positions[count] = positions[i];
+        count += matches[codes[rows[i]]];
+      }
+      return count;
+    };
+  }
+
+  // Creates a kernel that keeps rows that match any of the kernels.
+  // Each kernel only evaluates the rows that did not match the kernels before it.
+  static Kernel Any(std::vector<Kernel> kernels) noexcept {
+    return [kernels = std::move(kernels)](std::uint32_t* rows, std::uint32_t* positions, std::size_t size, bool contiguous) noexcept {
+      // Kernels keep the indices of the rows that they match in place of positions.
+      std::vector<std::uint8_t> keep(size);
+      std::vector<std::uint32_t> left(rows, rows + size);
+      std::vector<std::uint32_t> indices(size);
+      std::vector<std::uint32_t> candidates;
+      for (std::uint32_t i = 0; i < size; i++) {
+        indices[i] = i;
+      }
+      for (const auto& kernel : kernels) {
+        if (left.empty()) {
+          break;
+        }
+        candidates = left;
+        auto matched = indices;
+        const auto count = kernel(candidates.data(), matched.data(), candidates.size(), contiguous && left.size() == size);
+        for (std::size_t i = 0; i < count; i++) {
+          keep[matched[i]] = 1;
+        }
+        std::size_t next = 0;
+        for (std::size_t i = 0; i < left.size(); i++) {
+          left[next] = left[i];
+          indices[next] = indices[i];
+          next += !keep[indices[i]];
+        }
+        left.resize(next);
+        indices.resize(next);
+      }
+      std::size_t count = 0;
+      for (std::size_t i = 0; i < size; i++) {
+        rows[count] = rows[i];
+        positions[count] = positions[i];
+        count += keep[i];
+      }
+      return count;
+    };
+  }
+
+  // Adds a kernel. All kernels must match for a row to be selected.
+  void Add(Kernel kernel) noexcept {
+    kernels_.push_back(std::move(kernel));
+  }
+
+  // Prepares evaluating positions 0 to rows of an order, or only the positions in input when it is not null.
+  // The order and input must stay valid until the selection is complete.
+  void Start(const Permutation& order, std::size_t rows, const std::vector<std::uint32_t>* input, std::size_t jobs) noexcept {
+    order_ = &order;
+    input_ = input;
+    size_ = input ? input->size() : rows;
+    jobs_ = std::max(std::size_t(1), std::min(jobs, size_ / block + 1));
+    results_.assign(jobs_, {});
+  }
+
+  std::size_t Jobs() const noexcept {
+    return jobs_;
+  }
+
+  // Evaluates the positions of a job. Different jobs may run concurrently. Returns early when a stop is requested.
+  void Run(std::size_t job, const std::stop_token& token) noexcept {
+    assert(job < jobs_);
+    const auto size = (size_ + jobs_ - 1) / jobs_;
+    const auto begin = std::min(size_, job * size);
+    const auto end = std::min(size_, begin + size);
+    std::vector<std::uint32_t> rows(block);
+    std::vector<std::uint32_t> positions(block);
+    auto& result = results_[job];
+    for (auto i = begin; i < end && !token.stop_requested(); i += block) {
+      auto count = std::min(block, end - i);
+      for (std::size_t j = 0; j < count; j++) {
+        positions[j] = input_ ? (*input_)[i + j] : static_cast<std::uint32_t>(i + j);
+        rows[j] = static_cast<std::uint32_t>(order_->Row(static_cast<int>(positions[j])));
+      }
+      auto contiguous = !input_ && order_->Size() == 0;
+      for (const auto& kernel : kernels_) {
+        if (!count) {
+          break;
+        }
+        count = kernel(rows.data(), positions.data(), count, contiguous);
+        contiguous = false;
+      }
+      result.insert(result.end(), positions.begin(), positions.begin() + static_cast<std::ptrdiff_t>(count));
+    }
+  }
+
+  // Returns the selected positions of jobs 0 to jobs in ascending order once those jobs ran.
+  std::vector<std::uint32_t> Result(std::size_t jobs) const noexcept {
+    assert(jobs <= jobs_);
+    std::size_t size = 0;
+    for (std::size_t job = 0; job < jobs; job++) {
+      size += results_[job].size();
+    }
+    std::vector<std::uint32_t> positions;
+    positions.reserve(size);
+    for (std::size_t job = 0; job < jobs; job++) {
+      positions.insert(positions.end(), results_[job].begin(), results_[job].end());
+    }
+    return positions;
+  }
+
+  // Returns the selected positions in ascending order once all jobs ran.
+  std::vector<std::uint32_t> Result() const noexcept {
+    return Result(jobs_);
+  }
+
+private:
+  std::vector<Kernel> kernels_;
+  const Permutation* order_ = nullptr;
+  const std::vector<std::uint32_t>* input_ = nullptr;
+  std::size_t size_ = 0;
+  std::size_t jobs_ = 1;
+  std::vector<std::vector<std::uint32_t>> results_;
+};
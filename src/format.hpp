@@ -0,0 +1,216 @@
+#pragma once
+#include "text.hpp"
+#include <fmt/format.h>
+#if __has_include(<fmt/xchar.h>)
+#include <fmt/xchar.h>
+#endif
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iterator>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Cell formatters that write straight into a wide character buffer.
+// Field widths and precisions are template arguments, so there is no format string to parse per cell.
+//
+// Store::Format(text, row, col) picks the formatter for the column type:
+//
+//   AppendInteger(text, 42);              // 42
+//   AppendInteger<9>(text, 42);           // 000000042
+//   AppendDecimal<2>(text, -3.14159);     // -3.14
+//   AppendTimestamp(text, 0);             // 1970-01-01 00:00:00
+//
+
+namespace detail {
+
+constexpr std::uint64_t Power10(std::size_t exponent) noexcept {
+  std::uint64_t value = 1;
+  while (exponent--) {
+    value *= 10;
+  }
+  return value;
+}
+
+// Returns the number of decimal digits of a value.
+inline std::size_t Digits(std::uint64_t value) noexcept {
+  constexpr auto powers = []() {
+    std::array<std::uint64_t, 20> powers{};
+    for (std::size_t i = 0; i < powers.size(); i++) {
+      powers[i] = Power10(i);
+    }
+    return powers;
+  }();
+  value |= 1;
+  const auto digits = static_cast<std::size_t>(std::bit_width(value) * 1233) >> 12;
+  return digits + (value >= powers[digits] ? 1 : 0);
+}
+
+// Writes eight decimal digits of a value below 100'000'000 with leading zeros.
+inline void Digits8(wchar_t* dst, std::uint32_t value) noexcept {
+#ifdef CARTA_SSE2
+  // Divides by 10'000 and then by 1'000, 100, 10 and 1 in 16-bit lanes with multiply high.
+  const auto abcdefgh = _mm_cvtsi32_si128(static_cast<int>(value));
+  const auto abcd = _mm_srli_epi64(_mm_mul_epu32(abcdefgh, _mm_set1_epi32(static_cast<int>(0xD1B71759))), 45);
+  const auto efgh = _mm_sub_epi32(abcdefgh, _mm_mul_epu32(abcd, _mm_set1_epi32(10000)));
+  const auto v1 = _mm_slli_epi64(_mm_unpacklo_epi16(abcd, efgh), 2);
+  const auto v2 = _mm_unpacklo_epi16(v1, v1);
+  const auto v3 = _mm_unpacklo_epi32(v2, v2);
+  const auto v4 = _mm_mulhi_epu16(v3, _mm_setr_epi16(8389, 5243, 13108, -32768, 8389, 5243, 13108, -32768));
+  const auto v5 = _mm_mulhi_epu16(v4, _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, -32768, 1 << 7, 1 << 11, 1 << 13, -32768));
+  const auto v6 = _mm_slli_epi64(_mm_mullo_epi16(v5, _mm_set1_epi16(10)), 16);
+  detail::Store(dst, _mm_add_epi16(_mm_sub_epi16(v5, v6), _mm_set1_epi16('0')));
+#else
+  for (auto i = 8; i > 0; i--) {
+    dst[i - 1] = static_cast<wchar_t>(L'0' + value % 10);
+    value /= 10;
+  }
+#endif
+}
+
+// Writes the last digits of a value right aligned and padded with zeros.
+inline void Digits(wchar_t* dst, std::uint64_t value, std::size_t digits) noexcept {
+  wchar_t buffer[24];
+  Digits8(buffer + 16, static_cast<std::uint32_t>(value % 100'000'000));
+  if (digits > 8) {
+    value /= 100'000'000;
+    Digits8(buffer + 8, static_cast<std::uint32_t>(value % 100'000'000));
+    if (digits > 16) {
+      Digits8(buffer, static_cast<std::uint32_t>(value / 100'000'000));
+    }
+  }
+  std::memcpy(dst, buffer + 24 - digits, digits * sizeof(wchar_t));
+}
+
+// Returns a finite non-negative value times Scale rounded half to even. The product is computed from the exact
+// binary value in 128 bits, so that the digits are the ones fmt prints. The result must be below 2^53.
+template <std::uint64_t Scale>
+inline std::uint64_t Round(double value) noexcept {
+  static_assert(Scale < (std::uint64_t(1) << 30));
+  const auto bits = std::bit_cast<std::uint64_t>(value);
+  const auto biased = static_cast<int>(bits >> 52);
+  const auto mantissa = (bits & 0xF'FFFF'FFFF'FFFF) | (biased ? std::uint64_t(1) << 52 : 0);
+  const auto exponent = std::max(biased, 1) - 1075;
+  if (exponent >= 0) {
+    return (mantissa << exponent) * Scale;
+  }
+
+  // Multiplies the mantissa of at most 53 bits by the scale of at most 30 bits in 32-bit halves.
+  const auto m0 = mantissa & 0xFFFF'FFFF;
+  const auto m1 = mantissa >> 32;
+  const auto low = m0 * Scale;
+  const auto high = m1 * Scale + (low >> 32);
+  const auto lo = (high << 32) | (low & 0xFFFF'FFFF);
+  const auto hi = high >> 32;
+
+  // Divides by half of 2^-exponent, the last bit of the quotient decides the rounding.
+  const auto shift = -exponent - 1;
+  if (shift >= 83) {
+    return 0;
+  }
+  std::uint64_t halves = 0;
+  bool sticky = false;
+  if (shift == 0) {
+    halves = lo;
+  } else if (shift < 64) {
+    halves = (lo >> shift) | (hi << (64 - shift));
+    sticky = (lo & ((std::uint64_t(1) << shift) - 1)) != 0;
+  } else {
+    halves = hi >> (shift - 64);
+    sticky = lo != 0 || (hi & ((std::uint64_t(1) << (shift - 64)) - 1)) != 0;
+  }
+  const auto result = halves >> 1;
+  return result + ((halves & 1) && (sticky || (result & 1)) ? 1 : 0);
+}
+
+}  // namespace detail
+
+// Appends an unsigned integer with at least Width digits.
+template <std::size_t Width = 1, typename Buffer>
+inline void AppendInteger(Buffer& text, std::uint64_t value) noexcept {
+  static_assert(Width <= 20);
+  const auto digits = std::max(detail::Digits(value), Width);
+  detail::Digits(detail::Grow(text, digits), value, digits);
+}
+
+// Appends an integer with at least Width digits after the sign.
+template <std::size_t Width = 1, typename Buffer>
+inline void AppendInteger(Buffer& text, std::int64_t value) noexcept {
+  if (value < 0) {
+    text.push_back(L'-');
+  }
+  AppendInteger<Width>(text, value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value));
+}
+
+template <std::size_t Width = 1, typename Buffer>
+inline void AppendInteger(Buffer& text, int value) noexcept {
+  AppendInteger<Width>(text, static_cast<std::int64_t>(value));
+}
+
+// Appends a number with Precision digits after the decimal point, rounded half to even like fmt.
+// Values that reach 2^52 once scaled, infinities and NaN are formatted with fmt.
+template <std::size_t Precision, typename Buffer>
+inline void AppendDecimal(Buffer& text, double value) noexcept {
+  static_assert(Precision <= 9);
+  constexpr auto scale = detail::Power10(Precision);
+  if (!(std::abs(value) < 0x1p52 / static_cast<double>(scale))) {
+    fmt::format_to(std::back_inserter(text), L"{:.{}f}", value, Precision);
+    return;
+  }
+  const auto scaled = detail::Round<scale>(std::abs(value));
+  if (std::signbit(value)) {
+    text.push_back(L'-');
+  }
+  AppendInteger(text, scaled / scale);
+  if constexpr (Precision > 0) {
+    text.push_back(L'.');
+    AppendInteger<Precision>(text, scaled % scale);
+  }
+}
+
+// Appends microseconds since the epoch as an ISO 8601 date and time without fractions.
+// Years outside of 0 to 9999 are formatted with fmt.
+template <typename Buffer>
+inline void AppendTimestamp(Buffer& text, std::int64_t value) noexcept {
+  // Splits the value without multiplying the days back, which would overflow near the limits.
+  constexpr std::int64_t day = 86'400'000'000;
+  const auto remainder = value % day;
+  const auto days = value / day - (remainder < 0 ? 1 : 0);
+  const auto seconds = static_cast<std::uint32_t>((remainder < 0 ? remainder + day : remainder) / 1'000'000);
+
+  // Converts days since the epoch to a civil date, see https://howardhinnant.github.io/date_algorithms.html.
+  const auto z = days + 719468;
+  const auto era = (z >= 0 ? z : z - 146096) / 146097;
+  const auto doe = z - era * 146097;
+  const auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const auto mp = (5 * doy + 2) / 153;
+  const auto d = doy - (153 * mp + 2) / 5 + 1;
+  const auto m = mp < 10 ? mp + 3 : mp - 9;
+  const auto y = yoe + era * 400 + (m <= 2 ? 1 : 0);
+
+  if (y < 0 || y > 9999) {
+    fmt::format_to(std::back_inserter(text), L"{:04}-{:02}-{:02} {:02}:{:02}:{:02}",
+      y, m, d, seconds / 3600, seconds / 60 % 60, seconds % 60);
+    return;
+  }
+
+  // Converts YYYYMMDD and 00hhmmss in one pass each and inserts the separators.
+  wchar_t digits[16];
+  detail::Digits8(digits, static_cast<std::uint32_t>(y * 10000 + m * 100 + d));
+  detail::Digits8(digits + 8, seconds / 3600 * 10000 + seconds / 60 % 60 * 100 + seconds % 60);
+  const auto dst = detail::Grow(text, 19);
+  std::memcpy(dst, digits, 4 * sizeof(wchar_t));
+  dst[4] = L'-';
+  std::memcpy(dst + 5, digits + 4, 2 * sizeof(wchar_t));
+  dst[7] = L'-';
+  std::memcpy(dst + 8, digits + 6, 2 * sizeof(wchar_t));
+  dst[10] = L' ';
+  std::memcpy(dst + 11, digits + 10, 2 * sizeof(wchar_t));
+  dst[13] = L':';
+  std::memcpy(dst + 14, digits + 12, 2 * sizeof(wchar_t));
+  dst[16] = L':';
+  std::memcpy(dst + 17, digits + 14, 2 * sizeof(wchar_t));
+}
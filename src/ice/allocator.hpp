@@ -0,0 +1,168 @@
+#pragma once
+#include <atomic>
+#include <new>
+#include <cstddef>
+
+namespace ice::detail {
+
+// Coroutine frame allocator with thread local size class free lists.
+// Frames released on the thread that allocated them go back to the local free list.
+// Frames released on other threads are pushed to a lock-free list of the owning thread
+// and reclaimed by the owner on the next allocation that misses the local free list.
+class frame_allocator {
+public:
+  constexpr static std::size_t granularity = 64;
+  constexpr static std::size_t classes = 16;
+
+  static void* allocate(std::size_t size) {
+    const auto total = size + sizeof(header);
+    if (total > granularity * classes) {
+      return init(::operator new(total), nullptr, 0);
+    }
+    const auto index = (total - 1) / granularity;
+    const auto cache = thread_cache::local();
+    if (!cache) {
+      return init(::operator new(total), nullptr, 0);
+    }
+    return init(cache->allocate(index), cache, index);
+  }
+
+  static void deallocate(void* frame, [[maybe_unused]] std::size_t size) noexcept {
+    const auto head = reinterpret_cast<header*>(frame) - 1;
+    if (!head->cache) {
+      ::operator delete(head);
+    } else {
+      head->cache->deallocate(head, head->index);
+    }
+  }
+
+private:
+  class thread_cache;
+
+  struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) header {
+    frame_allocator::thread_cache* cache;
+    std::size_t index;
+  };
+
+  static void* init(void* memory, thread_cache* cache, std::size_t index) noexcept {
+    return new (memory) header{ cache, index } + 1;
+  }
+
+  class thread_cache {
+  public:
+    static thread_cache* local() {
+      auto& local = current();
+      if (!local && !closed_thread()) {
+        thread_local owner instance{ local, closed_thread() };
+        local = instance.cache;
+      }
+      return local;
+    }
+
+    void* allocate(std::size_t index) {
+      auto block = local_[index];
+      if (!block) {
+        block = remote_[index].exchange(nullptr, std::memory_order_acquire);
+      }
+      if (!block) {
+        blocks_.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new((index + 1) * granularity);
+      }
+      local_[index] = block->next;
+      return block;
+    }
+
+    void deallocate(void* memory, std::size_t index) noexcept {
+      const auto block = static_cast<thread_cache::block*>(memory);
+      if (this == current()) {
+        block->next = local_[index];
+        local_[index] = block;
+        return;
+      }
+      auto head = remote_[index].load(std::memory_order_relaxed);
+      do {
+        if (head == closed()) {
+          ::operator delete(memory);
+          release(1);
+          return;
+        }
+        block->next = head;
+      } while (!remote_[index].compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+  private:
+    struct block {
+      block* next;
+    };
+
+    // Releases the owning thread's cache on thread exit.
+    // The cache itself stays alive until all frames allocated from it were released.
+    class owner {
+    public:
+      owner(thread_cache*& local, bool& closed) : local_(local), closed_(closed), cache(new frame_allocator::thread_cache) {
+      }
+
+      owner(owner&& other) = delete;
+      owner(const owner& other) = delete;
+      owner& operator=(owner&& other) = delete;
+      owner& operator=(const owner& other) = delete;
+
+      ~owner() {
+        local_ = nullptr;
+        closed_ = true;
+        cache->close();
+      }
+
+    private:
+      thread_cache*& local_;
+      bool& closed_;
+
+    public:
+      frame_allocator::thread_cache* const cache;
+    };
+
+    // Trivially destructible thread state that stays valid for frames released by other thread local destructors.
+    static thread_cache*& current() noexcept {
+      thread_local thread_cache* current = nullptr;
+      return current;
+    }
+
+    static bool& closed_thread() noexcept {
+      thread_local bool closed = false;
+      return closed;
+    }
+
+    static block* closed() noexcept {
+      static block sentinel{ nullptr };
+      return &sentinel;
+    }
+
+    void close() noexcept {
+      std::size_t count = 0;
+      for (std::size_t index = 0; index < classes; index++) {
+        for (auto block : { local_[index], remote_[index].exchange(closed(), std::memory_order_acquire) }) {
+          while (block) {
+            const auto next = block->next;
+            ::operator delete(block);
+            block = next;
+            count++;
+          }
+        }
+        local_[index] = nullptr;
+      }
+      release(count + 1);
+    }
+
+    void release(std::size_t count) noexcept {
+      if (blocks_.fetch_sub(count, std::memory_order_acq_rel) == count) {
+        delete this;
+      }
+    }
+
+    block* local_[classes] = {};
+    std::atomic<block*> remote_[classes] = {};
+    std::atomic_size_t blocks_ = 1;
+  };
+};
+
+}  // namespace ice::detail
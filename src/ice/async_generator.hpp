@@ -0,0 +1,200 @@
+#pragma once
+#include <ice/allocator.hpp>
+#include <ice/coroutine.hpp>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+
+namespace ice {
+
+template <typename T>
+class async_generator;
+
+namespace detail {
+
+template <typename T>
+class async_generator_promise {
+public:
+  using value_type = std::remove_reference_t<T>;
+  using pointer_type = value_type*;
+
+  constexpr async_generator_promise() noexcept = default;
+
+  static void* operator new(std::size_t size) {
+    return detail::frame_allocator::allocate(size);
+  }
+
+  static void operator delete(void* frame, std::size_t size) noexcept {
+    detail::frame_allocator::deallocate(frame, size);
+  }
+
+  async_generator<T> get_return_object() noexcept;
+
+  constexpr auto initial_suspend() const noexcept {
+    return ice::suspend_always{};
+  }
+
+  auto final_suspend() noexcept {
+    value_ = nullptr;
+    return awaitable{ *this, state::finished };
+  }
+
+  auto yield_value(std::remove_reference_t<T>& value) noexcept {
+    value_ = std::addressof(value);
+    return awaitable{ *this, state::suspended };
+  }
+
+  auto yield_value(std::remove_reference_t<T>&& value) noexcept {
+    value_ = std::addressof(value);
+    return awaitable{ *this, state::suspended };
+  }
+
+  constexpr void return_void() noexcept {
+  }
+
+#ifndef _MSC_VER
+  void unhandled_exception() noexcept {
+    assert(false);
+  }
+#endif
+
+  bool is_finished() const noexcept {
+    return state_.load(std::memory_order_acquire) == state::finished;
+  }
+
+  bool is_running() const noexcept {
+    const auto state = state_.load(std::memory_order_acquire);
+    return state == state::running || state == state::consumer_suspended;
+  }
+
+  // Resumes the producer and returns false if it produced the next value or finished before returning.
+  bool try_await(ice::coroutine_handle<> consumer) noexcept {
+    consumer_ = consumer;
+    state_.store(state::running, std::memory_order_release);
+    ice::coroutine_handle<async_generator_promise>::from_promise(*this).resume();
+    auto state = state::running;
+    return state_.compare_exchange_strong(state, state::consumer_suspended, std::memory_order_acq_rel, std::memory_order_acquire);
+  }
+
+  pointer_type value() const noexcept {
+    return value_;
+  }
+
+private:
+  enum class state { suspended, running, consumer_suspended, finished };
+
+  struct awaitable {
+    constexpr awaitable(async_generator_promise& promise, async_generator_promise::state state) noexcept :
+      promise_(promise), state_(state) {
+    }
+
+    constexpr bool await_ready() const noexcept {
+      return false;
+    }
+
+    ice::coroutine_handle<> await_suspend(ice::coroutine_handle<>) noexcept {
+      auto& promise = promise_;
+      if (promise.state_.exchange(state_, std::memory_order_acq_rel) == state::consumer_suspended) {
+        return promise.consumer_;
+      }
+      return ice::noop_coroutine();
+    }
+
+    constexpr void await_resume() const noexcept {
+    }
+
+    async_generator_promise& promise_;
+    const async_generator_promise::state state_;
+  };
+
+  std::atomic<state> state_{ state::suspended };
+  ice::coroutine_handle<> consumer_;
+  pointer_type value_{ nullptr };
+};
+
+}  // namespace detail
+
+// Asynchronous lazy sequence of values.
+// The producer runs only while the consumer awaits the next value, which limits
+// the number of values in flight to one. The producer may co_await any scheduler.
+// The consumer is resumed on the thread that produced the value.
+//
+// while (const auto rows = co_await source.next()) {
+//   ...
+// }
+//
+template <typename T>
+class async_generator {
+public:
+  using promise_type = detail::async_generator_promise<T>;
+  using value_type = typename promise_type::value_type;
+
+  constexpr async_generator() noexcept = default;
+
+  explicit constexpr async_generator(ice::coroutine_handle<promise_type> coroutine) noexcept : coroutine_(coroutine) {
+  }
+
+  constexpr async_generator(async_generator&& other) noexcept : coroutine_(other.coroutine_) {
+    other.coroutine_ = nullptr;
+  }
+
+  async_generator(const async_generator& other) = delete;
+  async_generator& operator=(const async_generator& other) = delete;
+
+  ~async_generator() {
+    destroy();
+  }
+
+  async_generator& operator=(async_generator&& other) noexcept {
+    if (std::addressof(other) != this) {
+      destroy();
+      coroutine_ = other.coroutine_;
+      other.coroutine_ = nullptr;
+    }
+    return *this;
+  }
+
+  // Returns a pointer to the next value or nullptr when the producer finished.
+  // The value stays valid until the next call.
+  auto next() noexcept {
+    struct awaitable {
+      bool await_ready() const noexcept {
+        return !coroutine_ || coroutine_.promise().is_finished();
+      }
+
+      bool await_suspend(ice::coroutine_handle<> consumer) noexcept {
+        return coroutine_.promise().try_await(consumer);
+      }
+
+      value_type* await_resume() const noexcept {
+        return coroutine_ ? coroutine_.promise().value() : nullptr;
+      }
+
+      ice::coroutine_handle<promise_type> coroutine_;
+    };
+    return awaitable{ coroutine_ };
+  }
+
+private:
+  void destroy() noexcept {
+    if (coroutine_) {
+      if (coroutine_.promise().is_running()) {
+        std::terminate();
+      }
+      coroutine_.destroy();
+    }
+  }
+
+  ice::coroutine_handle<promise_type> coroutine_{ nullptr };
+};
+
+template <typename T>
+async_generator<T> detail::async_generator_promise<T>::get_return_object() noexcept {
+  return async_generator<T>{ ice::coroutine_handle<async_generator_promise<T>>::from_promise(*this) };
+}
+
+}  // namespace ice
@@ -0,0 +1,61 @@
+#pragma once
+#include <ice/coroutine.hpp>
+#include <atomic>
+#include <optional>
+#include <stop_token>
+#include <utility>
+
+namespace ice {
+
+// Cancellation uses std::stop_source and std::stop_token. A stop_source allocates its shared state once
+// when it is constructed. Tokens and stop callbacks share that state without allocating.
+
+// Suspends the awaiter until a stop is requested.
+// The awaiter is resumed on the thread that requests the stop and does not suspend
+// if a stop was already requested or can never be requested.
+class when_stopped {
+public:
+  explicit when_stopped(std::stop_token token) noexcept : token_(std::move(token)) {
+  }
+
+  when_stopped(when_stopped&& other) = delete;
+  when_stopped(const when_stopped& other) = delete;
+  when_stopped& operator=(when_stopped&& other) = delete;
+  when_stopped& operator=(const when_stopped& other) = delete;
+
+  ~when_stopped() = default;
+
+  bool await_ready() const noexcept {
+    return token_.stop_requested() || !token_.stop_possible();
+  }
+
+  bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+    awaiter_ = awaiter;
+    callback_.emplace(token_, resumer{ *this });
+    return !resumed_.exchange(true, std::memory_order_acq_rel);
+  }
+
+  // Returns true if a stop was requested.
+  bool await_resume() const noexcept {
+    return token_.stop_requested();
+  }
+
+private:
+  struct resumer {
+    when_stopped& awaitable;
+
+    void operator()() noexcept {
+      // The callback may run inside await_suspend when the stop is requested concurrently.
+      if (awaitable.resumed_.exchange(true, std::memory_order_acq_rel)) {
+        awaitable.awaiter_.resume();
+      }
+    }
+  };
+
+  const std::stop_token token_;
+  ice::coroutine_handle<> awaiter_;
+  std::optional<std::stop_callback<resumer>> callback_;
+  std::atomic_bool resumed_ = false;
+};
+
+}  // namespace ice
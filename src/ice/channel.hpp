@@ -0,0 +1,382 @@
+#pragma once
+#include <ice/coroutine.hpp>
+#include <ice/scheduler.hpp>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+
+namespace ice {
+namespace detail {
+
+template <typename T>
+struct channel_waiter {
+  channel_waiter* next{ nullptr };
+  T* data{ nullptr };
+  std::optional<T>* slot{ nullptr };
+  std::size_t size{ 0 };
+  std::size_t done{ 0 };
+  ice::coroutine_handle<> awaiter;
+  void (*resume)(channel_waiter& waiter) noexcept { nullptr };
+};
+
+template <typename T>
+class channel_queue {
+public:
+  bool empty() const noexcept {
+    return !head_;
+  }
+
+  channel_waiter<T>* front() const noexcept {
+    return head_;
+  }
+
+  void push(channel_waiter<T>* waiter) noexcept {
+    waiter->next = nullptr;
+    if (tail_) {
+      tail_->next = waiter;
+    } else {
+      head_ = waiter;
+    }
+    tail_ = waiter;
+  }
+
+  channel_waiter<T>* pop() noexcept {
+    const auto waiter = head_;
+    head_ = waiter->next;
+    if (!head_) {
+      tail_ = nullptr;
+    }
+    return waiter;
+  }
+
+  channel_waiter<T>* take() noexcept {
+    tail_ = nullptr;
+    return std::exchange(head_, nullptr);
+  }
+
+private:
+  channel_waiter<T>* head_{ nullptr };
+  channel_waiter<T>* tail_{ nullptr };
+};
+
+}  // namespace detail
+
+// Bounded multi-producer multi-consumer queue of up to N values.
+// Senders suspend while the channel is full and receivers suspend while it is empty.
+// Suspended awaiters are resumed on the thread that completed them, or through the
+// scheduler passed to send or receive. The batch variants lock the channel once per call.
+//
+// while (auto row = co_await rows.receive(context)) {
+//   ...
+// }
+//
+template <typename T, std::size_t N>
+class channel {
+public:
+  static_assert(N > 0);
+  static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>);
+
+  using value_type = T;
+
+  channel() noexcept = default;
+
+  channel(channel&& other) = delete;
+  channel(const channel& other) = delete;
+  channel& operator=(channel&& other) = delete;
+  channel& operator=(const channel& other) = delete;
+
+  ~channel() {
+    assert(senders_.empty() && receivers_.empty());
+    while (size_) {
+      std::destroy_at(at(head_));
+      head_ = (head_ + 1) % N;
+      size_--;
+    }
+  }
+
+  constexpr static std::size_t capacity() noexcept {
+    return N;
+  }
+
+  // Sends a value and returns false if the channel was closed.
+  auto send(T value) noexcept {
+    return send_awaitable<void>{ *this, std::move(value) };
+  }
+
+  template <typename Scheduler>
+  auto send(T value, Scheduler& scheduler) noexcept {
+    return send_awaitable<Scheduler>{ *this, std::move(value), scheduler };
+  }
+
+  // Sends all values in order and returns the number of values sent before the channel was closed.
+  // The values are moved from and must stay valid until the operation completes.
+  auto send_many(std::span<T> values) noexcept {
+    return send_many_awaitable<void>{ *this, values };
+  }
+
+  template <typename Scheduler>
+  auto send_many(std::span<T> values, Scheduler& scheduler) noexcept {
+    return send_many_awaitable<Scheduler>{ *this, values, scheduler };
+  }
+
+  // Receives a value or std::nullopt if the channel was closed and is empty.
+  auto receive() noexcept {
+    return receive_awaitable<void>{ *this };
+  }
+
+  template <typename Scheduler>
+  auto receive(Scheduler& scheduler) noexcept {
+    return receive_awaitable<Scheduler>{ *this, scheduler };
+  }
+
+  // Receives at least one and up to values.size() values and returns their number.
+  // Returns 0 if the channel was closed and is empty.
+  auto receive_many(std::span<T> values) noexcept {
+    return receive_many_awaitable<void>{ *this, values };
+  }
+
+  template <typename Scheduler>
+  auto receive_many(std::span<T> values, Scheduler& scheduler) noexcept {
+    return receive_many_awaitable<Scheduler>{ *this, values, scheduler };
+  }
+
+  // Resumes all suspended senders and receivers.
+  // Values that were already sent can still be received.
+  void close() noexcept {
+    std::unique_lock lock{ mutex_ };
+    closed_ = true;
+    auto senders = senders_.take();
+    auto receivers = receivers_.take();
+    lock.unlock();
+    resume(senders);
+    resume(receivers);
+  }
+
+  bool is_closed() const noexcept {
+    std::lock_guard lock{ mutex_ };
+    return closed_;
+  }
+
+private:
+  using waiter = detail::channel_waiter<T>;
+
+  template <typename Scheduler>
+  class awaitable_base : public waiter, detail::resumer<Scheduler> {
+  public:
+    template <typename... Args>
+    awaitable_base(channel& channel, Args&... scheduler) noexcept : detail::resumer<Scheduler>(scheduler...), channel_(channel) {
+      waiter::resume = &resume_awaiter;
+    }
+
+    awaitable_base(awaitable_base&& other) = delete;
+    awaitable_base(const awaitable_base& other) = delete;
+    awaitable_base& operator=(awaitable_base&& other) = delete;
+    awaitable_base& operator=(const awaitable_base& other) = delete;
+
+    ~awaitable_base() = default;
+
+    constexpr bool await_ready() const noexcept {
+      return this->done == this->size;
+    }
+
+  protected:
+    channel& channel_;
+
+  private:
+    static void resume_awaiter(waiter& waiter) noexcept {
+      auto& self = static_cast<awaitable_base&>(waiter);
+      self.detail::resumer<Scheduler>::resume(self.awaiter);
+    }
+  };
+
+  template <typename Scheduler>
+  class send_awaitable : public awaitable_base<Scheduler> {
+  public:
+    template <typename... Args>
+    send_awaitable(channel& channel, T&& value, Args&... scheduler) noexcept :
+      awaitable_base<Scheduler>(channel, scheduler...), value_(std::move(value)) {
+      this->data = std::addressof(value_);
+      this->size = 1;
+    }
+
+    bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+      this->awaiter = awaiter;
+      return this->channel_.try_send(*this);
+    }
+
+    bool await_resume() const noexcept {
+      return this->done == 1;
+    }
+
+  private:
+    T value_;
+  };
+
+  template <typename Scheduler>
+  class send_many_awaitable : public awaitable_base<Scheduler> {
+  public:
+    template <typename... Args>
+    send_many_awaitable(channel& channel, std::span<T> values, Args&... scheduler) noexcept :
+      awaitable_base<Scheduler>(channel, scheduler...) {
+      this->data = values.data();
+      this->size = values.size();
+    }
+
+    bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+      this->awaiter = awaiter;
+      return this->channel_.try_send(*this);
+    }
+
+    std::size_t await_resume() const noexcept {
+      return this->done;
+    }
+  };
+
+  template <typename Scheduler>
+  class receive_awaitable : public awaitable_base<Scheduler> {
+  public:
+    template <typename... Args>
+    receive_awaitable(channel& channel, Args&... scheduler) noexcept : awaitable_base<Scheduler>(channel, scheduler...) {
+      this->slot = std::addressof(value_);
+      this->size = 1;
+    }
+
+    bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+      this->awaiter = awaiter;
+      return this->channel_.try_receive(*this);
+    }
+
+    std::optional<T> await_resume() noexcept {
+      return std::move(value_);
+    }
+
+  private:
+    std::optional<T> value_;
+  };
+
+  template <typename Scheduler>
+  class receive_many_awaitable : public awaitable_base<Scheduler> {
+  public:
+    template <typename... Args>
+    receive_many_awaitable(channel& channel, std::span<T> values, Args&... scheduler) noexcept :
+      awaitable_base<Scheduler>(channel, scheduler...) {
+      this->data = values.data();
+      this->size = values.size();
+    }
+
+    bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+      this->awaiter = awaiter;
+      return this->channel_.try_receive(*this);
+    }
+
+    std::size_t await_resume() const noexcept {
+      return this->done;
+    }
+  };
+
+  // Hands values to suspended receivers and then to the buffer.
+  // Returns true if the sender was suspended.
+  bool try_send(waiter& sender) noexcept {
+    std::unique_lock lock{ mutex_ };
+    if (closed_) {
+      return false;
+    }
+    detail::channel_queue<T> ready;
+    while (sender.done < sender.size && !receivers_.empty()) {
+      const auto receiver = receivers_.front();
+      while (sender.done < sender.size && receiver->done < receiver->size) {
+        put(*receiver, std::move(sender.data[sender.done++]));
+      }
+      ready.push(receivers_.pop());
+    }
+    while (sender.done < sender.size && size_ < N) {
+      std::construct_at(at((head_ + size_) % N), std::move(sender.data[sender.done++]));
+      size_++;
+    }
+    const auto suspend = sender.done < sender.size;
+    if (suspend) {
+      senders_.push(std::addressof(sender));
+    }
+    lock.unlock();
+    resume(ready.take());
+    return suspend;
+  }
+
+  // Takes values from the buffer and suspended senders and then refills the buffer.
+  // Returns true if the receiver was suspended.
+  bool try_receive(waiter& receiver) noexcept {
+    std::unique_lock lock{ mutex_ };
+    detail::channel_queue<T> ready;
+    while (receiver.done < receiver.size) {
+      if (size_) {
+        const auto value = at(head_);
+        put(receiver, std::move(*value));
+        std::destroy_at(value);
+        head_ = (head_ + 1) % N;
+        size_--;
+      } else if (!senders_.empty()) {
+        const auto sender = senders_.front();
+        put(receiver, std::move(sender->data[sender->done++]));
+        if (sender->done == sender->size) {
+          ready.push(senders_.pop());
+        }
+      } else {
+        break;
+      }
+    }
+    while (size_ < N && !senders_.empty()) {
+      const auto sender = senders_.front();
+      while (size_ < N && sender->done < sender->size) {
+        std::construct_at(at((head_ + size_) % N), std::move(sender->data[sender->done++]));
+        size_++;
+      }
+      if (sender->done == sender->size) {
+        ready.push(senders_.pop());
+      }
+    }
+    const auto suspend = receiver.done == 0 && !closed_;
+    if (suspend) {
+      receivers_.push(std::addressof(receiver));
+    }
+    lock.unlock();
+    resume(ready.take());
+    return suspend;
+  }
+
+  static void put(waiter& receiver, T&& value) noexcept {
+    if (receiver.slot) {
+      receiver.slot->emplace(std::move(value));
+    } else {
+      receiver.data[receiver.done] = std::move(value);
+    }
+    receiver.done++;
+  }
+
+  static void resume(waiter* head) noexcept {
+    while (head) {
+      const auto next = head->next;
+      head->resume(*head);
+      head = next;
+    }
+  }
+
+  T* at(std::size_t index) noexcept {
+    return std::launder(reinterpret_cast<T*>(storage_) + index);
+  }
+
+  alignas(T) std::byte storage_[sizeof(T) * N];
+  std::size_t head_{ 0 };
+  std::size_t size_{ 0 };
+  bool closed_{ false };
+  detail::channel_queue<T> senders_;
+  detail::channel_queue<T> receivers_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace ice
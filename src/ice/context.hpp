@@ -1,57 +1,261 @@
 #pragma once
+#include <ice/coroutine.hpp>
 #include <ice/scheduler.hpp>
+#include <ice/utility.hpp>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <optional>
+#include <stop_token>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace ice {
 
-class context final : public scheduler<context> {
+class context final : public scheduler<context, ice::mpsc_queue> {
 public:
+  using clock = std::chrono::steady_clock;
+
+  class timer {
+  public:
+    timer(context& context, clock::time_point time, std::stop_token token = {}) noexcept :
+      context_(context), time_(time), token_(std::move(token)) {
+    }
+
+    timer(timer&& other) = delete;
+    timer(const timer& other) = delete;
+    timer& operator=(timer&& other) = delete;
+    timer& operator=(const timer& other) = delete;
+
+    ~timer() = default;
+
+    bool await_ready() const noexcept {
+      return token_.stop_requested();
+    }
+
+    void await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+      awaiter_ = awaiter;
+      if (token_.stop_possible()) {
+        callback_.emplace(token_, canceller{ context_ });
+      }
+      context_.post(this);
+    }
+
+    // Returns false if a stop was requested.
+    bool await_resume() const noexcept {
+      return !token_.stop_requested();
+    }
+
+    void resume() noexcept {
+#ifdef ICE_STATISTICS
+      auto& statistics = detail::statistics_registry::local();
+      const auto deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(time_.time_since_epoch()).count();
+      const auto resumed = detail::statistics_now();
+      statistics.resume_latency.add(detail::statistics_elapsed(static_cast<std::uint64_t>(deadline), resumed));
+      awaiter_.resume();
+      statistics.run_time.add(detail::statistics_elapsed(resumed, detail::statistics_now()));
+#else
+      awaiter_.resume();
+#endif
+    }
+
+  private:
+    friend class context;
+
+    struct canceller {
+      context& owner;
+
+      void operator()() noexcept {
+        owner.cancel();
+      }
+    };
+
+    context& context_;
+    const clock::time_point time_;
+    const std::stop_token token_;
+    std::optional<std::stop_callback<canceller>> callback_;
+    ice::coroutine_handle<> awaiter_;
+    timer* next_{ nullptr };
+  };
+
+  // Resumes expired timers first and then one schedule at a time by priority, so that
+  // interactive work posted while bulk work is queued runs after the current schedule.
   void run() noexcept {
     thread_.store(std::this_thread::get_id(), std::memory_order_release);
-    std::unique_lock lock{ mutex_ };
-    lock.unlock();
     while (true) {
-      lock.lock();
-      auto head = acquire();
-      while (!head) {
+      auto timers = expire();
+      const auto expired = timers != nullptr;
+      while (timers) {
+        auto next = timers->next_;
+        timers->resume();
+        timers = next;
+      }
+      if (const auto schedule = next()) {
+        schedule->resume();
+        continue;
+      }
+      if (!expired) {
         if (stop_.load(std::memory_order_acquire)) {
-          lock.unlock();
           return;
         }
-        cv_.wait(lock, [&]() {
-          head = acquire();
-          return head || stop_.load(std::memory_order_acquire);
-        });
-      }
-      lock.unlock();
-      while (head) {
-        auto next = head->next.load(std::memory_order_relaxed);
-        head->resume();
-        head = next;
+        wait();
       }
     }
   }
 
+  timer schedule_at(clock::time_point time, std::stop_token token = {}) noexcept {
+    return { *this, time, std::move(token) };
+  }
+
+  timer schedule_after(clock::duration duration, std::stop_token token = {}) noexcept {
+    return { *this, clock::now() + duration, std::move(token) };
+  }
+
   bool is_current() const noexcept {
     return thread_.load(std::memory_order_acquire) == std::this_thread::get_id();
   }
 
   void stop(bool stop = true) noexcept {
     stop_.store(stop, std::memory_order_release);
-    cv_.notify_all();
+    wake();
   }
 
   void post(ice::schedule<context>* schedule) noexcept {
     scheduler::post(schedule);
-    cv_.notify_one();
+    wake();
+  }
+
+  void post_batch(ice::schedule<context>* first, ice::schedule<context>* last) noexcept {
+    scheduler::post_batch(first, last);
+    wake();
+  }
+
+  void post(timer* timer) noexcept {
+    auto head = timers_head_.load(std::memory_order_acquire);
+    do {
+      timer->next_ = head;
+    } while (!timers_head_.compare_exchange_weak(head, timer, std::memory_order_release, std::memory_order_acquire));
+    wake();
   }
 
 private:
+  // Makes the run loop expire timers with a stop request before their deadline.
+  void cancel() noexcept {
+    cancelled_.store(true, std::memory_order_release);
+    wake();
+  }
+
+  // Number of times the run loop polls for new work before the thread is parked.
+  constexpr static int spin_count = 64;
+
+  // The run loop publishes how it is parked so that posts to a busy context only cost a fence and a load.
+  // Untimed waits park on the state itself, waits with a pending timer use the condition variable.
+  enum class state { running, sleeping, waiting };
+
+  bool ready() const noexcept {
+    return !empty() || timers_head_.load(std::memory_order_relaxed) || cancelled_.load(std::memory_order_relaxed) ||
+      stop_.load(std::memory_order_relaxed);
+  }
+
+  void wait() noexcept {
+    for (int i = 0; i < spin_count; i++) {
+      if (ready()) {
+        return;
+      }
+      ice::pause();
+    }
+    if (timers_.empty()) {
+      state_.store(state::sleeping, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!ready()) {
+        state_.wait(state::sleeping, std::memory_order_acquire);
+      }
+    } else {
+      std::unique_lock lock{ mutex_ };
+      state_.store(state::waiting, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!ready()) {
+        cv_.wait_until(lock, timers_.front()->time_, [this]() { return state_.load(std::memory_order_acquire) != state::waiting; });
+      }
+    }
+    state_.store(state::running, std::memory_order_relaxed);
+  }
+
+  void wake() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (state_.load(std::memory_order_relaxed) == state::running) {
+      return;
+    }
+    switch (state_.exchange(state::running, std::memory_order_acq_rel)) {
+    case state::running:
+      break;
+    case state::sleeping:
+      state_.notify_one();
+      break;
+    case state::waiting: {
+      std::lock_guard lock{ mutex_ };
+      cv_.notify_one();
+      break;
+    }
+    }
+  }
+
+  static bool compare(const timer* lhs, const timer* rhs) noexcept {
+    return lhs->time_ > rhs->time_;
+  }
+
+  // Moves posted timers to the heap, removes expired timers from the heap and returns them as a list ordered by time.
+  // Timers with a stop request expire immediately.
+  timer* expire() noexcept {
+    timer* head = nullptr;
+    timer* tail = nullptr;
+    const auto append = [&](timer* expired) {
+      expired->next_ = nullptr;
+      if (tail) {
+        tail->next_ = expired;
+      } else {
+        head = expired;
+      }
+      tail = expired;
+    };
+    if (cancelled_.load(std::memory_order_relaxed) && cancelled_.exchange(false, std::memory_order_acquire)) {
+      const auto it = std::partition(timers_.begin(), timers_.end(), [](const timer* timer) { return !timer->token_.stop_requested(); });
+      std::for_each(it, timers_.end(), append);
+      timers_.erase(it, timers_.end());
+      std::make_heap(timers_.begin(), timers_.end(), compare);
+    }
+    auto posted = timers_head_.load(std::memory_order_relaxed) ? timers_head_.exchange(nullptr, std::memory_order_acquire) : nullptr;
+    while (posted) {
+      const auto next = posted->next_;
+      if (posted->token_.stop_requested()) {
+        append(posted);
+      } else {
+        timers_.push_back(posted);
+        std::push_heap(timers_.begin(), timers_.end(), compare);
+      }
+      posted = next;
+    }
+    if (timers_.empty()) {
+      return head;
+    }
+    const auto now = clock::now();
+    while (!timers_.empty() && timers_.front()->time_ <= now) {
+      std::pop_heap(timers_.begin(), timers_.end(), compare);
+      append(timers_.back());
+      timers_.pop_back();
+    }
+    return head;
+  }
+
   std::atomic_bool stop_ = false;
+  std::atomic_bool cancelled_ = false;
+  std::atomic<state> state_ = state::running;
   std::atomic<std::thread::id> thread_;
+  std::atomic<timer*> timers_head_ = nullptr;
+  std::vector<timer*> timers_;
   std::condition_variable cv_;
   std::mutex mutex_;
 };
@@ -0,0 +1,26 @@
+#pragma once
+
+// Uses standard coroutines when the compiler implements them and the coroutines TS otherwise.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+
+namespace ice {
+
+using std::coroutine_handle;
+using std::noop_coroutine;
+using std::suspend_always;
+using std::suspend_never;
+
+}  // namespace ice
+#else
+#include <experimental/coroutine>
+
+namespace ice {
+
+using std::experimental::coroutine_handle;
+using std::experimental::noop_coroutine;
+using std::experimental::suspend_always;
+using std::experimental::suspend_never;
+
+}  // namespace ice
+#endif
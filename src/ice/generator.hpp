@@ -0,0 +1,177 @@
+#pragma once
+#include <ice/allocator.hpp>
+#include <ice/coroutine.hpp>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+
+namespace ice {
+
+template <typename T>
+class generator;
+
+namespace detail {
+
+template <typename T>
+class generator_promise {
+public:
+  using value_type = std::remove_reference_t<T>;
+  using reference_type = std::conditional_t<std::is_reference_v<T>, T, T&>;
+  using pointer_type = value_type*;
+
+  constexpr generator_promise() noexcept = default;
+
+  static void* operator new(std::size_t size) {
+    return detail::frame_allocator::allocate(size);
+  }
+
+  static void operator delete(void* frame, std::size_t size) noexcept {
+    detail::frame_allocator::deallocate(frame, size);
+  }
+
+  generator<T> get_return_object() noexcept;
+
+  constexpr auto initial_suspend() const noexcept {
+    return ice::suspend_always{};
+  }
+
+  constexpr auto final_suspend() const noexcept {
+    return ice::suspend_always{};
+  }
+
+  auto yield_value(std::remove_reference_t<T>& value) noexcept {
+    value_ = std::addressof(value);
+    return ice::suspend_always{};
+  }
+
+  auto yield_value(std::remove_reference_t<T>&& value) noexcept {
+    value_ = std::addressof(value);
+    return ice::suspend_always{};
+  }
+
+  constexpr void return_void() noexcept {
+  }
+
+#ifndef _MSC_VER
+  void unhandled_exception() noexcept {
+    assert(false);
+  }
+#endif
+
+  // Disallows co_await in generator coroutines.
+  template <typename U>
+  ice::suspend_never await_transform(U&& value) = delete;
+
+  reference_type value() const noexcept {
+    return static_cast<reference_type>(*value_);
+  }
+
+private:
+  pointer_type value_{ nullptr };
+};
+
+struct generator_sentinel {};
+
+template <typename T>
+class generator_iterator {
+public:
+  using coroutine_handle = ice::coroutine_handle<generator_promise<T>>;
+
+  using iterator_category = std::input_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = typename generator_promise<T>::value_type;
+  using reference = typename generator_promise<T>::reference_type;
+  using pointer = typename generator_promise<T>::pointer_type;
+
+  constexpr generator_iterator() noexcept = default;
+
+  explicit constexpr generator_iterator(coroutine_handle coroutine) noexcept : coroutine_(coroutine) {
+  }
+
+  friend bool operator==(const generator_iterator& it, generator_sentinel) noexcept {
+    return !it.coroutine_ || it.coroutine_.done();
+  }
+
+  generator_iterator& operator++() noexcept {
+    coroutine_.resume();
+    return *this;
+  }
+
+  void operator++(int) noexcept {
+    ++*this;
+  }
+
+  reference operator*() const noexcept {
+    return coroutine_.promise().value();
+  }
+
+  pointer operator->() const noexcept {
+    return std::addressof(operator*());
+  }
+
+private:
+  coroutine_handle coroutine_{ nullptr };
+};
+
+}  // namespace detail
+
+// Synchronous lazy sequence of values.
+template <typename T>
+class generator {
+public:
+  using promise_type = detail::generator_promise<T>;
+  using iterator = detail::generator_iterator<T>;
+
+  constexpr generator() noexcept = default;
+
+  explicit constexpr generator(ice::coroutine_handle<promise_type> coroutine) noexcept : coroutine_(coroutine) {
+  }
+
+  constexpr generator(generator&& other) noexcept : coroutine_(other.coroutine_) {
+    other.coroutine_ = nullptr;
+  }
+
+  generator(const generator& other) = delete;
+  generator& operator=(const generator& other) = delete;
+
+  ~generator() {
+    if (coroutine_) {
+      coroutine_.destroy();
+    }
+  }
+
+  generator& operator=(generator&& other) noexcept {
+    if (std::addressof(other) != this) {
+      if (coroutine_) {
+        coroutine_.destroy();
+      }
+      coroutine_ = other.coroutine_;
+      other.coroutine_ = nullptr;
+    }
+    return *this;
+  }
+
+  iterator begin() noexcept {
+    if (coroutine_) {
+      coroutine_.resume();
+    }
+    return iterator{ coroutine_ };
+  }
+
+  constexpr detail::generator_sentinel end() const noexcept {
+    return {};
+  }
+
+private:
+  ice::coroutine_handle<promise_type> coroutine_{ nullptr };
+};
+
+template <typename T>
+generator<T> detail::generator_promise<T>::get_return_object() noexcept {
+  return generator<T>{ ice::coroutine_handle<generator_promise<T>>::from_promise(*this) };
+}
+
+}  // namespace ice
@@ -0,0 +1,533 @@
+#pragma once
+#include <ice/coroutine.hpp>
+#include <ice/pool.hpp>
+#include <ice/scheduler.hpp>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace ice {
+
+#ifdef _WIN32
+using native_handle = HANDLE;
+#else
+using native_handle = int;
+#endif
+
+struct io_result {
+  std::size_t size = 0;
+  std::error_code error;
+
+  explicit operator bool() const noexcept {
+    return !error;
+  }
+};
+
+#ifndef _WIN32
+namespace detail {
+
+// Minimal io_uring wrapper on top of the raw system calls.
+class uring {
+public:
+  uring() noexcept = default;
+
+  uring(uring&& other) = delete;
+  uring(const uring& other) = delete;
+  uring& operator=(uring&& other) = delete;
+  uring& operator=(const uring& other) = delete;
+
+  ~uring() {
+    close();
+  }
+
+  bool open(unsigned entries) noexcept {
+    io_uring_params params = {};
+    fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd_ < 0) {
+      return false;
+    }
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    const auto single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+      sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+    constexpr auto protection = PROT_READ | PROT_WRITE;
+    constexpr auto flags = MAP_SHARED | MAP_POPULATE;
+    sq_ = mmap(nullptr, sq_size_, protection, flags, fd_, IORING_OFF_SQ_RING);
+    if (sq_ == MAP_FAILED) {
+      sq_ = nullptr;
+      return close();
+    }
+    cq_ = single ? sq_ : mmap(nullptr, cq_size_, protection, flags, fd_, IORING_OFF_CQ_RING);
+    if (cq_ == MAP_FAILED) {
+      cq_ = nullptr;
+      return close();
+    }
+    const auto sqes = mmap(nullptr, sqes_size_, protection, flags, fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return close();
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+    const auto sq = static_cast<char*>(sq_);
+    const auto cq = static_cast<char*>(cq_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    cq_entries_ = params.cq_entries;
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  bool close() noexcept {
+    if (sqes_) {
+      munmap(sqes_, sqes_size_);
+      sqes_ = nullptr;
+    }
+    if (cq_ && cq_ != sq_) {
+      munmap(cq_, cq_size_);
+    }
+    cq_ = nullptr;
+    if (sq_) {
+      munmap(sq_, sq_size_);
+      sq_ = nullptr;
+    }
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+    return false;
+  }
+
+  // Returns the number of completion queue entries.
+  unsigned completions() const noexcept {
+    return cq_entries_;
+  }
+
+  // Returns the next free submission queue entry or nullptr if the queue is full.
+  io_uring_sqe* get() noexcept {
+    const auto head = std::atomic_ref(*sq_head_).load(std::memory_order_acquire);
+    if (tail_ - head >= sq_entries_) {
+      return nullptr;
+    }
+    const auto index = tail_ & sq_mask_;
+    sq_array_[index] = index;
+    tail_++;
+    const auto sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+  }
+
+  // Publishes prepared entries, submits them and optionally waits for completions.
+  int enter(unsigned wait) noexcept {
+    const auto tail = std::atomic_ref(*sq_tail_).load(std::memory_order_relaxed);
+    const auto submit = tail_ - tail;
+    std::atomic_ref(*sq_tail_).store(tail_, std::memory_order_release);
+    if (!submit && !wait) {
+      return 0;
+    }
+    const auto flags = wait ? IORING_ENTER_GETEVENTS : 0u;
+    int result = 0;
+    do {
+      result = static_cast<int>(syscall(__NR_io_uring_enter, fd_, submit, wait, flags, nullptr, 0));
+    } while (result < 0 && errno == EINTR);
+    return result;
+  }
+
+  // Calls the handler for each completion queue entry and returns the number of entries.
+  template <typename Handler>
+  unsigned reap(Handler&& handler) noexcept {
+    auto head = std::atomic_ref(*cq_head_).load(std::memory_order_relaxed);
+    const auto tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+    const auto count = tail - head;
+    while (head != tail) {
+      const auto& cqe = cqes_[head & cq_mask_];
+      const auto data = cqe.user_data;
+      const auto result = cqe.res;
+      head++;
+      std::atomic_ref(*cq_head_).store(head, std::memory_order_release);
+      handler(data, result);
+    }
+    return count;
+  }
+
+private:
+  int fd_ = -1;
+  void* sq_ = nullptr;
+  void* cq_ = nullptr;
+  std::size_t sq_size_ = 0;
+  std::size_t cq_size_ = 0;
+  std::size_t sqes_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned cq_mask_ = 0;
+  unsigned cq_entries_ = 0;
+  unsigned tail_ = 0;
+};
+
+}  // namespace detail
+#endif
+
+// Scheduler for asynchronous file operations.
+// On Linux, operations are submitted to io_uring by the thread that calls run() and the
+// awaiter is resumed on that thread. When io_uring is not available and on Windows,
+// operations are executed on a pool of worker threads and the awaiter is resumed there.
+class io_context final : public scheduler<io_context> {
+public:
+  class operation {
+  public:
+    enum class type { read, write };
+
+    operation(io_context& context, type type, native_handle file, std::uint64_t offset, void* data, std::size_t size) noexcept :
+      context_(context), type_(type), file_(file), offset_(offset), data_(data), size_(size) {
+    }
+
+    operation(operation&& other) = delete;
+    operation(const operation& other) = delete;
+    operation& operator=(operation&& other) = delete;
+    operation& operator=(const operation& other) = delete;
+
+    ~operation() = default;
+
+    constexpr bool await_ready() const noexcept {
+      return false;
+    }
+
+    void await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+      awaiter_ = awaiter;
+      if (context_.pool_) {
+        fallback_.emplace(*context_.pool_, true);
+        fallback_->await_suspend(awaiter);
+      } else {
+        context_.post(this);
+      }
+    }
+
+    io_result await_resume() noexcept {
+      if (fallback_) {
+        execute();
+      }
+      return result_;
+    }
+
+  private:
+    friend class io_context;
+
+    void execute() noexcept {
+#ifdef _WIN32
+      OVERLAPPED overlapped = {};
+      overlapped.Offset = static_cast<DWORD>(offset_);
+      overlapped.OffsetHigh = static_cast<DWORD>(offset_ >> 32);
+      const auto size = static_cast<DWORD>(std::min(size_, std::size_t(0xFFFFFFFF)));
+      DWORD transferred = 0;
+      const auto success = type_ == type::read ? ReadFile(file_, data_, size, &transferred, &overlapped) :
+                                                 WriteFile(file_, data_, size, &transferred, &overlapped);
+      if (!success && GetLastError() != ERROR_HANDLE_EOF) {
+        result_.error = std::error_code(static_cast<int>(GetLastError()), std::system_category());
+      }
+      result_.size = transferred;
+#else
+      // A single call transfers at most 0x7FFFF000 bytes, larger operations continue where it stopped.
+      ssize_t size = 0;
+      do {
+        const auto data = static_cast<char*>(data_) + result_.size;
+        const auto offset = static_cast<off_t>(offset_ + result_.size);
+        const auto rest = size_ - result_.size;
+        do {
+          size = type_ == type::read ? pread(file_, data, rest, offset) : pwrite(file_, data, rest, offset);
+        } while (size < 0 && errno == EINTR);
+      } while (!complete(size < 0 ? -errno : size));
+#endif
+    }
+
+    // Adds the result of a transfer, which is the number of bytes or a negative error code.
+    // Returns false if the operation must continue after a partial transfer.
+    bool complete(std::int64_t result) noexcept {
+      if (result < 0) {
+        result_.error = std::error_code(static_cast<int>(-result), std::system_category());
+        return true;
+      }
+      result_.size += static_cast<std::size_t>(result);
+      return result == 0 || result_.size >= size_;
+    }
+
+    io_context& context_;
+    const type type_;
+    const native_handle file_;
+    const std::uint64_t offset_;
+    void* const data_;
+    const std::size_t size_;
+    ice::coroutine_handle<> awaiter_;
+    std::optional<ice::schedule<ice::pool>> fallback_;
+#ifndef _WIN32
+    iovec iovec_ = {};
+#endif
+    io_result result_;
+    operation* next_{ nullptr };
+  };
+
+  // Creates an io_uring instance with the given number of submission queue entries.
+  // Falls back to a pool with the given number of threads when io_uring is not available,
+  // which is always the case for zero entries.
+  explicit io_context(unsigned entries = 256, std::size_t threads = std::thread::hardware_concurrency()) {
+#ifndef _WIN32
+    if (ring_.open(entries)) {
+      event_ = eventfd(0, EFD_CLOEXEC);
+      if (event_ >= 0) {
+        return;
+      }
+      ring_.close();
+    }
+#endif
+    pool_ = std::make_unique<ice::pool>(threads);
+  }
+
+  io_context(io_context&& other) = delete;
+  io_context(const io_context& other) = delete;
+  io_context& operator=(io_context&& other) = delete;
+  io_context& operator=(const io_context& other) = delete;
+
+  ~io_context() {
+#ifndef _WIN32
+    if (event_ >= 0) {
+      ::close(event_);
+    }
+#endif
+  }
+
+  // Returns true if operations are executed on a pool of worker threads.
+  bool is_fallback() const noexcept {
+    return static_cast<bool>(pool_);
+  }
+
+  void run() noexcept {
+    thread_.store(std::this_thread::get_id(), std::memory_order_release);
+    while (true) {
+      auto work = false;
+      if (auto head = acquire()) {
+        work = true;
+        while (head) {
+          const auto next = static_cast<ice::schedule<io_context>*>(head->next.load(std::memory_order_relaxed));
+          head->resume();
+          head = next;
+        }
+      }
+#ifndef _WIN32
+      if (!pool_) {
+        if (process()) {
+          continue;
+        }
+        if (!work && wait()) {
+          return;
+        }
+        continue;
+      }
+#endif
+      if (!work) {
+        if (stop_.load(std::memory_order_acquire)) {
+          return;
+        }
+        sleeping_.store(true, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (empty() && !stop_.load(std::memory_order_acquire)) {
+          sleeping_.wait(true, std::memory_order_acquire);
+        }
+        sleeping_.store(false, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool is_current() const noexcept {
+    return thread_.load(std::memory_order_acquire) == std::this_thread::get_id();
+  }
+
+  void stop(bool stop = true) noexcept {
+    stop_.store(stop, std::memory_order_release);
+    wake();
+  }
+
+  void post(ice::schedule<io_context>* schedule) noexcept {
+    scheduler::post(schedule);
+    wake();
+  }
+
+  void post_batch(ice::schedule<io_context>* first, ice::schedule<io_context>* last) noexcept {
+    scheduler::post_batch(first, last);
+    wake();
+  }
+
+  void post(operation* operation) noexcept {
+    auto head = operations_.load(std::memory_order_acquire);
+    do {
+      operation->next_ = head;
+    } while (!operations_.compare_exchange_weak(head, operation, std::memory_order_release, std::memory_order_acquire));
+    wake();
+  }
+
+  operation read_at(native_handle file, std::uint64_t offset, void* data, std::size_t size) noexcept {
+    return { *this, operation::type::read, file, offset, data, size };
+  }
+
+  operation write_at(native_handle file, std::uint64_t offset, const void* data, std::size_t size) noexcept {
+    return { *this, operation::type::write, file, offset, const_cast<void*>(data), size };
+  }
+
+private:
+  void wake() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!sleeping_.load(std::memory_order_relaxed) || !sleeping_.exchange(false, std::memory_order_acq_rel)) {
+      return;
+    }
+#ifndef _WIN32
+    if (!pool_) {
+      const std::uint64_t value = 1;
+      [[maybe_unused]] const auto size = ::write(event_, &value, sizeof(value));
+      return;
+    }
+#endif
+    sleeping_.notify_one();
+  }
+
+#ifndef _WIN32
+  // Moves posted operations to the submission queue and resumes completed operations.
+  // Returns true if any work was done.
+  bool process() noexcept {
+    if (auto head = operations_.exchange(nullptr, std::memory_order_acquire)) {
+      operation* prev = nullptr;
+      while (head) {
+        const auto next = head->next_;
+        head->next_ = prev;
+        prev = head;
+        head = next;
+      }
+      if (pending_tail_) {
+        pending_tail_->next_ = prev;
+      } else {
+        pending_head_ = prev;
+      }
+      while (prev->next_) {
+        prev = prev->next_;
+      }
+      pending_tail_ = prev;
+    }
+    if (!armed_) {
+      if (const auto sqe = ring_.get()) {
+        event_iovec_ = { &event_value_, sizeof(event_value_) };
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = event_;
+        sqe->addr = reinterpret_cast<std::uint64_t>(&event_iovec_);
+        sqe->len = 1;
+        sqe->user_data = 0;
+        armed_ = true;
+      }
+    }
+    // Operations in flight and the event read must fit into the completion queue, which would overflow otherwise.
+    auto submitted = false;
+    while (pending_head_ && inflight_ + 1 < ring_.completions()) {
+      const auto sqe = ring_.get();
+      if (!sqe) {
+        break;
+      }
+      const auto operation = pending_head_;
+      pending_head_ = operation->next_;
+      if (!pending_head_) {
+        pending_tail_ = nullptr;
+      }
+      const auto done = operation->result_.size;
+      operation->iovec_ = { static_cast<char*>(operation->data_) + done, operation->size_ - done };
+      sqe->opcode = operation->type_ == operation::type::read ? IORING_OP_READV : IORING_OP_WRITEV;
+      sqe->fd = operation->file_;
+      sqe->off = operation->offset_ + done;
+      sqe->addr = reinterpret_cast<std::uint64_t>(&operation->iovec_);
+      sqe->len = 1;
+      sqe->user_data = reinterpret_cast<std::uint64_t>(operation);
+      submitted = true;
+      inflight_++;
+    }
+    if (submitted) {
+      ring_.enter(0);
+    }
+    const auto completed = ring_.reap([this](std::uint64_t data, int result) {
+      if (!data) {
+        armed_ = false;
+        return;
+      }
+      const auto operation = reinterpret_cast<io_context::operation*>(data);
+      inflight_--;
+      if (!operation->complete(result)) {
+        // Submits the rest of a partial transfer again.
+        operation->next_ = pending_head_;
+        pending_head_ = operation;
+        if (!pending_tail_) {
+          pending_tail_ = operation;
+        }
+        return;
+      }
+      operation->awaiter_.resume();
+    });
+    return submitted || completed;
+  }
+
+  // Blocks until a completion or a wake up and returns true if the run loop should exit.
+  bool wait() noexcept {
+    if (stop_.load(std::memory_order_acquire) && !inflight_ && !pending_head_) {
+      return true;
+    }
+    sleeping_.store(true, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (empty() && !operations_.load(std::memory_order_relaxed) && !stop_.load(std::memory_order_acquire)) {
+      ring_.enter(1);
+    }
+    sleeping_.store(false, std::memory_order_relaxed);
+    return false;
+  }
+
+  detail::uring ring_;
+  int event_ = -1;
+  bool armed_ = false;
+  std::uint64_t event_value_ = 0;
+  iovec event_iovec_ = {};
+  std::size_t inflight_ = 0;
+  operation* pending_head_ = nullptr;
+  operation* pending_tail_ = nullptr;
+#endif
+
+  std::unique_ptr<ice::pool> pool_;
+  std::atomic<operation*> operations_ = nullptr;
+  std::atomic_bool sleeping_ = false;
+  std::atomic_bool stop_ = false;
+  std::atomic<std::thread::id> thread_;
+};
+
+}  // namespace ice
@@ -0,0 +1,269 @@
+#pragma once
+#include <ice/scheduler.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice {
+
+class pool final : public scheduler<pool> {
+public:
+  explicit pool(std::size_t size = std::thread::hardware_concurrency()) {
+    size = std::max(size, std::size_t(1));
+    workers_.reserve(size);
+    for (std::size_t i = 0; i < size; i++) {
+      workers_.push_back(std::make_unique<worker>(*this, i));
+    }
+    for (auto& worker : workers_) {
+      worker->thread = std::thread([this, worker = worker.get()]() { run(*worker); });
+    }
+  }
+
+  ~pool() {
+    stop();
+    for (auto& worker : workers_) {
+      worker->thread.join();
+    }
+  }
+
+  std::size_t size() const noexcept {
+    return workers_.size();
+  }
+
+  bool is_current() const noexcept {
+    return current_ && current_->pool == this;
+  }
+
+  void stop() noexcept {
+    {
+      std::lock_guard lock{ mutex_ };
+      stop_.store(true, std::memory_order_release);
+    }
+    cv_.notify_all();
+  }
+
+  // Interactive and bulk schedules always go to the shared lanes so that workers can order them.
+  void post(ice::schedule<pool>* schedule) noexcept {
+    const auto priority = schedule->priority();
+    if (priority != ice::priority::normal || !is_current() || !current_->deque.push(schedule)) {
+      if (priority != ice::priority::normal) {
+        shared_[static_cast<std::size_t>(priority)].size.fetch_add(1, std::memory_order_relaxed);
+      }
+      scheduler::post(schedule);
+    }
+    notify();
+  }
+
+  void post_batch(ice::schedule<pool>* first, ice::schedule<pool>* last) noexcept {
+    if (const auto priority = first->priority(); priority != ice::priority::normal) {
+      std::size_t size = 1;
+      for (auto schedule = first; schedule != last; size++) {
+        schedule = static_cast<ice::schedule<pool>*>(schedule->next.load(std::memory_order_relaxed));
+      }
+      shared_[static_cast<std::size_t>(priority)].size.fetch_add(size, std::memory_order_relaxed);
+    }
+    scheduler::post_batch(first, last);
+    notify();
+  }
+
+private:
+  // Chase-Lev work-stealing deque with a fixed capacity.
+  // The owner pushes and pops at the bottom, thieves steal from the top.
+  class deque {
+  public:
+    constexpr static std::int64_t capacity = 1024;
+
+    bool push(ice::schedule<pool>* schedule) noexcept {
+      const auto bottom = bottom_.load(std::memory_order_relaxed);
+      const auto top = top_.load(std::memory_order_acquire);
+      if (bottom - top >= capacity) {
+        return false;
+      }
+      buffer_[bottom & (capacity - 1)].store(schedule, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return true;
+    }
+
+    ice::schedule<pool>* pop() noexcept {
+      const auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+      bottom_.store(bottom, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      auto top = top_.load(std::memory_order_relaxed);
+      if (top > bottom) {
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+      }
+      auto schedule = buffer_[bottom & (capacity - 1)].load(std::memory_order_relaxed);
+      if (top == bottom) {
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+          schedule = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+      }
+      return schedule;
+    }
+
+    ice::schedule<pool>* steal() noexcept {
+      auto top = top_.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const auto bottom = bottom_.load(std::memory_order_acquire);
+      if (top >= bottom) {
+        return nullptr;
+      }
+      const auto schedule = buffer_[top & (capacity - 1)].load(std::memory_order_relaxed);
+      if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+      }
+      return schedule;
+    }
+
+    bool empty() const noexcept {
+      return bottom_.load(std::memory_order_acquire) <= top_.load(std::memory_order_acquire);
+    }
+
+  private:
+    alignas(64) std::atomic<std::int64_t> top_{ 0 };
+    alignas(64) std::atomic<std::int64_t> bottom_{ 0 };
+    std::atomic<ice::schedule<pool>*> buffer_[capacity] = {};
+  };
+
+  struct worker {
+    worker(ice::pool& pool, std::size_t index) noexcept : pool(&pool), index(index) {
+    }
+
+    ice::pool* pool;
+    std::size_t index;
+    std::thread thread;
+    ice::pool::deque deque;
+    std::size_t passes = 0;
+  };
+
+  void run(worker& worker) noexcept {
+    current_ = &worker;
+    while (true) {
+      if (const auto schedule = find(worker)) {
+        schedule->resume();
+        continue;
+      }
+      if (stop_.load(std::memory_order_acquire)) {
+        break;
+      }
+      idle_.fetch_add(1, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (const auto schedule = find(worker)) {
+        idle_.fetch_sub(1, std::memory_order_relaxed);
+        schedule->resume();
+        continue;
+      }
+      std::unique_lock lock{ mutex_ };
+      cv_.wait(lock, [&]() { return signals_ > 0 || stop_.load(std::memory_order_acquire); });
+      if (signals_ > 0) {
+        signals_--;
+      }
+      idle_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    current_ = nullptr;
+  }
+
+  // Takes interactive work first, then normal work from the local deque, the shared lane and other workers,
+  // and finally bulk work. Bulk work is taken ahead of normal work every starvation_limit calls.
+  ice::schedule<pool>* find(worker& worker) noexcept {
+    if (const auto schedule = next(ice::priority::interactive)) {
+      return schedule;
+    }
+    if (++worker.passes >= starvation_limit) {
+      worker.passes = 0;
+      if (const auto schedule = next(ice::priority::bulk)) {
+        return schedule;
+      }
+    }
+    if (const auto schedule = worker.deque.pop()) {
+      return schedule;
+    }
+    if (const auto schedule = take(worker)) {
+      return schedule;
+    }
+    const auto size = workers_.size();
+    for (std::size_t i = 1; i < size; i++) {
+      if (const auto schedule = workers_[(worker.index + i) % size]->deque.steal()) {
+        return schedule;
+      }
+    }
+    return next(ice::priority::bulk);
+  }
+
+  // Takes the next interactive or bulk schedule. The rest stays in its shared lane in the order it was posted,
+  // so that it never runs ahead of normal work in a local deque.
+  ice::schedule<pool>* next(ice::priority priority) noexcept {
+    auto& shared = shared_[static_cast<std::size_t>(priority)];
+    if (shared.size.load(std::memory_order_acquire) == 0) {
+      return nullptr;
+    }
+    std::lock_guard lock{ shared.mutex };
+    const auto schedule = pop(priority);
+    if (schedule) {
+      shared.size.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return schedule;
+  }
+
+  // Takes the shared normal lane and moves its remainder to the local deque where other workers can steal it.
+  ice::schedule<pool>* take(worker& worker) noexcept {
+    const auto head = acquire(ice::priority::normal);
+    if (!head) {
+      return nullptr;
+    }
+    auto next = static_cast<ice::schedule<pool>*>(head->next.load(std::memory_order_relaxed));
+    if (next) {
+      while (next) {
+        const auto schedule = next;
+        next = static_cast<ice::schedule<pool>*>(next->next.load(std::memory_order_relaxed));
+        if (!worker.deque.push(schedule)) {
+          scheduler::post(schedule);
+        }
+      }
+      notify();
+    }
+    return head;
+  }
+
+  void notify() noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idle_.load(std::memory_order_seq_cst) > 0) {
+      {
+        std::lock_guard lock{ mutex_ };
+        if (signals_ < workers_.size()) {
+          signals_++;
+        }
+      }
+      cv_.notify_one();
+    }
+  }
+
+  // Lane of interactive or bulk schedules that workers take one at a time.
+  // The size is counted before a schedule is posted, so that workers only lock lanes with pending work.
+  struct shared {
+    std::mutex mutex;
+    std::atomic_size_t size = 0;
+  };
+
+  inline static thread_local worker* current_ = nullptr;
+
+  std::vector<std::unique_ptr<worker>> workers_;
+  shared shared_[lanes];
+  std::atomic_bool stop_ = false;
+  std::atomic_size_t idle_ = 0;
+  std::size_t signals_ = 0;
+  std::condition_variable cv_;
+  std::mutex mutex_;
+};
+
+}  // namespace ice
@@ -0,0 +1,185 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+
+#ifdef ICE_STATISTICS
+#include <ice/statistics.hpp>
+#endif
+
+namespace ice {
+namespace detail {
+
+struct queue_node {
+  std::atomic<queue_node*> next{ nullptr };
+};
+
+}  // namespace detail
+
+// Lock-free LIFO stack of intrusive nodes that is taken as a whole and reversed to FIFO order.
+// Supports multiple producers and multiple consumers of take.
+class stack_queue {
+public:
+  using node = detail::queue_node;
+
+  stack_queue() noexcept = default;
+
+  stack_queue(stack_queue&& other) = delete;
+  stack_queue(const stack_queue& other) = delete;
+  stack_queue& operator=(stack_queue&& other) = delete;
+  stack_queue& operator=(const stack_queue& other) = delete;
+
+  ~stack_queue() = default;
+
+  // Returns true if no nodes were pushed and no taken nodes are left to pop.
+  bool empty() const noexcept {
+    return !pending_ && !head_.load(std::memory_order_relaxed);
+  }
+
+  void push(node* node) noexcept {
+    auto head = head_.load(std::memory_order_relaxed);
+    do {
+      node->next.store(head, std::memory_order_relaxed);
+    } while (!head_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  // Pushes nodes linked from first to last with a single compare exchange.
+  void push(node* first, node* last) noexcept {
+    if (first == last) {
+      push(first);
+      return;
+    }
+    node* prev = nullptr;
+    for (auto node = first; node != last;) {
+      const auto next = node->next.load(std::memory_order_relaxed);
+      node->next.store(prev, std::memory_order_relaxed);
+      prev = node;
+      node = next;
+    }
+    last->next.store(prev, std::memory_order_relaxed);
+    auto head = head_.load(std::memory_order_relaxed);
+    do {
+      first->next.store(head, std::memory_order_relaxed);
+    } while (!head_.compare_exchange_weak(head, last, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  // Takes all nodes in the order they were pushed.
+  node* take() noexcept {
+    if (!head_.load(std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    auto head = head_.exchange(nullptr, std::memory_order_acquire);
+    node* prev = nullptr;
+#ifdef ICE_STATISTICS
+    std::uint64_t depth = 0;
+#endif
+    while (head) {
+      const auto next = head->next.load(std::memory_order_relaxed);
+      head->next.store(prev, std::memory_order_relaxed);
+      prev = head;
+      head = next;
+#ifdef ICE_STATISTICS
+      depth++;
+#endif
+    }
+#ifdef ICE_STATISTICS
+    if (depth) {
+      detail::statistics_registry::local().queue_depth.add(depth);
+    }
+#endif
+    return prev;
+  }
+
+  // Takes the next node for a single consumer.
+  node* pop() noexcept {
+    if (!pending_) {
+      pending_ = take();
+      if (!pending_) {
+        return nullptr;
+      }
+    }
+    const auto node = pending_;
+    pending_ = node->next.load(std::memory_order_relaxed);
+    return node;
+  }
+
+private:
+  std::atomic<node*> head_{ nullptr };
+  node* pending_{ nullptr };
+};
+
+// Intrusive Vyukov queue of nodes for multiple producers and a single consumer.
+// A push is a single atomic exchange and nodes are popped in FIFO order without reversal.
+class mpsc_queue {
+public:
+  using node = detail::queue_node;
+
+  mpsc_queue() noexcept = default;
+
+  mpsc_queue(mpsc_queue&& other) = delete;
+  mpsc_queue(const mpsc_queue& other) = delete;
+  mpsc_queue& operator=(mpsc_queue&& other) = delete;
+  mpsc_queue& operator=(const mpsc_queue& other) = delete;
+
+  ~mpsc_queue() = default;
+
+  // Returns true if no nodes are left to pop. Must be called by the consumer.
+  bool empty() const noexcept {
+    return tail_ == &stub_ && head_.load(std::memory_order_acquire) == &stub_;
+  }
+
+  void push(node* node) noexcept {
+    push(node, node);
+  }
+
+  // Pushes nodes linked from first to last with a single atomic exchange.
+  void push(node* first, node* last) noexcept {
+    last->next.store(nullptr, std::memory_order_relaxed);
+    const auto prev = head_.exchange(last, std::memory_order_acq_rel);
+    prev->next.store(first, std::memory_order_release);
+  }
+
+  // Takes the next node. Returns nullptr when the queue is empty or a producer
+  // has not linked its node yet, in which case the node is returned by a later call.
+  node* pop() noexcept {
+    auto tail = tail_;
+    auto next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (!next) {
+        return nullptr;
+      }
+      tail_ = tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (!next) {
+      if (tail != head_.load(std::memory_order_acquire)) {
+        return nullptr;
+      }
+      push(&stub_);
+      next = tail->next.load(std::memory_order_acquire);
+      if (!next) {
+        return nullptr;
+      }
+    }
+    tail_ = next;
+#ifdef ICE_STATISTICS
+    // Records the number of nodes popped since the queue was last empty.
+    depth_++;
+    if (next == &stub_) {
+      detail::statistics_registry::local().queue_depth.add(depth_);
+      depth_ = 0;
+    }
+#endif
+    return tail;
+  }
+
+private:
+  alignas(64) std::atomic<node*> head_{ &stub_ };
+  alignas(64) node* tail_{ &stub_ };
+  node stub_;
+#ifdef ICE_STATISTICS
+  std::uint64_t depth_{ 0 };
+#endif
+};
+
+}  // namespace ice
@@ -1,20 +1,49 @@
 #pragma once
+#include <ice/coroutine.hpp>
 #include <atomic>
-#include <experimental/coroutine>
+#include <optional>
+#include <stop_token>
+#include <utility>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <ice/queue.hpp>
+
+#ifdef ICE_STATISTICS
+#include <ice/statistics.hpp>
+#endif
 
 namespace ice {
 
+// Scheduling priority.
+// Interactive work runs before normal work, which runs before bulk work.
+enum class priority : unsigned char { interactive, normal, bulk };
+
+template <typename Scheduler>
+class batch;
+
 template <typename Scheduler>
-class schedule {
+class schedule : public detail::queue_node {
 public:
   schedule(Scheduler& scheduler, bool post = false) noexcept : scheduler_(scheduler), ready_(!post && scheduler.is_current()) {
   }
 
+  schedule(Scheduler& scheduler, ice::priority priority, bool post = false) noexcept :
+    scheduler_(scheduler), priority_(priority), ready_(!post && scheduler.is_current()) {
+  }
+
+  // Completes without posting if a stop was already requested.
+  // The awaiter checks the result of co_await and should return early when it is false.
+  schedule(Scheduler& scheduler, std::stop_token token, ice::priority priority = ice::priority::normal, bool post = false) noexcept :
+    scheduler_(scheduler), token_(std::move(token)), priority_(priority),
+    ready_((!post && scheduler.is_current()) || token_.stop_requested()) {
+  }
+
 #ifdef __INTELLISENSE__
   // clang-format off
-  schedule(schedule&& other) noexcept : scheduler_(other.scheduler_), ready_(other.ready_) {}
-  schedule(const schedule& other) noexcept : scheduler_(other.scheduler_), ready_(other.ready_) {}
+  schedule(schedule&& other) noexcept : scheduler_(other.scheduler_), token_(other.token_), priority_(other.priority_), ready_(other.ready_) {}
+  schedule(const schedule& other) noexcept : scheduler_(other.scheduler_), token_(other.token_), priority_(other.priority_), ready_(other.ready_) {}
   schedule& operator=(schedule&& other) noexcept { return *this; }
   schedule& operator=(const schedule& other) noexcept { return *this; }
   // clang-format on
@@ -31,29 +60,60 @@ public:
     return ready_;
   }
 
-  void await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+  void await_suspend(ice::coroutine_handle<> awaiter) noexcept {
     awaiter_ = awaiter;
+#ifdef ICE_STATISTICS
+    posted_ = detail::statistics_now();
+#endif
     scheduler_.post(this);
   }
 
-  constexpr void await_resume() const noexcept {
+  // Returns false if a stop was requested.
+  bool await_resume() const noexcept {
+    return !token_.stop_requested();
   }
 
   void resume() noexcept {
+#ifdef ICE_STATISTICS
+    auto& statistics = detail::statistics_registry::local();
+    const auto resumed = detail::statistics_now();
+    statistics.resume_latency.add(detail::statistics_elapsed(posted_, resumed));
     awaiter_.resume();
+    statistics.run_time.add(detail::statistics_elapsed(resumed, detail::statistics_now()));
+#else
+    awaiter_.resume();
+#endif
   }
 
-  std::atomic<schedule*> next{ nullptr };
+  ice::priority priority() const noexcept {
+    return priority_;
+  }
 
 private:
+  template <typename>
+  friend class ice::batch;
+
   Scheduler& scheduler_;
+  const std::stop_token token_;
+  const ice::priority priority_ = ice::priority::normal;
   const bool ready_ = true;
-  std::experimental::coroutine_handle<> awaiter_;
+  ice::coroutine_handle<> awaiter_;
+#ifdef ICE_STATISTICS
+  std::uint64_t posted_ = 0;
+#endif
 };
 
-template <typename Context>
+// Schedules are queued in one lane per priority.
+// The Queue policy is ice::stack_queue, which supports multiple consumers, or
+// ice::mpsc_queue for schedulers that are drained by a single thread.
+template <typename Context, typename Queue = ice::stack_queue>
 class scheduler {
 public:
+  constexpr static std::size_t lanes = 3;
+
+  // Number of times a lane with pending work may be passed over by higher priority lanes.
+  constexpr static std::size_t starvation_limit = 16;
+
   scheduler() = default;
 
   scheduler(scheduler&& other) = delete;
@@ -67,41 +127,238 @@ public:
     return { static_cast<Context&>(*this), post };
   }
 
+  ice::schedule<Context> schedule(ice::priority priority, bool post = false) noexcept {
+    return { static_cast<Context&>(*this), priority, post };
+  }
+
+  ice::schedule<Context> schedule(std::stop_token token, bool post = false) noexcept {
+    return { static_cast<Context&>(*this), std::move(token), ice::priority::normal, post };
+  }
+
+  ice::schedule<Context> schedule(std::stop_token token, ice::priority priority, bool post = false) noexcept {
+    return { static_cast<Context&>(*this), std::move(token), priority, post };
+  }
+
 protected:
-  ice::schedule<Context>* acquire() noexcept {
-    auto head = head_.exchange(nullptr, std::memory_order_acquire);
-    if (!head || !head->next.load(std::memory_order_relaxed)) {
-      return head;
+  bool empty() const noexcept {
+    for (const auto& queue : queues_) {
+      if (!queue.empty()) {
+        return false;
+      }
     }
-    ice::schedule<Context>* prev = nullptr;
-    ice::schedule<Context>* next = nullptr;
-    while (head) {
-      next = head->next.exchange(prev, std::memory_order_relaxed);
-      prev = head;
-      head = next;
+    return true;
+  }
+
+  // Takes all posted schedules of the given priority in the order they were posted.
+  ice::schedule<Context>* acquire(ice::priority priority) noexcept requires requires(Queue& queue) {
+    queue.take();
+  }
+  {
+    return static_cast<ice::schedule<Context>*>(queues_[static_cast<std::size_t>(priority)].take());
+  }
+
+  // Takes the next posted schedule of the given priority in the order they were posted.
+  // Only one thread at a time may take schedules of a priority this way.
+  ice::schedule<Context>* pop(ice::priority priority) noexcept {
+    return static_cast<ice::schedule<Context>*>(queues_[static_cast<std::size_t>(priority)].pop());
+  }
+
+  // Takes all posted schedules of the highest priority that has any.
+  ice::schedule<Context>* acquire() noexcept requires requires(Queue& queue) {
+    queue.take();
+  }
+  {
+    for (std::size_t lane = 0; lane < lanes; lane++) {
+      if (const auto head = acquire(static_cast<ice::priority>(lane))) {
+        return head;
+      }
     }
-    return prev;
+    return nullptr;
+  }
+
+  // Returns the next schedule by priority for schedulers with a single consumer thread.
+  // Higher priority lanes are checked before every pick, so new interactive work runs
+  // next. A lane that was passed over starvation_limit times is picked regardless.
+  ice::schedule<Context>* next() noexcept {
+    auto lane = lanes;
+    for (std::size_t i = 0; i < lanes; i++) {
+      if (!queues_[i].empty() && (lane == lanes || skipped_[i] >= starvation_limit)) {
+        lane = i;
+      }
+    }
+    if (lane == lanes) {
+      return nullptr;
+    }
+    for (std::size_t i = 0; i < lanes; i++) {
+      if (i == lane) {
+        skipped_[i] = 0;
+      } else if (!queues_[i].empty()) {
+        skipped_[i]++;
+      }
+    }
+    return static_cast<ice::schedule<Context>*>(queues_[lane].pop());
   }
 
   void post(ice::schedule<Context>* schedule) noexcept {
     assert(schedule);
-    auto head = head_.load(std::memory_order_acquire);
-    do {
-      schedule->next.store(head, std::memory_order_relaxed);
-    } while (!head_.compare_exchange_weak(head, schedule, std::memory_order_release, std::memory_order_acquire));
+    queues_[static_cast<std::size_t>(schedule->priority())].push(schedule);
+  }
+
+  // Posts schedules linked through their next member from first to last in a single operation.
+  // All schedules in the chain are queued with the priority of the first one. See ice::batch.
+  void post_batch(ice::schedule<Context>* first, ice::schedule<Context>* last) noexcept {
+    assert(first && last);
+    queues_[static_cast<std::size_t>(first->priority())].push(first, last);
   }
 
   void process() {
-    auto head = acquire();
-    while (head) {
-      auto next = head->next.load(std::memory_order_relaxed);
-      head->resume();
-      head = next;
+    for (std::size_t lane = 0; lane < lanes; lane++) {
+      auto head = acquire(static_cast<ice::priority>(lane));
+      while (head) {
+        const auto next = static_cast<ice::schedule<Context>*>(head->next.load(std::memory_order_relaxed));
+        head->resume();
+        head = next;
+      }
     }
   }
 
 private:
-  std::atomic<ice::schedule<Context>*> head_ = nullptr;
+  Queue queues_[lanes];
+  std::size_t skipped_[lanes] = {};
 };
 
+// Collects the schedules of coroutines and posts them with a single post_batch call, which
+// queues them in one operation and wakes the scheduler once. Schedules are posted when
+// post is called or the batch is destroyed. The coroutines must await the batch on the
+// thread that owns it, which is the case for tasks that are started by that thread.
+//
+// ice::batch batch{ pool };
+// for (std::size_t job = 0; job < jobs; job++) {
+//   tasks.push_back(Run(batch, job));  // co_await batch.schedule();
+// }
+// batch.post();
+//
+template <typename Scheduler>
+class batch {
+public:
+  class awaitable {
+  public:
+    explicit awaitable(ice::batch<Scheduler>& batch) noexcept : batch_(batch), schedule_(batch.scheduler_, batch.priority_, true) {
+    }
+
+    awaitable(awaitable&& other) = delete;
+    awaitable(const awaitable& other) = delete;
+    awaitable& operator=(awaitable&& other) = delete;
+    awaitable& operator=(const awaitable& other) = delete;
+
+    ~awaitable() = default;
+
+    constexpr bool await_ready() const noexcept {
+      return false;
+    }
+
+    void await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+      batch_.add(schedule_, awaiter);
+    }
+
+    constexpr void await_resume() const noexcept {
+    }
+
+  private:
+    ice::batch<Scheduler>& batch_;
+    ice::schedule<Scheduler> schedule_;
+  };
+
+  explicit batch(Scheduler& scheduler, ice::priority priority = ice::priority::normal) noexcept :
+    scheduler_(scheduler), priority_(priority) {
+  }
+
+  batch(batch&& other) = delete;
+  batch(const batch& other) = delete;
+  batch& operator=(batch&& other) = delete;
+  batch& operator=(const batch& other) = delete;
+
+  ~batch() {
+    post();
+  }
+
+  // Suspends the awaiter until the batch is posted.
+  awaitable schedule() noexcept {
+    return awaitable{ *this };
+  }
+
+  // Returns the number of schedules that were not posted yet.
+  std::size_t size() const noexcept {
+    return size_;
+  }
+
+  // Posts the collected schedules and starts a new batch.
+  void post() noexcept {
+    if (!first_) {
+      return;
+    }
+#ifdef ICE_STATISTICS
+    const auto posted = detail::statistics_now();
+    for (auto schedule = first_; schedule; schedule = static_cast<ice::schedule<Scheduler>*>(schedule->next.load(std::memory_order_relaxed))) {
+      schedule->posted_ = posted;
+    }
+#endif
+    scheduler_.post_batch(std::exchange(first_, nullptr), std::exchange(last_, nullptr));
+    size_ = 0;
+  }
+
+private:
+  void add(ice::schedule<Scheduler>& schedule, ice::coroutine_handle<> awaiter) noexcept {
+    schedule.awaiter_ = awaiter;
+    schedule.next.store(nullptr, std::memory_order_relaxed);
+    if (last_) {
+      last_->next.store(&schedule, std::memory_order_relaxed);
+    } else {
+      first_ = &schedule;
+    }
+    last_ = &schedule;
+    size_++;
+  }
+
+  Scheduler& scheduler_;
+  const ice::priority priority_;
+  ice::schedule<Scheduler>* first_ = nullptr;
+  ice::schedule<Scheduler>* last_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+namespace detail {
+
+// Resumes an awaiter through the given scheduler.
+template <typename Scheduler>
+class resumer {
+public:
+  explicit resumer(Scheduler& scheduler) noexcept : scheduler_(scheduler) {
+  }
+
+  void resume(ice::coroutine_handle<> awaiter) noexcept {
+    schedule_.emplace(scheduler_);
+    if (schedule_->await_ready()) {
+      awaiter.resume();
+    } else {
+      schedule_->await_suspend(awaiter);
+    }
+  }
+
+private:
+  Scheduler& scheduler_;
+  std::optional<ice::schedule<Scheduler>> schedule_;
+};
+
+// Resumes an awaiter on the current thread.
+template <>
+class resumer<void> {
+public:
+  void resume(ice::coroutine_handle<> awaiter) noexcept {
+    awaiter.resume();
+  }
+};
+
+}  // namespace detail
+
 }  // namespace ice
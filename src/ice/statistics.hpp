@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace ice {
+
+// Histogram of values in power of two buckets.
+// Bucket 0 counts zeros and bucket i counts values in [2^(i-1), 2^i).
+class histogram {
+public:
+  constexpr static std::size_t buckets = 65;
+
+  void add(std::uint64_t value) noexcept {
+    counts[std::bit_width(value)]++;
+    count++;
+    sum += value;
+    max = std::max(max, value);
+  }
+
+  // Returns the upper bound of the bucket that contains the given percentile.
+  std::uint64_t percentile(double percentile) const noexcept {
+    const auto target = static_cast<std::uint64_t>(static_cast<double>(count) * percentile / 100.0);
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < buckets; i++) {
+      total += counts[i];
+      if (total > target) {
+        return i ? std::min(max, (std::uint64_t(1) << (i - 1)) * 2 - 1) : 0;
+      }
+    }
+    return max;
+  }
+
+  double mean() const noexcept {
+    return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+  }
+
+  histogram& operator+=(const histogram& other) noexcept {
+    for (std::size_t i = 0; i < buckets; i++) {
+      counts[i] += other.counts[i];
+    }
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+    return *this;
+  }
+
+  std::array<std::uint64_t, buckets> counts{};
+  std::uint64_t count{ 0 };
+  std::uint64_t sum{ 0 };
+  std::uint64_t max{ 0 };
+};
+
+// Scheduler statistics of all threads.
+// Recorded only when ICE_STATISTICS is defined.
+struct statistics {
+  // Number of schedules taken from a scheduler queue at once.
+  ice::histogram queue_depth;
+
+  // Nanoseconds between posting a schedule or the deadline of a timer and its resumption.
+  ice::histogram resume_latency;
+
+  // Nanoseconds until a resumed coroutine suspended or finished.
+  ice::histogram run_time;
+
+  statistics& operator+=(const statistics& other) noexcept {
+    queue_depth += other.queue_depth;
+    resume_latency += other.resume_latency;
+    run_time += other.run_time;
+    return *this;
+  }
+
+  // Returns the statistics of all threads including threads that have exited.
+  static statistics snapshot() noexcept;
+};
+
+namespace detail {
+
+// Histogram that is written by one thread and read by any thread.
+class atomic_histogram {
+public:
+  void add(std::uint64_t value) noexcept {
+    increment(counts_[std::bit_width(value)], 1);
+    increment(count_, 1);
+    increment(sum_, value);
+    if (value > max_.load(std::memory_order_relaxed)) {
+      max_.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  ice::histogram load() const noexcept {
+    ice::histogram histogram;
+    for (std::size_t i = 0; i < ice::histogram::buckets; i++) {
+      histogram.counts[i] = counts_[i].load(std::memory_order_relaxed);
+    }
+    histogram.count = count_.load(std::memory_order_relaxed);
+    histogram.sum = sum_.load(std::memory_order_relaxed);
+    histogram.max = max_.load(std::memory_order_relaxed);
+    return histogram;
+  }
+
+private:
+  // Avoids read-modify-write instructions since there is only one writer.
+  static void increment(std::atomic_uint64_t& value, std::uint64_t count) noexcept {
+    value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic_uint64_t, ice::histogram::buckets> counts_{};
+  std::atomic_uint64_t count_{ 0 };
+  std::atomic_uint64_t sum_{ 0 };
+  std::atomic_uint64_t max_{ 0 };
+};
+
+class statistics_registry {
+public:
+  struct thread_statistics {
+    atomic_histogram queue_depth;
+    atomic_histogram resume_latency;
+    atomic_histogram run_time;
+
+    ice::statistics load() const noexcept {
+      return { queue_depth.load(), resume_latency.load(), run_time.load() };
+    }
+  };
+
+  // Returns the statistics of the current thread, which are registered on first use.
+  static thread_statistics& local() noexcept {
+    if (const auto statistics = current()) {
+      return *statistics;
+    }
+    thread_local owner instance;
+    current() = &instance.statistics;
+    return instance.statistics;
+  }
+
+  static ice::statistics snapshot() noexcept {
+    auto& registry = instance();
+    std::lock_guard lock{ registry.mutex_ };
+    auto statistics = registry.retired_;
+    for (const auto thread : registry.threads_) {
+      statistics += thread->load();
+    }
+    return statistics;
+  }
+
+private:
+  struct owner {
+    owner() {
+      auto& registry = instance();
+      std::lock_guard lock{ registry.mutex_ };
+      registry.threads_.push_back(&statistics);
+    }
+
+    ~owner() {
+      current() = nullptr;
+      auto& registry = instance();
+      std::lock_guard lock{ registry.mutex_ };
+      registry.retired_ += statistics.load();
+      registry.threads_.erase(std::find(registry.threads_.begin(), registry.threads_.end(), &statistics));
+    }
+
+    thread_statistics statistics;
+  };
+
+  // Intentionally leaked to outlive thread_local statistics of threads that exit after main.
+  static statistics_registry& instance() noexcept {
+    static const auto registry = new statistics_registry();
+    return *registry;
+  }
+
+  static thread_statistics*& current() noexcept {
+    thread_local thread_statistics* statistics = nullptr;
+    return statistics;
+  }
+
+  std::mutex mutex_;
+  std::vector<thread_statistics*> threads_;
+  ice::statistics retired_;
+};
+
+inline std::uint64_t statistics_now() noexcept {
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+inline std::uint64_t statistics_elapsed(std::uint64_t since, std::uint64_t now) noexcept {
+  return now > since ? now - since : 0;
+}
+
+}  // namespace detail
+
+inline statistics statistics::snapshot() noexcept {
+  return detail::statistics_registry::snapshot();
+}
+
+}  // namespace ice
@@ -0,0 +1,408 @@
+#pragma once
+#include <ice/coroutine.hpp>
+#include <ice/scheduler.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <cassert>
+#include <cstddef>
+
+namespace ice {
+namespace detail {
+
+struct sync_waiter {
+  sync_waiter* next{ nullptr };
+  ice::coroutine_handle<> awaiter;
+  void (*resume)(sync_waiter& waiter) noexcept { nullptr };
+};
+
+template <typename Scheduler>
+class sync_awaitable : public sync_waiter, detail::resumer<Scheduler> {
+public:
+  template <typename... Args>
+  explicit sync_awaitable(Args&... scheduler) noexcept : detail::resumer<Scheduler>(scheduler...) {
+    sync_waiter::resume = &resume_awaiter;
+  }
+
+  sync_awaitable(sync_awaitable&& other) = delete;
+  sync_awaitable(const sync_awaitable& other) = delete;
+  sync_awaitable& operator=(sync_awaitable&& other) = delete;
+  sync_awaitable& operator=(const sync_awaitable& other) = delete;
+
+  ~sync_awaitable() = default;
+
+private:
+  static void resume_awaiter(sync_waiter& waiter) noexcept {
+    auto& self = static_cast<sync_awaitable&>(waiter);
+    self.detail::resumer<Scheduler>::resume(self.awaiter);
+  }
+};
+
+}  // namespace detail
+
+class async_mutex;
+
+// Unlocks an async_mutex when destroyed.
+class async_lock {
+public:
+  async_lock(async_mutex& mutex, std::adopt_lock_t) noexcept : mutex_(&mutex) {
+  }
+
+  async_lock(async_lock&& other) noexcept : mutex_(std::exchange(other.mutex_, nullptr)) {
+  }
+
+  async_lock(const async_lock& other) = delete;
+  async_lock& operator=(async_lock&& other) = delete;
+  async_lock& operator=(const async_lock& other) = delete;
+
+  ~async_lock();
+
+private:
+  async_mutex* mutex_;
+};
+
+// Mutex that suspends awaiters instead of blocking the thread.
+// Ownership is handed to the next awaiter in FIFO order, which is resumed by unlock on the
+// unlocking thread, or through the scheduler passed to lock.
+//
+// const auto lock = co_await mutex.scoped_lock(context);
+//
+class async_mutex {
+public:
+  async_mutex() noexcept = default;
+
+  async_mutex(async_mutex&& other) = delete;
+  async_mutex(const async_mutex& other) = delete;
+  async_mutex& operator=(async_mutex&& other) = delete;
+  async_mutex& operator=(const async_mutex& other) = delete;
+
+  ~async_mutex() {
+    assert(state_.load(std::memory_order_relaxed) == unlocked());
+  }
+
+  bool try_lock() noexcept {
+    auto state = unlocked();
+    return state_.compare_exchange_strong(state, nullptr, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+
+  // Locks the mutex. The awaiter must call unlock.
+  auto lock() noexcept {
+    return lock_awaitable<void>{ *this };
+  }
+
+  template <typename Scheduler>
+  auto lock(Scheduler& scheduler) noexcept {
+    return lock_awaitable<Scheduler>{ *this, scheduler };
+  }
+
+  // Locks the mutex and returns an async_lock that unlocks it.
+  auto scoped_lock() noexcept {
+    return scoped_lock_awaitable<void>{ *this };
+  }
+
+  template <typename Scheduler>
+  auto scoped_lock(Scheduler& scheduler) noexcept {
+    return scoped_lock_awaitable<Scheduler>{ *this, scheduler };
+  }
+
+  void unlock() noexcept {
+    auto waiter = waiters_;
+    if (!waiter) {
+      detail::sync_waiter* state = nullptr;
+      if (state_.compare_exchange_strong(state, unlocked(), std::memory_order_release, std::memory_order_relaxed)) {
+        return;
+      }
+      // Move the awaiters that were queued since the last unlock to the FIFO list.
+      state = state_.exchange(nullptr, std::memory_order_acquire);
+      assert(state && state != unlocked());
+      while (state) {
+        const auto next = state->next;
+        state->next = waiter;
+        waiter = state;
+        state = next;
+      }
+    }
+    waiters_ = waiter->next;
+    waiter->resume(*waiter);
+  }
+
+private:
+  template <typename Scheduler>
+  class lock_awaitable : public detail::sync_awaitable<Scheduler> {
+  public:
+    template <typename... Args>
+    explicit lock_awaitable(async_mutex& mutex, Args&... scheduler) noexcept :
+      detail::sync_awaitable<Scheduler>(scheduler...), mutex_(mutex) {
+    }
+
+    bool await_ready() noexcept {
+      return mutex_.try_lock();
+    }
+
+    bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+      this->awaiter = awaiter;
+      return mutex_.try_enqueue(*this);
+    }
+
+    constexpr void await_resume() const noexcept {
+    }
+
+  protected:
+    async_mutex& mutex_;
+  };
+
+  template <typename Scheduler>
+  class scoped_lock_awaitable : public lock_awaitable<Scheduler> {
+  public:
+    using lock_awaitable<Scheduler>::lock_awaitable;
+
+    async_lock await_resume() const noexcept {
+      return { this->mutex_, std::adopt_lock };
+    }
+  };
+
+  // Locks the mutex or queues the awaiter and returns true if it was queued.
+  bool try_enqueue(detail::sync_waiter& waiter) noexcept {
+    auto state = state_.load(std::memory_order_acquire);
+    while (true) {
+      if (state == unlocked()) {
+        if (state_.compare_exchange_weak(state, nullptr, std::memory_order_acquire, std::memory_order_acquire)) {
+          return false;
+        }
+      } else {
+        waiter.next = state;
+        if (state_.compare_exchange_weak(state, &waiter, std::memory_order_release, std::memory_order_acquire)) {
+          return true;
+        }
+      }
+    }
+  }
+
+  detail::sync_waiter* unlocked() const noexcept {
+    return reinterpret_cast<detail::sync_waiter*>(const_cast<async_mutex*>(this));
+  }
+
+  // The mutex is unlocked, locked without awaiters (nullptr) or locked with a LIFO list of new awaiters.
+  std::atomic<detail::sync_waiter*> state_{ unlocked() };
+
+  // FIFO list of awaiters that is only accessed by the owner.
+  detail::sync_waiter* waiters_{ nullptr };
+};
+
+inline async_lock::~async_lock() {
+  if (mutex_) {
+    mutex_->unlock();
+  }
+}
+
+// Counting semaphore that suspends awaiters instead of blocking the thread.
+// Acquire and release are lock-free unless an awaiter has to be queued or resumed.
+//
+// co_await semaphore.acquire(context);
+// ...
+// semaphore.release();
+//
+class async_semaphore {
+public:
+  explicit async_semaphore(std::ptrdiff_t count) noexcept : count_(count) {
+    assert(count >= 0);
+  }
+
+  async_semaphore(async_semaphore&& other) = delete;
+  async_semaphore(const async_semaphore& other) = delete;
+  async_semaphore& operator=(async_semaphore&& other) = delete;
+  async_semaphore& operator=(const async_semaphore& other) = delete;
+
+  ~async_semaphore() {
+    assert(!head_);
+  }
+
+  bool try_acquire() noexcept {
+    auto count = count_.load(std::memory_order_relaxed);
+    while (count > 0) {
+      if (count_.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  auto acquire() noexcept {
+    return acquire_awaitable<void>{ *this };
+  }
+
+  template <typename Scheduler>
+  auto acquire(Scheduler& scheduler) noexcept {
+    return acquire_awaitable<Scheduler>{ *this, scheduler };
+  }
+
+  // Releases count units and resumes up to count awaiters on the current thread or their schedulers.
+  void release(std::ptrdiff_t count = 1) noexcept {
+    assert(count > 0);
+    const auto previous = count_.fetch_add(count, std::memory_order_acq_rel);
+    if (previous >= 0) {
+      return;
+    }
+    detail::sync_waiter* head = nullptr;
+    detail::sync_waiter* tail = nullptr;
+    {
+      std::lock_guard lock{ mutex_ };
+      for (auto n = std::min(count, -previous); n > 0; n--) {
+        // An awaiter that took the count but was not queued yet consumes a wakeup instead.
+        if (!head_) {
+          wakeups_++;
+          continue;
+        }
+        const auto waiter = std::exchange(head_, head_->next);
+        waiter->next = nullptr;
+        (tail ? tail->next : head) = waiter;
+        tail = waiter;
+      }
+      if (!head_) {
+        tail_ = nullptr;
+      }
+    }
+    while (head) {
+      const auto next = head->next;
+      head->resume(*head);
+      head = next;
+    }
+  }
+
+private:
+  template <typename Scheduler>
+  class acquire_awaitable : public detail::sync_awaitable<Scheduler> {
+  public:
+    template <typename... Args>
+    explicit acquire_awaitable(async_semaphore& semaphore, Args&... scheduler) noexcept :
+      detail::sync_awaitable<Scheduler>(scheduler...), semaphore_(semaphore) {
+    }
+
+    bool await_ready() noexcept {
+      return semaphore_.try_acquire();
+    }
+
+    bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+      this->awaiter = awaiter;
+      return semaphore_.try_enqueue(*this);
+    }
+
+    constexpr void await_resume() const noexcept {
+    }
+
+  private:
+    async_semaphore& semaphore_;
+  };
+
+  // Takes a unit or queues the awaiter and returns true if it was queued.
+  bool try_enqueue(detail::sync_waiter& waiter) noexcept {
+    if (count_.fetch_sub(1, std::memory_order_acq_rel) > 0) {
+      return false;
+    }
+    std::lock_guard lock{ mutex_ };
+    if (wakeups_ > 0) {
+      wakeups_--;
+      return false;
+    }
+    waiter.next = nullptr;
+    (tail_ ? tail_->next : head_) = &waiter;
+    tail_ = &waiter;
+    return true;
+  }
+
+  // Number of available units or the negated number of awaiters.
+  std::atomic<std::ptrdiff_t> count_;
+
+  std::mutex mutex_;
+  std::ptrdiff_t wakeups_{ 0 };
+  detail::sync_waiter* head_{ nullptr };
+  detail::sync_waiter* tail_{ nullptr };
+};
+
+// Single use barrier that resumes all awaiters once it was counted down to zero.
+// The awaiters are resumed on the thread that counted it down, or through the scheduler passed to wait.
+class latch {
+public:
+  explicit latch(std::ptrdiff_t count) noexcept : count_(count) {
+    assert(count >= 0);
+  }
+
+  latch(latch&& other) = delete;
+  latch(const latch& other) = delete;
+  latch& operator=(latch&& other) = delete;
+  latch& operator=(const latch& other) = delete;
+
+  ~latch() = default;
+
+  void count_down(std::ptrdiff_t count = 1) noexcept {
+    const auto previous = count_.fetch_sub(count, std::memory_order_acq_rel);
+    assert(previous >= count);
+    if (previous == count) {
+      auto waiter = waiters_.exchange(released(), std::memory_order_acq_rel);
+      while (waiter) {
+        const auto next = waiter->next;
+        waiter->resume(*waiter);
+        waiter = next;
+      }
+    }
+  }
+
+  bool try_wait() const noexcept {
+    return count_.load(std::memory_order_acquire) == 0;
+  }
+
+  auto wait() noexcept {
+    return wait_awaitable<void>{ *this };
+  }
+
+  template <typename Scheduler>
+  auto wait(Scheduler& scheduler) noexcept {
+    return wait_awaitable<Scheduler>{ *this, scheduler };
+  }
+
+private:
+  template <typename Scheduler>
+  class wait_awaitable : public detail::sync_awaitable<Scheduler> {
+  public:
+    template <typename... Args>
+    explicit wait_awaitable(ice::latch& latch, Args&... scheduler) noexcept : detail::sync_awaitable<Scheduler>(scheduler...), latch_(latch) {
+    }
+
+    bool await_ready() const noexcept {
+      return latch_.try_wait();
+    }
+
+    bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+      this->awaiter = awaiter;
+      return latch_.try_enqueue(*this);
+    }
+
+    constexpr void await_resume() const noexcept {
+    }
+
+  private:
+    ice::latch& latch_;
+  };
+
+  // Queues the awaiter and returns true unless the latch was released.
+  bool try_enqueue(detail::sync_waiter& waiter) noexcept {
+    auto head = waiters_.load(std::memory_order_acquire);
+    do {
+      if (head == released()) {
+        return false;
+      }
+      waiter.next = head;
+    } while (!waiters_.compare_exchange_weak(head, &waiter, std::memory_order_release, std::memory_order_acquire));
+    return true;
+  }
+
+  detail::sync_waiter* released() const noexcept {
+    return reinterpret_cast<detail::sync_waiter*>(const_cast<latch*>(this));
+  }
+
+  std::atomic<std::ptrdiff_t> count_;
+  std::atomic<detail::sync_waiter*> waiters_{ nullptr };
+};
+
+}  // namespace ice
@@ -21,14 +21,14 @@
 // SOFTWARE.
 
 #pragma once
+#include <ice/allocator.hpp>
+#include <ice/coroutine.hpp>
 #include <atomic>
 #include <functional>
 #include <type_traits>
 #include <utility>
 #include <cassert>
 
-#include <experimental/coroutine>
-
 namespace ice {
 
 template <typename T>
@@ -38,11 +38,12 @@ namespace detail {
 
 class continuation {
 public:
-  using callback_t = void(void*);
+  // Callbacks return the coroutine to resume next or ice::noop_coroutine().
+  using callback_t = ice::coroutine_handle<>(void*);
 
   constexpr continuation() noexcept = default;
 
-  explicit continuation(std::experimental::coroutine_handle<> awaiter) noexcept : callback_(nullptr), state_(awaiter.address()) {
+  explicit continuation(ice::coroutine_handle<> awaiter) noexcept : callback_(nullptr), state_(awaiter.address()) {
   }
 
   explicit constexpr continuation(callback_t* callback, void* state) noexcept : callback_(callback), state_(state) {
@@ -53,11 +54,15 @@ public:
   }
 
   void resume() noexcept {
+    handle().resume();
+  }
+
+  // Runs the callback or returns the awaiter for symmetric transfer.
+  ice::coroutine_handle<> handle() noexcept {
     if (callback_) {
-      callback_(state_);
-    } else {
-      std::experimental::coroutine_handle<>::from_address(state_).resume();
+      return callback_(state_);
     }
+    return ice::coroutine_handle<>::from_address(state_);
   }
 
 private:
@@ -69,8 +74,16 @@ class task_promise_base {
 public:
   constexpr task_promise_base() noexcept = default;
 
+  static void* operator new(std::size_t size) {
+    return detail::frame_allocator::allocate(size);
+  }
+
+  static void operator delete(void* frame, std::size_t size) noexcept {
+    detail::frame_allocator::deallocate(frame, size);
+  }
+
   constexpr auto initial_suspend() noexcept {
-    return std::experimental::suspend_never{};
+    return ice::suspend_never{};
   }
 
   auto final_suspend() noexcept {
@@ -82,12 +95,17 @@ public:
         return promise_.state_.load(std::memory_order_acquire) == state::consumer_detached;
       }
 
-      bool await_suspend(std::experimental::coroutine_handle<>) noexcept {
-        state state = promise_.state_.exchange(state::finished, std::memory_order_acq_rel);
+      // Transfers to the continuation instead of resuming it on top of this frame,
+      // so chains of tasks that complete each other run in constant stack.
+      ice::coroutine_handle<> await_suspend(ice::coroutine_handle<> coroutine) noexcept {
+        const auto state = promise_.state_.exchange(state::finished, std::memory_order_acq_rel);
         if (state == state::consumer_suspended) {
-          promise_.continuation_.resume();
+          return promise_.continuation_.handle();
+        }
+        if (state == state::consumer_detached) {
+          coroutine.destroy();
         }
-        return state != state::consumer_detached;
+        return ice::noop_coroutine();
       }
 
       constexpr void await_resume() noexcept {
@@ -196,24 +214,24 @@ public:
 
 private:
   struct awaitable_base {
-    awaitable_base(std::experimental::coroutine_handle<promise_type> coroutine) noexcept : coroutine_(coroutine) {
+    awaitable_base(ice::coroutine_handle<promise_type> coroutine) noexcept : coroutine_(coroutine) {
     }
 
     bool await_ready() const noexcept {
       return !coroutine_ || coroutine_.promise().is_ready();
     }
 
-    bool await_suspend(std::experimental::coroutine_handle<> awaiter) noexcept {
+    bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
       return coroutine_.promise().try_await(detail::continuation{ awaiter });
     }
 
-    std::experimental::coroutine_handle<promise_type> coroutine_{ nullptr };
+    ice::coroutine_handle<promise_type> coroutine_{ nullptr };
   };
 
 public:
   constexpr task() noexcept = default;
 
-  explicit constexpr task(std::experimental::coroutine_handle<promise_type> coroutine) : coroutine_(coroutine) {
+  explicit constexpr task(ice::coroutine_handle<promise_type> coroutine) : coroutine_(coroutine) {
   }
 
   constexpr task(task&& task) noexcept : coroutine_(task.coroutine_) {
@@ -284,7 +302,7 @@ public:
   auto get_starter() const noexcept {
     class starter {
     public:
-      constexpr starter(std::experimental::coroutine_handle<promise_type> coroutine) noexcept : coroutine_(coroutine) {
+      constexpr starter(ice::coroutine_handle<promise_type> coroutine) noexcept : coroutine_(coroutine) {
       }
 
       void start(detail::continuation continuation) noexcept {
@@ -294,7 +312,7 @@ public:
       }
 
     private:
-      std::experimental::coroutine_handle<promise_type> coroutine_;
+      ice::coroutine_handle<promise_type> coroutine_;
     };
     return starter{ coroutine_ };
   }
@@ -309,21 +327,21 @@ private:
     }
   }
 
-  std::experimental::coroutine_handle<promise_type> coroutine_{ nullptr };
+  ice::coroutine_handle<promise_type> coroutine_{ nullptr };
 };
 
 template <typename T>
 task<T> detail::task_promise<T>::get_return_object() noexcept {
-  return task<T>{ std::experimental::coroutine_handle<task_promise<T>>::from_promise(*this) };
+  return task<T>{ ice::coroutine_handle<task_promise<T>>::from_promise(*this) };
 }
 
 template <typename T>
 task<T&> detail::task_promise<T&>::get_return_object() noexcept {
-  return task<T&>{ std::experimental::coroutine_handle<task_promise<T&>>::from_promise(*this) };
+  return task<T&>{ ice::coroutine_handle<task_promise<T&>>::from_promise(*this) };
 }
 
 inline task<void> detail::task_promise<void>::get_return_object() noexcept {
-  return task<void>{ std::experimental::coroutine_handle<task_promise<void>>::from_promise(*this) };
+  return task<void>{ ice::coroutine_handle<task_promise<void>>::from_promise(*this) };
 }
 
 }  // namespace ice
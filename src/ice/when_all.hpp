@@ -0,0 +1,124 @@
+#pragma once
+#include <ice/coroutine.hpp>
+#include <ice/task.hpp>
+#include <atomic>
+#include <iterator>
+#include <tuple>
+#include <cstddef>
+
+namespace ice {
+namespace detail {
+
+class when_all_counter {
+public:
+  explicit when_all_counter(std::size_t count) noexcept : count_(count + 1) {
+  }
+
+  when_all_counter(when_all_counter&& other) = delete;
+  when_all_counter(const when_all_counter& other) = delete;
+  when_all_counter& operator=(when_all_counter&& other) = delete;
+  when_all_counter& operator=(const when_all_counter& other) = delete;
+
+  ~when_all_counter() = default;
+
+  detail::continuation continuation() noexcept {
+    return detail::continuation{ &notify, this };
+  }
+
+  void set_awaiter(ice::coroutine_handle<> awaiter) noexcept {
+    awaiter_ = awaiter;
+  }
+
+  // Releases the reference held by the awaiter and returns true if there are tasks left to wait for.
+  bool try_await() noexcept {
+    return count_.fetch_sub(1, std::memory_order_acq_rel) > 1;
+  }
+
+private:
+  static ice::coroutine_handle<> notify(void* state) noexcept {
+    const auto counter = static_cast<when_all_counter*>(state);
+    if (counter->count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      return counter->awaiter_;
+    }
+    return ice::noop_coroutine();
+  }
+
+  std::atomic_size_t count_;
+  ice::coroutine_handle<> awaiter_;
+};
+
+template <typename... T>
+class when_all_awaitable {
+public:
+  explicit when_all_awaitable(task<T>&... tasks) noexcept : tasks_(tasks...) {
+  }
+
+  bool await_ready() const noexcept {
+    return std::apply([](auto&... tasks) { return (tasks.is_ready() && ...); }, tasks_);
+  }
+
+  bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+    counter_.set_awaiter(awaiter);
+    std::apply([this](auto&... tasks) { (tasks.get_starter().start(counter_.continuation()), ...); }, tasks_);
+    return counter_.try_await();
+  }
+
+  constexpr void await_resume() const noexcept {
+  }
+
+private:
+  std::tuple<task<T>&...> tasks_;
+  when_all_counter counter_{ sizeof...(T) };
+};
+
+template <typename Range>
+class when_all_range_awaitable {
+public:
+  explicit when_all_range_awaitable(Range& tasks) noexcept :
+    tasks_(tasks), counter_(static_cast<std::size_t>(std::distance(std::begin(tasks), std::end(tasks)))) {
+  }
+
+  bool await_ready() const noexcept {
+    for (const auto& task : tasks_) {
+      if (!task.is_ready()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+    counter_.set_awaiter(awaiter);
+    for (auto& task : tasks_) {
+      task.get_starter().start(counter_.continuation());
+    }
+    return counter_.try_await();
+  }
+
+  constexpr void await_resume() const noexcept {
+  }
+
+private:
+  Range& tasks_;
+  when_all_counter counter_;
+};
+
+}  // namespace detail
+
+// Waits until all tasks are ready.
+// The awaiter is resumed on the thread that completed the last task.
+// Results are read by awaiting the tasks afterwards, which completes without suspending.
+template <typename... T>
+inline auto when_all(task<T>&... tasks) noexcept {
+  return detail::when_all_awaitable<T...>{ tasks... };
+}
+
+template <typename Range>
+requires requires(Range& tasks) {
+  std::begin(tasks)->get_starter();
+}
+inline auto when_all(Range& tasks) noexcept {
+  return detail::when_all_range_awaitable<Range>{ tasks };
+}
+
+}  // namespace ice
@@ -0,0 +1,237 @@
+#pragma once
+#include <ice/coroutine.hpp>
+#include <ice/task.hpp>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+
+namespace ice {
+
+// Index and result of the first task that was ready.
+template <typename T>
+struct when_any_result {
+  std::size_t index;
+  T value;
+};
+
+namespace detail {
+
+// Moves the result out of a task that is ready, which its awaitable returns without suspending.
+template <typename T>
+inline decltype(auto) take_result(task<T>& task) noexcept {
+  assert(task.is_ready());
+  return std::move(task).operator co_await().await_resume();
+}
+
+// Holds the result of one task of a pack with different result types.
+template <typename T>
+using when_any_value = std::conditional_t<std::is_void_v<T>, std::monostate,
+  std::conditional_t<std::is_reference_v<T>, std::reference_wrapper<std::remove_reference_t<T>>, T>>;
+
+// Shared by the when_any awaitable and the tasks it waits for.
+// The state owns the tasks and is destroyed when the awaitable and all tasks released it.
+class when_any_state {
+public:
+  constexpr static auto npos = static_cast<std::size_t>(-1);
+
+  struct slot {
+    when_any_state* state;
+    std::size_t index;
+  };
+
+  explicit when_any_state(std::size_t count) noexcept : references_(count + 1) {
+  }
+
+  when_any_state(when_any_state&& other) = delete;
+  when_any_state(const when_any_state& other) = delete;
+  when_any_state& operator=(when_any_state&& other) = delete;
+  when_any_state& operator=(const when_any_state& other) = delete;
+
+  virtual ~when_any_state() = default;
+
+  bool is_ready() const noexcept {
+    return index_.load(std::memory_order_acquire) != npos;
+  }
+
+  std::size_t index() const noexcept {
+    return index_.load(std::memory_order_acquire);
+  }
+
+  template <typename T>
+  void start(task<T>& task, slot& slot) noexcept {
+    task.get_starter().start(detail::continuation{ &notify, &slot });
+  }
+
+  bool try_await(ice::coroutine_handle<> awaiter) noexcept {
+    awaiter_ = awaiter;
+    return pending_.fetch_sub(1, std::memory_order_acq_rel) > 1;
+  }
+
+  void release() noexcept {
+    if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+private:
+  static ice::coroutine_handle<> notify(void* data) noexcept {
+    const auto& slot = *static_cast<when_any_state::slot*>(data);
+    const auto state = slot.state;
+    ice::coroutine_handle<> awaiter = ice::noop_coroutine();
+    auto index = npos;
+    if (state->index_.compare_exchange_strong(index, slot.index, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      if (state->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        awaiter = state->awaiter_;
+      }
+    }
+    state->release();
+    return awaiter;
+  }
+
+  std::atomic_size_t references_;
+  std::atomic_size_t pending_{ 2 };
+  std::atomic_size_t index_{ npos };
+  ice::coroutine_handle<> awaiter_;
+};
+
+// Returns the index for tasks without results, the index and result for tasks with the same result type
+// and the index and a variant with the result at the same index for tasks with different result types.
+template <typename... T>
+class when_any_tuple_state final : public when_any_state {
+public:
+  using first_type = std::tuple_element_t<0, std::tuple<T...>>;
+  using result_type = std::conditional_t<(std::is_void_v<T> && ...), std::size_t,
+    when_any_result<std::conditional_t<(std::is_same_v<T, first_type> && ...), first_type, std::variant<when_any_value<T>...>>>>;
+
+  explicit when_any_tuple_state(task<T>&&... tasks) noexcept : when_any_state(sizeof...(T)), tasks_(std::move(tasks)...) {
+    start(std::index_sequence_for<T...>{});
+  }
+
+  result_type result() noexcept {
+    return result(std::index_sequence_for<T...>{});
+  }
+
+private:
+  template <std::size_t... I>
+  result_type result(std::index_sequence<I...>) noexcept {
+    constexpr std::array<result_type (*)(when_any_tuple_state&), sizeof...(T)> results{ &take<I>... };
+    return results[index()](*this);
+  }
+
+  template <std::size_t I>
+  static result_type take(when_any_tuple_state& state) noexcept {
+    auto& task = std::get<I>(state.tasks_);
+    if constexpr (std::is_same_v<result_type, std::size_t>) {
+      return I;
+    } else if constexpr (std::is_void_v<std::tuple_element_t<I, std::tuple<T...>>>) {
+      return { I, std::variant<when_any_value<T>...>{ std::in_place_index<I> } };
+    } else if constexpr ((std::is_same_v<T, first_type> && ...)) {
+      return { I, take_result(task) };
+    } else {
+      return { I, std::variant<when_any_value<T>...>{ std::in_place_index<I>, take_result(task) } };
+    }
+  }
+
+  template <std::size_t... I>
+  void start(std::index_sequence<I...>) noexcept {
+    ((slots_[I] = { this, I }), ...);
+    (when_any_state::start(std::get<I>(tasks_), slots_[I]), ...);
+  }
+
+  std::tuple<task<T>...> tasks_;
+  std::array<slot, sizeof...(T)> slots_;
+};
+
+// Returns the index for tasks without results and the index and result otherwise.
+template <typename T>
+class when_any_vector_state final : public when_any_state {
+public:
+  using result_type = std::conditional_t<std::is_void_v<T>, std::size_t, when_any_result<T>>;
+
+  explicit when_any_vector_state(std::vector<task<T>>&& tasks) : when_any_state(tasks.size()), tasks_(std::move(tasks)), slots_(tasks_.size()) {
+    for (std::size_t i = 0; i < tasks_.size(); i++) {
+      slots_[i] = { this, i };
+    }
+    for (std::size_t i = 0; i < tasks_.size(); i++) {
+      when_any_state::start(tasks_[i], slots_[i]);
+    }
+  }
+
+  result_type result() noexcept {
+    const auto index = this->index();
+    if constexpr (std::is_void_v<T>) {
+      return index;
+    } else {
+      return { index, take_result(tasks_[index]) };
+    }
+  }
+
+private:
+  std::vector<task<T>> tasks_;
+  std::vector<slot> slots_;
+};
+
+template <typename State>
+class when_any_awaitable {
+public:
+  explicit when_any_awaitable(State* state) noexcept : state_(state) {
+  }
+
+  when_any_awaitable(when_any_awaitable&& other) noexcept : state_(std::exchange(other.state_, nullptr)) {
+  }
+
+  when_any_awaitable(const when_any_awaitable& other) = delete;
+  when_any_awaitable& operator=(when_any_awaitable&& other) = delete;
+  when_any_awaitable& operator=(const when_any_awaitable& other) = delete;
+
+  ~when_any_awaitable() {
+    if (state_) {
+      state_->release();
+    }
+  }
+
+  bool await_ready() const noexcept {
+    return state_->is_ready();
+  }
+
+  bool await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+    return state_->try_await(awaiter);
+  }
+
+  // The state keeps the tasks alive until the awaitable is destroyed, so the result can be moved out.
+  typename State::result_type await_resume() const noexcept {
+    return state_->result();
+  }
+
+private:
+  State* state_;
+};
+
+}  // namespace detail
+
+// Waits until the first task is ready and returns its index, or a when_any_result with its index and result.
+// The awaiter is resumed on the thread that completed the first task.
+// The tasks are taken over and destroyed once the last one of them is ready, which
+// makes when_any suitable for races where the remaining tasks are cancelled or ignored.
+// The tasks are kept in one allocated state, and the range overload allocates their
+// continuation slots as well.
+template <typename... T>
+inline auto when_any(task<T>&&... tasks) {
+  static_assert(sizeof...(T) > 0);
+  return detail::when_any_awaitable{ new detail::when_any_tuple_state<T...>(std::move(tasks)...) };
+}
+
+template <typename T>
+inline auto when_any(std::vector<task<T>> tasks) {
+  assert(!tasks.empty());
+  return detail::when_any_awaitable{ new detail::when_any_vector_state<T>(std::move(tasks)) };
+}
+
+}  // namespace ice
@@ -0,0 +1,310 @@
+#pragma once
+#include "text.hpp"
+#include <fmt/format.h>
+#if __has_include(<fmt/xchar.h>)
+#include <fmt/xchar.h>
+#endif
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// Rows of a table sorted by the case folded text of one column for type-ahead lookups.
+//
+// Rows are indexed in sorted runs. Adding a run merges it with the last run while that is not
+// larger, so that every row is merged O(log n) times and a lookup searches O(log n) runs.
+// Runs are immutable and shared between copies, so a copy of the index can be extended on the
+// pool while the original keeps answering lookups on the UI thread.
+//
+// Entries hold the first eight folded characters of their text. Only entries that share those
+// are compared by text, which is formatted on demand with text(buffer, row).
+//
+// BOOL OnFindItem(NMLVFINDITEM& item) noexcept {
+//   const auto wrap = (item.lvfi.flags & LVFI_WRAP) != 0;
+//   const auto row = index_.Find(item.lvfi.psz, item.iStart, item.iStart - 1, wrap, text);
+//   SetWindowLongPtr(hwnd_, DWLP_MSGRESULT, row);
+//   return TRUE;
+// }
+//
+class Index {
+public:
+  // The first eight folded characters of a text, two per word, so that comparing words compares text.
+  using Prefix = std::array<std::uint32_t, 4>;
+
+  struct Entry {
+    Prefix prefix;
+    std::uint32_t row;
+  };
+
+  using Run = std::vector<Entry>;
+
+  Index() = default;
+
+  void Reset() noexcept {
+    runs_.clear();
+    rows_ = 0;
+  }
+
+  // Returns the number of indexed rows.
+  std::size_t Rows() const noexcept {
+    return rows_;
+  }
+
+  // Creates a sorted run of rows begin to end. Thread safe.
+  template <typename Text>
+  static Run Sort(std::size_t begin, std::size_t end, Text&& text) noexcept {
+    assert(begin <= end);
+
+    // Rows are loaded once in order and sorted by their first 24 characters, which keeps
+    // comparisons in cache. Text after that is only kept and compared for longer rows.
+    struct Key {
+      std::array<std::uint32_t, 12> head;
+      std::uint32_t row;
+    };
+    std::vector<Key> keys(end - begin);
+    std::u16string tails;
+    std::vector<std::size_t> offsets(keys.size() + 1);
+    Loader loader;
+    for (auto row = begin; row < end; row++) {
+      const std::u16string_view value = loader.Load(text, row);
+      keys[row - begin] = { Head<12>(value), static_cast<std::uint32_t>(row) };
+      offsets[row - begin] = tails.size();
+      tails.append(value.substr(std::min(value.size(), std::size_t(24))));
+    }
+    offsets[keys.size()] = tails.size();
+
+    const auto tail = [&](std::uint32_t row) noexcept {
+      const auto i = row - begin;
+      return std::u16string_view{ tails }.substr(offsets[i], offsets[i + 1] - offsets[i]);
+    };
+    std::sort(keys.begin(), keys.end(), [&](const Key& lhs, const Key& rhs) noexcept {
+      for (std::size_t i = 0; i < lhs.head.size(); i++) {
+        if (lhs.head[i] != rhs.head[i]) {
+          return lhs.head[i] < rhs.head[i];
+        }
+      }
+      if (lhs.head.back() & 0xFFFF) {
+        if (const auto result = tail(lhs.row).compare(tail(rhs.row))) {
+          return result < 0;
+        }
+      }
+      return lhs.row < rhs.row;
+    });
+
+    Run run(keys.size());
+    for (std::size_t i = 0; i < keys.size(); i++) {
+      std::copy_n(keys[i].head.begin(), run[i].prefix.size(), run[i].prefix.begin());
+      run[i].row = keys[i].row;
+    }
+    return run;
+  }
+
+  // Adds a run created by Sort for the rows that follow the indexed rows.
+  template <typename Text>
+  void Add(Run run, Text&& text) noexcept {
+    rows_ += run.size();
+    auto next = std::make_shared<const Run>(std::move(run));
+    while (!runs_.empty() && runs_.back()->size() <= next->size()) {
+      next = std::make_shared<const Run>(Merge(*runs_.back(), *next, text));
+      runs_.pop_back();
+    }
+    runs_.push_back(std::move(next));
+  }
+
+  // Returns the first row in sort order whose text starts with prefix, ignoring case.
+  // When the start row matches, returns the start row. When the previous row, which is shown
+  // before start, matches, returns the row that follows it in sort order, so that repeated
+  // lookups cycle through all matches. Continues with the first match when wrap is true.
+  // Returns -1 otherwise.
+  template <typename Text>
+  int Find(std::wstring_view prefix, int start, int previous, bool wrap, Text&& text) const noexcept {
+    Loader loader;
+    std::u16string value;
+    for (const auto c : prefix) {
+      value.push_back(Fold(c));
+    }
+    const auto head = Head(value);
+    const auto size = std::min(value.size(), std::size_t(8));
+
+    // Returns the order of the text of an entry cut to the size of the prefix.
+    const auto compare = [&](const Entry& entry) noexcept {
+      if (const auto result = Compare(entry.prefix, head, size); result || value.size() <= 8) {
+        return result;
+      }
+      return loader.Load(text, entry.row).substr(0, value.size()).compare(value);
+    };
+
+    // Finds the row to continue from.
+    auto anchor = -1;
+    auto inclusive = true;
+    for (const auto row : { start, previous }) {
+      if (row >= 0 && static_cast<std::size_t>(row) < rows_) {
+        Entry entry{ {}, static_cast<std::uint32_t>(row) };
+        entry.prefix = Head(loader.Load(text, entry.row));
+        if (compare(entry) == 0) {
+          anchor = row;
+          break;
+        }
+      }
+      inclusive = false;
+    }
+    Entry key{};
+    std::u16string key_text;
+    if (anchor >= 0) {
+      key_text = loader.Load(text, static_cast<std::size_t>(anchor));
+      key = { Head(key_text), static_cast<std::uint32_t>(anchor) };
+    }
+
+    const Entry* next = nullptr;
+    const Entry* first = nullptr;
+    std::u16string next_text;
+    std::u16string first_text;
+    const auto before = [&](const Entry& lhs, std::u16string& lhs_text, const Entry& rhs, std::u16string& rhs_text) noexcept {
+      return Compare(lhs, lhs_text, rhs, rhs_text, loader, text) < 0;
+    };
+    for (const auto& run : runs_) {
+      const auto lo = std::partition_point(run->begin(), run->end(), [&](const Entry& entry) noexcept {
+        return compare(entry) < 0;
+      });
+      const auto hi = std::partition_point(lo, run->end(), [&](const Entry& entry) noexcept {
+        return compare(entry) == 0;
+      });
+      if (lo == hi) {
+        continue;
+      }
+      if (anchor >= 0) {
+        const auto it = std::partition_point(lo, hi, [&](const Entry& entry) noexcept {
+          std::u16string entry_text;
+          const auto result = Compare(entry, entry_text, key, key_text, loader, text);
+          return inclusive ? result < 0 : result <= 0;
+        });
+        if (it != hi) {
+          std::u16string it_text;
+          if (!next || before(*it, it_text, *next, next_text)) {
+            next = &*it;
+            next_text = std::move(it_text);
+          }
+        }
+      }
+      std::u16string lo_text;
+      if (!first || before(*lo, lo_text, *first, first_text)) {
+        first = &*lo;
+        first_text = std::move(lo_text);
+      }
+    }
+    if (next) {
+      return static_cast<int>(next->row);
+    }
+    if (first && (wrap || anchor < 0)) {
+      return static_cast<int>(first->row);
+    }
+    return -1;
+  }
+
+private:
+  // Formats rows into a reused buffer and folds their text.
+  class Loader {
+  public:
+    template <typename Text>
+    const std::u16string& Load(Text& text, std::size_t row) noexcept {
+      buffer_.clear();
+      text(buffer_, row);
+      value_.clear();
+      for (const auto c : std::wstring_view{ buffer_.data(), buffer_.size() }) {
+        value_.push_back(Fold(c));
+      }
+      return value_;
+    }
+
+  private:
+    fmt::wmemory_buffer buffer_;
+    std::u16string value_;
+  };
+
+  // Folds ASCII and Latin-1 letters to lower case.
+  static char16_t Fold(wchar_t c) noexcept {
+    return static_cast<char16_t>(std::min<std::uint32_t>(static_cast<std::uint32_t>(FoldCase(c)), 0xFFFF));
+  }
+
+  // Returns the first characters of a folded text, two per word.
+  template <std::size_t Words = 4>
+  static std::array<std::uint32_t, Words> Head(std::u16string_view text) noexcept {
+    std::array<std::uint32_t, Words> head{};
+    for (std::size_t i = 0; i < std::min(text.size(), Words * 2); i++) {
+      head[i / 2] |= static_cast<std::uint32_t>(text[i]) << (i % 2 ? 0 : 16);
+    }
+    return head;
+  }
+
+  // Compares the first size characters of two prefixes.
+  static int Compare(const Prefix& lhs, const Prefix& rhs, std::size_t size = 8) noexcept {
+    for (std::size_t i = 0; i * 2 < size; i++) {
+      const auto shift = i * 2 + 1 == size ? 16 : 0;
+      const auto l = lhs[i] >> shift;
+      const auto r = rhs[i] >> shift;
+      if (l != r) {
+        return l < r ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  // Returns true if the text of an entry may be longer than its prefix.
+  static bool Long(const Entry& entry) noexcept {
+    return (entry.prefix[3] & 0xFFFF) != 0;
+  }
+
+  // Compares entries by text and row. Texts are loaded into lhs_text and rhs_text when they are
+  // needed and still empty, so that callers can keep them for further comparisons.
+  template <typename Text>
+  static int Compare(const Entry& lhs, std::u16string& lhs_text, const Entry& rhs, std::u16string& rhs_text, Loader& loader, Text& text) noexcept {
+    if (const auto result = Compare(lhs.prefix, rhs.prefix)) {
+      return result;
+    }
+    if (Long(lhs)) {
+      if (lhs_text.empty()) {
+        lhs_text = loader.Load(text, lhs.row);
+      }
+      if (rhs_text.empty()) {
+        rhs_text = loader.Load(text, rhs.row);
+      }
+      if (const auto result = lhs_text.compare(rhs_text)) {
+        return result;
+      }
+    }
+    return lhs.row < rhs.row ? -1 : lhs.row > rhs.row ? 1 : 0;
+  }
+
+  // Merges two runs and loads the text of each entry at most once.
+  template <typename Text>
+  static Run Merge(const Run& lhs, const Run& rhs, Text& text) noexcept {
+    Run run;
+    run.reserve(lhs.size() + rhs.size());
+    Loader loader;
+    std::u16string lhs_text;
+    std::u16string rhs_text;
+    auto i = lhs.begin();
+    auto j = rhs.begin();
+    while (i != lhs.end() && j != rhs.end()) {
+      if (Compare(*i, lhs_text, *j, rhs_text, loader, text) <= 0) {
+        run.push_back(*i++);
+        lhs_text.clear();
+      } else {
+        run.push_back(*j++);
+        rhs_text.clear();
+      }
+    }
+    run.insert(run.end(), i, lhs.end());
+    run.insert(run.end(), j, rhs.end());
+    return run;
+  }
+
+  std::vector<std::shared_ptr<const Run>> runs_;
+  std::size_t rows_ = 0;
+};
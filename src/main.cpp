@@ -1,16 +1,35 @@
 #include "main.hpp"
+#include "aggregate.hpp"
+#include "csv.hpp"
 #include "dialog.hpp"
+#include "filter.hpp"
+#include "index.hpp"
+#include "prefetcher.hpp"
+#include "search.hpp"
+#include "sort.hpp"
 #include "status.hpp"
+#include "store.hpp"
 #include "table.hpp"
 #include <ice/context.hpp>
+#include <ice/pool.hpp>
 #include <ice/utility.hpp>
+#include <ice/when_all.hpp>
 #include <comdef.h>
+#include <shellapi.h>
 #include <fmt/format.h>
 #include <wincodec.h>
 #include <wrl/client.h>
 #include <string>
 #include <string_view>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <stop_token>
 #include <thread>
+#include <type_traits>
+#include <variant>
 #include <vector>
 
 #include <fstream>
@@ -26,13 +45,15 @@ public:
   // -----------------|---------|------------------------
   // 0                | top     | DIALOGEX 0, 0, 400, 200
   // 2                | padding | TOPMARGIN, 2
+  // 2 + 12           | search  | 3,2,253,12
+  // 2 + 14 + 169     | table   | 3,16,253,169
   // 2 + 183          | padding | BOTTOMMARGIN, 185
   // 2 + 183 + 2      | task    | 0,187,400,13
   // 2 + 183 + 2 + 13 | bottom  | DIALOGEX 0, 0, 400, 200
 
   constexpr static auto settings = L"Software\\Xiphos\\Carta";
 
-  Application(HINSTANCE hinstance) noexcept {
+  Application(HINSTANCE hinstance, std::filesystem::path path) noexcept : path_(std::move(path)) {
     thread_ = std::thread([this]() { io_.run(); });
     Create(hinstance, nullptr, IDD_MAIN, IDI_MAIN);
   }
@@ -46,6 +67,10 @@ public:
     return io_.schedule(false);
   }
 
+  auto Pool() noexcept {
+    return pool_.schedule(false);
+  }
+
   void Close() noexcept {
     EnableWindow(hwnd_, FALSE);
     PostMessage(hwnd_, WM_CLOSE, 0, 0);
@@ -64,10 +89,8 @@ public:
   ice::task<void> OnCreate() noexcept {
     status_ = GetControl(IDC_STATUS);
     table_ = GetControl(IDC_TABLE);
-    for (int col = 0; col < 10; col++) {
-      table_.AddColumn(fmt::format(L"Column {}", col).data(), 100);
-    }
-    table_.Resize(100'000'000);
+    search_ = GetControl(IDC_SEARCH);
+    Edit_SetCueBannerText(search_, L"Search");
 
     auto hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
     if (FAILED(hr)) {
@@ -112,9 +135,713 @@ public:
     } else {
       ShowWindow(hwnd_, SW_SHOW);
     }
+
+    if (path_.empty()) {
+      co_await LoadSample(1'000'000);
+    } else {
+      co_await OpenFile(path_);
+    }
     co_return;
   }
 
+  // Stops loading the current source and returns the token for the next one.
+  std::stop_token Cancel() noexcept {
+    load_.request_stop();
+    load_ = {};
+    return load_.get_token();
+  }
+
+  ice::task<void> LoadSample(std::size_t rows) noexcept {
+    auto state = status_.Set(L"Loading...");
+    const auto token = Cancel();
+    co_await Pool();
+    auto store = CreateSample(rows);
+    co_await Ui();
+    if (!token.stop_requested()) {
+      SetSource(std::make_shared<Store>(std::move(store)));
+      co_await UpdateIndex();
+      co_await UpdateTotals();
+    }
+  }
+
+  // Shows the first rows as soon as they are indexed and grows the table while the
+  // rest of the file is scanned in parallel chunks on the pool.
+  ice::task<void> OpenFile(std::filesystem::path path) noexcept {
+    const auto name = path.filename().wstring();
+    auto state = status_.Set(L"Opening " + name + L"...");
+    const auto token = Cancel();
+    co_await Pool();
+    const auto csv = std::make_shared<Csv>();
+    if (!csv->Open(path)) {
+      co_await Ui();
+      ShowError(L"Could not open file.", path.wstring());
+      co_return;
+    }
+    const auto data = csv->Data();
+    auto chunks = csv->Split();
+    co_await Ui();
+    if (token.stop_requested()) {
+      co_return;
+    }
+    SetSource(csv);
+    const std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 0; i < chunks.size();) {
+      const auto count = i == 0 ? 1 : std::min(threads, chunks.size() - i);
+      // Rows that were appended after the previous batch are indexed and aggregated while the next batch is scanned.
+      auto index = index_;
+      auto totals = totals_;
+      std::vector<ice::task<void>> scans;
+      scans.reserve(count + 2);
+      for (std::size_t j = i; j < i + count; j++) {
+        scans.push_back(Scan(data, chunks[j]));
+      }
+      scans.push_back(IndexRows(csv, index));
+      scans.push_back(TotalRows(csv, totals));
+      co_await ice::when_all(scans);
+      co_await Ui();
+      if (token.stop_requested()) {
+        co_return;
+      }
+      index_ = std::move(index);
+      totals_ = std::move(totals);
+      ShowTotals(totals_, false);
+      for (std::size_t j = i; j < i + count; j++) {
+        csv->Append(chunks[j]);
+        chunks[j] = {};
+      }
+      table_.Resize(std::min(csv->Rows(), Table::capacity));
+      i += count;
+      const auto done = i < chunks.size() ? chunks[i].begin : data.size();
+      state.Set(fmt::format(L"Indexing {}... {}%", name, data.empty() ? 100 : done * 100 / data.size()));
+    }
+    co_await UpdateIndex();
+    co_await UpdateTotals();
+    if (sort_col_ >= 0) {
+      co_await SortTable();
+    } else {
+      co_await FilterTable();
+    }
+  }
+
+  ice::task<void> Scan(std::string_view data, Csv::Chunk& chunk) noexcept {
+    co_await pool_.schedule(true);
+    Csv::Scan(data, chunk);
+  }
+
+  // Returns a callback that appends the text of the first column of a row, which the index sorts by.
+  template <typename Source>
+  static auto KeyText(const std::shared_ptr<Source>& source) noexcept {
+    return [source = source.get()](auto& buffer, std::size_t row) noexcept {
+      source->Format(buffer, static_cast<int>(row), 0);
+    };
+  }
+
+  // Adds the rows of a source that are not in the index yet, sorting chunks of rows in parallel.
+  // The rows must not change until the task completes.
+  template <typename Source>
+  ice::task<void> IndexRows(std::shared_ptr<Source> source, Index& index) noexcept {
+    co_await pool_.schedule(ice::priority::bulk, true);
+    const auto begin = index.Rows();
+    const auto end = std::min(source->Rows(), Table::capacity);
+    if (source->Cols() == 0 || begin >= end) {
+      co_return;
+    }
+    const auto text = KeyText(source);
+    const std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const auto size = (end - begin + threads - 1) / threads;
+    std::vector<Index::Run> runs((end - begin + size - 1) / size);
+    std::vector<ice::task<void>> sorts;
+    sorts.reserve(runs.size());
+    for (std::size_t i = 0; i < runs.size(); i++) {
+      sorts.push_back(SortRows(begin + i * size, std::min(end, begin + (i + 1) * size), text, runs[i]));
+    }
+    co_await ice::when_all(sorts);
+    for (auto& run : runs) {
+      index.Add(std::move(run), text);
+    }
+  }
+
+  template <typename Text>
+  ice::task<void> SortRows(std::size_t begin, std::size_t end, const Text& text, Index::Run& run) noexcept {
+    co_await pool_.schedule(ice::priority::bulk, true);
+    run = Index::Sort(begin, end, text);
+  }
+
+  // Indexes the rows of the current source that are not in the index yet.
+  ice::task<void> UpdateIndex() noexcept {
+    auto index = index_;
+    const auto data = data_;
+    const auto generation = generation_;
+    co_await std::visit([&](const auto& source) noexcept { return IndexRows(source, index); }, data);
+    co_await Ui();
+    if (generation == generation_) {
+      index_ = std::move(index);
+    }
+  }
+
+  static Store CreateSample(std::size_t rows) noexcept {
+    Store store;
+    auto& id = store.AddColumn(L"Id", ColumnType::Int64);
+    auto& time = store.AddColumn(L"Time", ColumnType::Timestamp);
+    auto& name = store.AddColumn(L"Name", ColumnType::String);
+    auto& value = store.AddColumn(L"Value", ColumnType::Double, 2);
+    for (std::size_t col = 0; col < store.Cols(); col++) {
+      store[col].Reserve(rows);
+    }
+    constexpr std::string_view names[] = { "Alpha", "Bravo", "Charlie", "Delta", "Echo", "Foxtrot", "Golf", "Hotel" };
+    std::mt19937_64 random{ 0 };
+    std::int64_t timestamp = 1'577'836'800'000'000;
+    for (std::size_t row = 0; row < rows; row++) {
+      timestamp += static_cast<std::int64_t>(random() % 60'000'000);
+      id.Append(static_cast<std::int64_t>(row));
+      time.Append(timestamp);
+      name.Append(names[random() % std::size(names)]);
+      value.Append(static_cast<double>(random() % 1'000'000) / 100.0);
+    }
+    return store;
+  }
+
+  template <typename Source>
+  void SetSource(std::shared_ptr<Source> source) noexcept {
+    data_ = source;
+    generation_++;
+    prefetcher_.Reset();
+    prefetch_.request_stop();
+    index_.Reset();
+    sort_.request_stop();
+    sort_col_ = -1;
+    order_ = std::make_shared<const Permutation>();
+    select_.request_stop();
+    filter_ = {};
+    view_ = std::make_shared<const Selection>(order_);
+    total_.request_stop();
+    totals_ = {};
+    status_.Summary({});
+    table_.Reset();
+    for (std::size_t col = 0; col < source->Cols(); col++) {
+      table_.AddColumn(source->Name(col).data(), 100);
+    }
+    table_.Resize(std::min(source->Rows(), Table::capacity));
+    SetWindowText(search_, L"");
+  }
+
+  // Returns true if the rows of the current source can be read off the UI thread.
+  // A Csv is only read off the UI thread once its index is complete.
+  bool Ready() const noexcept {
+    return std::visit([](const auto& source) noexcept {
+      if constexpr (std::is_same_v<std::decay_t<decltype(*source)>, Csv>) {
+        return source->Complete();
+      } else {
+        return true;
+      }
+    }, data_);
+  }
+
+  // Returns the number of rows of the current source that the table can show.
+  std::size_t Rows() const noexcept {
+    return std::visit([](const auto& source) noexcept { return std::min(source->Rows(), Table::capacity); }, data_);
+  }
+
+  // Returns a callback that formats the cells of the table through the rows shown by a view.
+  template <typename Source>
+  static auto CellText(const std::shared_ptr<Source>& source, const std::shared_ptr<const Selection>& view) noexcept {
+    return [source = source.get(), view = view.get()](auto& text, int row, int col) noexcept {
+      source->Format(text, view->Row(row), col);
+    };
+  }
+
+  // Stops the current prefetch and returns the token for the next one.
+  std::stop_token CancelPrefetch() noexcept {
+    prefetch_.request_stop();
+    prefetch_ = {};
+    return prefetch_.get_token();
+  }
+
+  // Formats rows min to max on the pool and hands them to the table for the next cache hint.
+  // A newer prediction replaces the rows of a prefetch that is still running.
+  ice::task<void> Prefetch(int min, int max) noexcept {
+    const auto token = CancelPrefetch();
+    if (!Ready()) {
+      co_return;
+    }
+    const auto data = data_;
+    const auto view = view_;
+    const auto cols = table_.Cols();
+    const auto generation = generation_;
+    Cells cells;
+    if (!co_await pool_.schedule(token, ice::priority::interactive)) {
+      co_return;
+    }
+    std::visit([&](const auto& source) noexcept {
+      cells.Set(min, max, cols, CellText(source, view));
+    }, data);
+    if (token.stop_requested()) {
+      co_return;
+    }
+    co_await Ui();
+    if (!token.stop_requested() && generation == generation_ && view == view_) {
+      table_.Prefetch(std::move(cells));
+    }
+  }
+
+  // Returns the value of a field without the quotes around it.
+  static std::string_view Unquote(std::string_view value) noexcept {
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+      value = value.substr(1, value.size() - 2);
+    }
+    return value;
+  }
+
+  // Prepares sorting the rows of a store by a column. Strings are sorted by the rank of their dictionary code.
+  static void PrepareSort(Sorter& sorter, const Store& store, std::size_t col, std::size_t rows, std::size_t jobs, bool descending) noexcept {
+    const auto& column = store[col];
+    switch (column.Type()) {
+    case ColumnType::Int64:
+    case ColumnType::Timestamp:
+      sorter.Integers(rows, jobs, descending, [values = column.Integers()](std::size_t row) noexcept {
+        return Sorter::Key(values[row]);
+      });
+      break;
+    case ColumnType::Double:
+      sorter.Integers(rows, jobs, descending, [values = column.Doubles()](std::size_t row) noexcept {
+        return Sorter::Key(values[row]);
+      });
+      break;
+    case ColumnType::String:
+      sorter.Integers(rows, jobs, descending, [codes = column.Codes(), ranks = column.Dictionary().Ranks()](std::size_t row) noexcept {
+        return std::uint64_t{ ranks[codes[row]] };
+      });
+      break;
+    }
+  }
+
+  // Prepares sorting the rows of a file by a column. Columns whose first rows are all numbers or
+  // empty are sorted by value with empty and invalid fields first, other columns by their text.
+  static void PrepareSort(Sorter& sorter, const Csv& csv, std::size_t col, std::size_t rows, std::size_t jobs, bool descending) noexcept {
+    const auto field = [csv = &csv, col](std::size_t row) noexcept {
+      return Unquote(csv->Field(row, col));
+    };
+    const auto parse = [](std::string_view value, double& number) noexcept {
+      const auto end = value.data() + value.size();
+      const auto [ptr, ec] = std::from_chars(value.data(), end, number);
+      return ec == std::errc{} && ptr == end;
+    };
+    auto numeric = true;
+    for (std::size_t row = 0; row < std::min(rows, std::size_t(1000)) && numeric; row++) {
+      double number = 0.0;
+      const auto value = field(row);
+      numeric = value.empty() || parse(value, number);
+    }
+    if (numeric) {
+      sorter.Integers(rows, jobs, descending, [field, parse](std::size_t row) noexcept {
+        double number = 0.0;
+        return parse(field(row), number) ? Sorter::Key(number) : 0;
+      });
+    } else {
+      sorter.Strings(rows, jobs, descending, field);
+    }
+  }
+
+  // Stops sorting the current source and returns the token for the next sort.
+  std::stop_token CancelSort() noexcept {
+    sort_.request_stop();
+    sort_ = {};
+    return sort_.get_token();
+  }
+
+  // Sorts the rows by the selected column in parallel steps on the pool and shows them in the new order.
+  // The steps are advanced on the pool, so that the UI thread only updates the progress.
+  // Sorting a Csv waits until its index is complete and is started again by OpenFile.
+  ice::task<void> SortTable() noexcept {
+    const auto token = CancelSort();
+    if (sort_col_ < 0 || !Ready()) {
+      co_return;
+    }
+    const auto col = static_cast<std::size_t>(sort_col_);
+    const auto descending = sort_descending_;
+    const auto data = data_;
+    const auto generation = generation_;
+    const auto rows = Rows();
+    const std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    auto state = status_.Set(L"Sorting...");
+    Sorter sorter;
+    co_await pool_.schedule(ice::priority::bulk, true);
+    std::visit([&](const auto& source) noexcept {
+      PrepareSort(sorter, *source, col, rows, threads, descending);
+    }, data);
+    while (sorter.Jobs()) {
+      std::vector<ice::task<void>> jobs;
+      jobs.reserve(sorter.Jobs());
+      for (std::size_t job = 0; job < sorter.Jobs(); job++) {
+        jobs.push_back(SortJob(sorter, job));
+      }
+      co_await ice::when_all(jobs);
+      if (token.stop_requested()) {
+        break;
+      }
+      sorter.Next();
+      const auto progress = sorter.Progress();
+      co_await Ui();
+      if (token.stop_requested() || generation != generation_) {
+        co_return;
+      }
+      state.Set(fmt::format(L"Sorting... {}%", progress));
+    }
+    co_await Ui();
+    if (token.stop_requested() || generation != generation_) {
+      co_return;
+    }
+    order_ = std::make_shared<const Permutation>(sorter.Result());
+    table_.Sort(static_cast<int>(col), descending);
+    state.Clear();
+    co_await FilterTable();
+  }
+
+  ice::task<void> SortJob(Sorter& sorter, std::size_t job) noexcept {
+    co_await pool_.schedule(ice::priority::bulk, true);
+    sorter.Run(job);
+  }
+
+  // Prepares the kernels that filter the rows of a store. Numeric predicates on numeric columns
+  // compare values, string predicates are evaluated once for each value of a dictionary.
+  // A search only formats numeric columns when its text can occur in their values.
+  static void PrepareFilter(Selector& selector, const Store& store, const Filter& filter) noexcept {
+    for (const auto& predicate : filter.Predicates()) {
+      if (predicate.Col() == Predicate::any) {
+        std::vector<Selector::Kernel> kernels;
+        for (std::size_t col = 0; col < store.Cols(); col++) {
+          const auto& column = store[col];
+          const auto text = [column = &column](fmt::wmemory_buffer& buffer, std::size_t row) noexcept {
+            column->Format(buffer, row);
+          };
+          const auto possible = [&](std::wstring_view chars) noexcept {
+            return predicate.Text().find_first_not_of(chars) == std::wstring::npos;
+          };
+          switch (column.Type()) {
+          case ColumnType::Int64:
+            if (possible(L"-0123456789")) {
+              kernels.push_back(Selector::Texts(predicate, text));
+            }
+            break;
+          case ColumnType::Double:
+            if (possible(L"-+.0123456789aefin")) {
+              kernels.push_back(Selector::Texts(predicate, text));
+            }
+            break;
+          case ColumnType::Timestamp:
+            if (possible(L"-.: 0123456789")) {
+              kernels.push_back(Selector::Texts(predicate, text));
+            }
+            break;
+          case ColumnType::String:
+            kernels.push_back(Selector::Codes(predicate, column.Codes(), column.Dictionary().Size(), [column = &column](fmt::wmemory_buffer& buffer, std::size_t code) noexcept {
+              AppendUtf16(buffer, column->Dictionary().Get(static_cast<std::uint32_t>(code)));
+            }));
+            break;
+          }
+        }
+        selector.Add(Selector::Any(std::move(kernels)));
+        continue;
+      }
+      const auto& column = store[predicate.Col()];
+      const auto text = [column = &column](fmt::wmemory_buffer& buffer, std::size_t row) noexcept {
+        column->Format(buffer, row);
+      };
+      switch (column.Type()) {
+      case ColumnType::Int64:
+        selector.Add(predicate.Numeric() ? Selector::Integers(predicate, column.Integers()) : Selector::Texts(predicate, text));
+        break;
+      case ColumnType::Double:
+        selector.Add(predicate.Numeric() ? Selector::Doubles(predicate, column.Doubles()) : Selector::Texts(predicate, text));
+        break;
+      case ColumnType::Timestamp:
+        selector.Add(Selector::Texts(predicate, text));
+        break;
+      case ColumnType::String:
+        selector.Add(Selector::Codes(predicate, column.Codes(), column.Dictionary().Size(), [column = &column](fmt::wmemory_buffer& buffer, std::size_t code) noexcept {
+          AppendUtf16(buffer, column->Dictionary().Get(static_cast<std::uint32_t>(code)));
+        }));
+        break;
+      }
+    }
+  }
+
+  // Prepares the kernels that filter the rows of a file by the text of their fields.
+  // A search for ASCII text scans the bytes of the file. Other searches decode every field.
+  static void PrepareFilter(Selector& selector, const Csv& csv, const Filter& filter) noexcept {
+    for (const auto& predicate : filter.Predicates()) {
+      if (predicate.Col() == Predicate::any) {
+        const std::string reserved{ '"', '\r', '\n', csv.Delimiter() };
+        if (Needle needle; Needle::Create(predicate.Text(), reserved, needle)) {
+          selector.Add(SearchRows(std::move(needle), [csv = &csv](std::size_t row) noexcept { return csv->Row(row); }));
+        } else {
+          selector.Add(Selector::Texts(predicate, [csv = &csv](fmt::wmemory_buffer& buffer, std::size_t row) noexcept {
+            for (std::size_t col = 0; col < csv->Cols(); col++) {
+              if (col > 0) {
+                buffer.push_back(L'\n');
+              }
+              csv->Format(buffer, static_cast<int>(row), static_cast<int>(col));
+            }
+          }));
+        }
+        continue;
+      }
+      selector.Add(Selector::Texts(predicate, [csv = &csv, col = static_cast<int>(predicate.Col())](fmt::wmemory_buffer& buffer, std::size_t row) noexcept {
+        csv->Format(buffer, static_cast<int>(row), col);
+      }));
+    }
+  }
+
+  // Stops filtering the current source and returns the token for the next filter.
+  std::stop_token CancelFilter() noexcept {
+    select_.request_stop();
+    select_ = {};
+    return select_.get_token();
+  }
+
+  // Shows the rows that match the filter in the current order. Matches are collected in parallel jobs on the pool
+  // and shown while the scan continues, whenever the number of finished jobs doubled, so that the first matches
+  // appear right away. When the filter only tightens the one that selected the shown rows, only those rows are
+  // evaluated again.
+  ice::task<void> FilterTable() noexcept {
+    const auto token = CancelFilter();
+    if (!Ready() || (filter_.Empty() && view_->Filter().Empty() && view_->Order() == order_)) {
+      co_return;
+    }
+    const auto filter = filter_;
+    const auto order = order_;
+    const auto view = view_;
+    const auto data = data_;
+    const auto generation = generation_;
+    const auto rows = Rows();
+    if (filter.Empty()) {
+      Show(std::make_shared<const Selection>(order), rows);
+      co_await UpdateTotals();
+      co_return;
+    }
+    auto state = status_.Set(L"Filtering...");
+    const auto refine = !view->Filter().Empty() && view->Complete() && view->Order() == order && filter.Implies(view->Filter());
+    const auto input = refine ? &view->Positions() : nullptr;
+    const std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    Selector selector;
+    co_await pool_.schedule(true);
+    std::visit([&](const auto& source) noexcept {
+      PrepareFilter(selector, *source, filter);
+    }, data);
+    selector.Start(*order, rows, input, std::max(threads * 4, (input ? input->size() : rows) >> 18));
+    for (std::size_t begin = 0, next = threads; begin < selector.Jobs();) {
+      const auto end = std::min(selector.Jobs(), begin + threads);
+      std::vector<ice::task<void>> jobs;
+      jobs.reserve(end - begin);
+      for (auto job = begin; job < end; job++) {
+        jobs.push_back(FilterJob(selector, job, token));
+      }
+      co_await ice::when_all(jobs);
+      if (token.stop_requested()) {
+        // The status state must be destroyed on the UI thread.
+        co_await Ui();
+        co_return;
+      }
+      begin = end;
+      const auto complete = end == selector.Jobs();
+      if (!complete && end < next) {
+        continue;
+      }
+      next = end * 2;
+      auto selection = std::make_shared<const Selection>(order, filter, selector.Result(end), complete);
+      co_await Ui();
+      if (token.stop_requested() || generation != generation_) {
+        co_return;
+      }
+      Show(std::move(selection), rows);
+      if (!complete) {
+        state.Set(fmt::format(L"Filtering... {}%", end * 100 / selector.Jobs()));
+        co_await pool_.schedule(true);
+      }
+    }
+    state.Clear();
+    co_await UpdateTotals();
+  }
+
+  // Shows the rows of a view of a source with the given number of rows.
+  void Show(std::shared_ptr<const Selection> view, std::size_t rows) noexcept {
+    view_ = std::move(view);
+    prefetcher_.Reset();
+    prefetch_.request_stop();
+    table_.Resize(view_->Size(rows));
+    std::visit([&](const auto& source) noexcept { table_.Reload(CellText(source, view_)); }, data_);
+  }
+
+  ice::task<void> FilterJob(Selector& selector, std::size_t job, std::stop_token token) noexcept {
+    co_await pool_.schedule(true);
+    selector.Run(job, token);
+  }
+
+  // Prepares aggregating the columns of a store. Strings are counted by their dictionary code.
+  static void PrepareTotals(Aggregator& aggregator, const Store& store) noexcept {
+    for (std::size_t col = 0; col < store.Cols(); col++) {
+      const auto& column = store[col];
+      switch (column.Type()) {
+      case ColumnType::Int64:
+      case ColumnType::Timestamp:
+        aggregator.Add(Aggregator::Integers(column.Integers()));
+        break;
+      case ColumnType::Double:
+        aggregator.Add(Aggregator::Doubles(column.Doubles()));
+        break;
+      case ColumnType::String:
+        aggregator.Add(Aggregator::Codes(column.Codes()));
+        break;
+      }
+    }
+  }
+
+  // Prepares aggregating the fields of a file. Fields that are numbers are summed.
+  static void PrepareTotals(Aggregator& aggregator, const Csv& csv) noexcept {
+    for (std::size_t col = 0; col < csv.Cols(); col++) {
+      aggregator.Add(Aggregator::Texts([csv = &csv, col](std::size_t row) noexcept {
+        return Unquote(csv->Field(row, col));
+      }));
+    }
+  }
+
+  // Adds the rows of a source that are not in the totals yet in parallel jobs.
+  // The rows must not change until the task completes.
+  template <typename Source>
+  ice::task<void> TotalRows(std::shared_ptr<Source> source, Totals& totals) noexcept {
+    co_await pool_.schedule(ice::priority::bulk, true);
+    const auto begin = totals.rows;
+    const auto end = std::min(source->Rows(), Table::capacity);
+    if (begin >= end) {
+      co_return;
+    }
+    const std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    Aggregator aggregator;
+    PrepareTotals(aggregator, *source);
+    aggregator.Start(begin, end, nullptr, threads);
+    std::vector<ice::task<void>> jobs;
+    jobs.reserve(aggregator.Jobs());
+    for (std::size_t job = 0; job < aggregator.Jobs(); job++) {
+      jobs.push_back(TotalJob(aggregator, job, {}));
+    }
+    co_await ice::when_all(jobs);
+    totals.Merge(aggregator.Result());
+  }
+
+  ice::task<void> TotalJob(Aggregator& aggregator, std::size_t job, std::stop_token token) noexcept {
+    co_await pool_.schedule(ice::priority::bulk, true);
+    aggregator.Run(job, token);
+  }
+
+  // Stops aggregating the current view and returns the token for the next one.
+  std::stop_token CancelTotals() noexcept {
+    total_.request_stop();
+    total_ = {};
+    return total_.get_token();
+  }
+
+  // Shows the totals of the rows of the current view. The totals of all rows are kept and only the rows that
+  // were appended since are added to them. A filtered view is aggregated again. Rows are aggregated in parallel
+  // jobs on the pool, and the totals so far are shown whenever the number of finished jobs doubled.
+  ice::task<void> UpdateTotals() noexcept {
+    const auto token = CancelTotals();
+    if (!Ready() || !view_->Complete()) {
+      co_return;
+    }
+    const auto view = view_;
+    const auto data = data_;
+    const auto generation = generation_;
+    const auto filtered = !view->Filter().Empty();
+    auto totals = filtered ? Totals{} : totals_;
+    const auto begin = totals.rows;
+    const auto end = filtered ? view->Size(0) : Rows();
+    if (begin >= end) {
+      ShowTotals(totals, true);
+      co_return;
+    }
+    auto state = status_.Set(L"Aggregating...");
+    const std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    Aggregator aggregator;
+    co_await pool_.schedule(ice::priority::bulk, true);
+    std::visit([&](const auto& source) noexcept {
+      PrepareTotals(aggregator, *source);
+    }, data);
+    aggregator.Start(begin, end, filtered ? view.get() : nullptr, std::max(threads * 4, (end - begin) >> 18));
+    for (std::size_t first = 0, next = threads; first < aggregator.Jobs();) {
+      const auto last = std::min(aggregator.Jobs(), first + threads);
+      std::vector<ice::task<void>> jobs;
+      jobs.reserve(last - first);
+      for (auto job = first; job < last; job++) {
+        jobs.push_back(TotalJob(aggregator, job, token));
+      }
+      co_await ice::when_all(jobs);
+      if (token.stop_requested()) {
+        co_await Ui();
+        co_return;
+      }
+      first = last;
+      const auto complete = last == aggregator.Jobs();
+      if (!complete && last < next) {
+        continue;
+      }
+      next = last * 2;
+      auto partial = totals;
+      partial.Merge(aggregator.Result(last));
+      co_await Ui();
+      if (token.stop_requested() || generation != generation_ || (filtered ? view != view_ : !view_->Filter().Empty())) {
+        co_return;
+      }
+      if (complete && !filtered && totals_.rows == begin) {
+        totals_ = partial;
+      }
+      ShowTotals(partial, complete);
+      if (!complete) {
+        state.Set(fmt::format(L"Aggregating... {}%", last * 100 / aggregator.Jobs()));
+        co_await pool_.schedule(ice::priority::bulk, true);
+      }
+    }
+  }
+
+  // Shows the number of rows and the totals of every column in the summary of the status bar.
+  void ShowTotals(const Totals& totals, bool complete) noexcept {
+    fmt::wmemory_buffer text;
+    fmt::format_to(std::back_inserter(text), L"{} rows", totals.rows);
+    std::visit([&](const auto& source) noexcept {
+      for (std::size_t col = 0; col < std::min(totals.cols.size(), source->Cols()); col++) {
+        const auto& name = source->Name(col);
+        fmt::format_to(std::back_inserter(text), L"  |  {}: ", name);
+        FormatTotal(text, totals.cols[col], Timestamps(*source, col));
+      }
+    }, data_);
+    if (!complete) {
+      fmt::format_to(std::back_inserter(text), L"...");
+    }
+    status_.Summary({ text.data(), text.size() });
+  }
+
+  // Appends the count, the sum, minimum and maximum of numbers and the estimated number of distinct values.
+  // Timestamps show their range instead of a sum.
+  static void FormatTotal(fmt::wmemory_buffer& text, const Aggregate& aggregate, bool timestamps) noexcept {
+    fmt::format_to(std::back_inserter(text), L"n={}", aggregate.Count());
+    if (aggregate.Numbers() && timestamps) {
+      fmt::format_to(std::back_inserter(text), L" from ");
+      AppendTimestamp(text, static_cast<std::int64_t>(aggregate.Min()));
+      fmt::format_to(std::back_inserter(text), L" to ");
+      AppendTimestamp(text, static_cast<std::int64_t>(aggregate.Max()));
+    } else if (aggregate.Numbers()) {
+      fmt::format_to(std::back_inserter(text), L" sum={:.15g} min={:.15g} max={:.15g}", aggregate.Sum(), aggregate.Min(), aggregate.Max());
+    }
+    fmt::format_to(std::back_inserter(text), L" distinct~{}", aggregate.Distinct());
+  }
+
+  static bool Timestamps(const Store& store, std::size_t col) noexcept {
+    return store[col].Type() == ColumnType::Timestamp;
+  }
+
+  static bool Timestamps(const Csv&, std::size_t) noexcept {
+    return false;
+  }
+
   ice::task<void> OnClose() noexcept {
     ShowWindow(hwnd_, SW_HIDE);
     WINDOWPLACEMENT wp = {};
@@ -133,16 +860,20 @@ public:
   }
 
   BOOL OnSize(LONG cx, LONG cy) noexcept {
+    const auto shwnd = GetControl(IDC_SEARCH);
     const auto thwnd = GetControl(IDC_TABLE);
     const auto phwnd = GetControl(IDC_PREVIEW);
+    RECT src = {};
+    GetWindowRect(shwnd, &src);
     RECT trc = {};
     GetWindowRect(thwnd, &trc);
     RECT prc = {};
     GetWindowRect(phwnd, &prc);
     MapWindowPoints(nullptr, hwnd_, reinterpret_cast<PPOINT>(&prc), 2);
     const auto dx = (prc.bottom - prc.top) * 210L / 297L - (prc.right - prc.left);
-    const auto wp = BeginDeferWindowPos(2);
+    const auto wp = BeginDeferWindowPos(3);
     constexpr auto tflags = SWP_NOZORDER | SWP_NOREPOSITION | SWP_NOACTIVATE | SWP_NOCOPYBITS | SWP_NOMOVE;
+    DeferWindowPos(wp, shwnd, nullptr, 0, 0, src.right - src.left - dx, src.bottom - src.top, tflags);
     DeferWindowPos(wp, thwnd, nullptr, 0, 0, trc.right - trc.left - dx, trc.bottom - trc.top, tflags);
     constexpr auto pflags = SWP_NOZORDER | SWP_NOREPOSITION | SWP_NOACTIVATE | SWP_NOCOPYBITS;
     DeferWindowPos(wp, phwnd, nullptr, prc.left - dx, prc.top, prc.right - prc.left + dx, prc.bottom - prc.top, pflags);
@@ -157,9 +888,9 @@ public:
   //  co_await Io();
   //
   //  auto state = status_.Set(L"One...");
-  //  Sleep(1000);
+  //  co_await io_.schedule_after(std::chrono::seconds(1));
   //  state.Set(L"Two...");
-  //  Sleep(1000);
+  //  co_await io_.schedule_after(std::chrono::seconds(1));
   //
   //  // TODO
   //
@@ -185,6 +916,8 @@ public:
       return OnMenu(id);
     case 1:
       return OnAccelerator(id);
+    case EN_CHANGE:
+      return id == IDC_SEARCH ? OnFilterChange() : FALSE;
     }
     return FALSE;
   }
@@ -194,11 +927,67 @@ public:
   }
 
   BOOL OnCacheHint(NMLVCACHEHINT& hint) noexcept {
-    return table_.Set(hint.iFrom, hint.iTo, [this](auto& text, int row, int col) noexcept { fmt::format_to(text, L"{:09}:{:02}", row, col); });
+    auto result = TRUE;
+    if (!table_.Swap(hint.iFrom, hint.iTo)) {
+      result = std::visit([&](const auto& source) noexcept {
+        return table_.Set(hint.iFrom, hint.iTo, CellText(source, view_));
+      }, data_);
+    }
+    const auto contains = [this](int min, int max) noexcept { return table_.Contains(min, max); };
+    if (int min = 0, max = 0; prefetcher_.Update(hint.iFrom, hint.iTo, table_.Rows(), contains, min, max)) {
+      Prefetch(min, max).detach();
+    }
+    return result;
   }
 
+  // Finds rows by the prefix of their first column for keyboard type-ahead.
+  // The list view works with positions, which are mapped to rows and back through the current view.
+  // Rows that are hidden by a filter are not found.
   BOOL OnFindItem(NMLVFINDITEM& item) noexcept {
-    return FALSE;
+    if (!(item.lvfi.flags & (LVFI_STRING | LVFI_PARTIAL)) || !item.lvfi.psz) {
+      return FALSE;
+    }
+    const auto wrap = (item.lvfi.flags & LVFI_WRAP) != 0;
+    const auto start = view_->Row(item.iStart);
+    const auto previous = item.iStart > 0 ? view_->Row(item.iStart - 1) : -1;
+    const auto row = std::visit([&](const auto& source) noexcept {
+      return index_.Find(item.lvfi.psz, start, previous, wrap, KeyText(source));
+    }, data_);
+    SetWindowLongPtr(hwnd_, DWLP_MSGRESULT, row < 0 ? row : view_->Position(row));
+    return TRUE;
+  }
+
+  // Reads the search text and the filters of all columns. The search comes first, so that it can scan
+  // consecutive rows of an unsorted file.
+  Filter ReadFilter() noexcept {
+    Filter filter;
+    std::wstring text(static_cast<std::size_t>(GetWindowTextLength(search_)), L'\0');
+    text.resize(static_cast<std::size_t>(GetWindowText(search_, text.data(), static_cast<int>(text.size() + 1))));
+    if (Predicate predicate; Predicate::Search(text, predicate)) {
+      filter.Add(std::move(predicate));
+    }
+    for (int col = 0; col < table_.Cols(); col++) {
+      if (Predicate predicate; Predicate::Parse(static_cast<std::size_t>(col), table_.Filter(col), predicate)) {
+        filter.Add(std::move(predicate));
+      }
+    }
+    return filter;
+  }
+
+  // Applies the filters when the search text changes or the user stopped typing into a column filter.
+  // Filtering the previous text is cancelled.
+  BOOL OnFilterChange() noexcept {
+    filter_ = ReadFilter();
+    FilterTable().detach();
+    return TRUE;
+  }
+
+  // Sorts by the clicked column, or reverses the order when the column is already sorted.
+  BOOL OnColumnClick(NMLISTVIEW& view) noexcept {
+    sort_descending_ = view.iSubItem == sort_col_ && !sort_descending_;
+    sort_col_ = view.iSubItem;
+    SortTable().detach();
+    return TRUE;
   }
 
   BOOL OnNotify(LPNMHDR msg) noexcept {
@@ -210,8 +999,13 @@ public:
         return OnCacheHint(*reinterpret_cast<NMLVCACHEHINT*>(msg));
       case LVN_ODFINDITEM:
         return OnFindItem(*reinterpret_cast<NMLVFINDITEM*>(msg));
+      case LVN_COLUMNCLICK:
+        return OnColumnClick(*reinterpret_cast<NMLISTVIEW*>(msg));
       }
     }
+    if (msg->hwndFrom == table_.Header() && msg->code == HDN_FILTERCHANGE) {
+      return OnFilterChange();
+    }
     return FALSE;
   }
 
@@ -363,13 +1157,39 @@ public:
 
 private:
   ice::context io_;
+  ice::pool pool_;
   std::thread thread_;
   Status status_;
   Table table_;
+  HWND search_{ nullptr };
+  std::variant<std::shared_ptr<Store>, std::shared_ptr<Csv>> data_{ std::make_shared<Store>() };
+  std::size_t generation_ = 0;
+  Prefetcher prefetcher_;
+  std::stop_source prefetch_;
+  Index index_;
+  std::shared_ptr<const Permutation> order_{ std::make_shared<const Permutation>() };
+  std::stop_source sort_;
+  int sort_col_ = -1;
+  bool sort_descending_ = false;
+  Filter filter_;
+  std::shared_ptr<const Selection> view_{ std::make_shared<const Selection>(order_) };
+  std::stop_source select_;
+  Totals totals_;
+  std::stop_source total_;
+  std::stop_source load_;
+  std::filesystem::path path_;
 };
 
 int WINAPI wWinMain(HINSTANCE hinstance, HINSTANCE, LPWSTR, int) {
+  std::filesystem::path path;
+  int argc = 0;
+  if (const auto argv = CommandLineToArgvW(GetCommandLine(), &argc)) {
+    if (argc > 1) {
+      path = argv[1];
+    }
+    LocalFree(argv);
+  }
   Application::Initialize();
-  Application application(hinstance);
+  Application application(hinstance, std::move(path));
   return Application::Run();
 }
@@ -7,6 +7,7 @@
 #define IDC_TABLE                       1001
 #define IDC_PREVIEW                     1002
 #define IDC_STATUS                      1003
+#define IDC_SEARCH                      1004
 
 // Next default values for new objects
 //
@@ -14,7 +15,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        103
 #define _APS_NEXT_COMMAND_VALUE         40001
-#define _APS_NEXT_CONTROL_VALUE         1004
+#define _APS_NEXT_CONTROL_VALUE         1005
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif
@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+// Predicts the next list view cache hint from the direction and speed of the previous ones.
+//
+// BOOL OnCacheHint(NMLVCACHEHINT& hint) noexcept {
+//   if (!table_.Swap(hint.iFrom, hint.iTo)) {
+//     ...
+//   }
+//   const auto contains = [this](int min, int max) noexcept { return table_.Contains(min, max); };
+//   if (int min = 0, max = 0; prefetcher_.Update(hint.iFrom, hint.iTo, rows, contains, min, max)) {
+//     Prefetch(min, max).detach();
+//   }
+// }
+//
+class Prefetcher {
+public:
+  Prefetcher() = default;
+
+  void Reset() noexcept {
+    min_ = -1;
+    velocity_ = 0;
+  }
+
+  // Records whether a hint that was not covered by the current rows was served from prefetched rows.
+  // The hit rate is reported by the table/prefetch benchmarks.
+  void Record(bool hit) noexcept {
+    (hit ? hits_ : misses_)++;
+  }
+
+  // Records a hint over rows min to max of a table with the given number of rows.
+  // Returns true and sets next_min and next_max to the rows to prefetch when the next
+  // two hints at the current speed are not covered by rows for which contains returns true.
+  template <typename Contains>
+  bool Update(int min, int max, int rows, Contains&& contains, int& next_min, int& next_max) noexcept {
+    const auto delta = min_ < 0 ? 0 : min - min_;
+    min_ = min;
+
+    // Direction changes and jumps replace the estimate, steady scrolling smooths it.
+    if (delta == 0 || (delta > 0) != (velocity_ > 0) || std::abs(delta) > 4 * std::abs(velocity_) + max - min + 1) {
+      velocity_ = delta;
+    } else {
+      velocity_ = (velocity_ + delta) / 2;
+    }
+    if (velocity_ == 0 || rows <= 0) {
+      return false;
+    }
+
+    const auto clamp = [rows](int row) noexcept { return std::clamp(row, 0, rows - 1); };
+    const auto near_min = clamp(velocity_ > 0 ? min + velocity_ : min + 2 * velocity_);
+    const auto near_max = clamp(velocity_ > 0 ? max + 2 * velocity_ : max + velocity_);
+    if (contains(near_min, near_max)) {
+      return false;
+    }
+
+    // Prefetches two windows or two hints ahead, whichever is more, so that
+    // slow scrolling does not request a new window for every hint.
+    const auto ahead = std::max(2 * std::abs(velocity_), 2 * (max - min + 1));
+    next_min = clamp(velocity_ > 0 ? min + velocity_ : min - ahead);
+    next_max = clamp(velocity_ > 0 ? max + ahead : max + velocity_);
+    return true;
+  }
+
+  std::uint64_t Hits() const noexcept {
+    return hits_;
+  }
+
+  std::uint64_t Misses() const noexcept {
+    return misses_;
+  }
+
+private:
+  int min_ = -1;
+  int velocity_ = 0;
+  std::uint64_t hits_ = 0;
+  std::uint64_t misses_ = 0;
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include "filter.hpp"
+#include "text.hpp"
+#include <bit>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+// Finds ASCII text in bytes, ignoring the case of ASCII letters.
+//
+// Candidates are found 16 positions at a time by comparing the first and the last character
+// of the pattern, and are then compared in full. ASCII never occurs inside the multi-byte
+// sequences of UTF-8, so UTF-8 and Windows-1252 text can be searched without decoding it.
+//
+class Needle {
+public:
+  constexpr static auto npos = std::string_view::npos;
+
+  Needle() = default;
+
+  // Creates a needle from text that does not contain any of the reserved characters.
+  // Returns false if the text is empty or contains characters that are not ASCII or reserved.
+  static bool Create(std::wstring_view text, std::string_view reserved, Needle& needle) noexcept {
+    if (text.empty()) {
+      return false;
+    }
+    std::string pattern;
+    pattern.reserve(text.size());
+    for (const auto c : text) {
+      if (c >= 0x80 || reserved.find(static_cast<char>(c)) != std::string_view::npos) {
+        return false;
+      }
+      pattern.push_back(Fold(static_cast<char>(c)));
+    }
+    needle.pattern_ = std::move(pattern);
+    return true;
+  }
+
+  std::size_t Size() const noexcept {
+    return pattern_.size();
+  }
+
+  // Returns the position of the first match at or after pos, or npos.
+  std::size_t Find(std::string_view text, std::size_t pos = 0) const noexcept {
+    const auto size = pattern_.size();
+    if (size == 0 || text.size() < size) {
+      return size == 0 && pos <= text.size() ? pos : npos;
+    }
+    const auto last = text.size() - size;
+#ifdef CARTA_SSE2
+    // Letters are compared with the case bit set, which only maps the upper case letter to the pattern.
+    const auto first_case = _mm_set1_epi8(Letter(pattern_.front()) ? 0x20 : 0);
+    const auto last_case = _mm_set1_epi8(Letter(pattern_.back()) ? 0x20 : 0);
+    const auto first = _mm_set1_epi8(pattern_.front());
+    const auto back = _mm_set1_epi8(pattern_.back());
+    for (; pos + 16 <= last + 1; pos += 16) {
+      const auto lhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos));
+      const auto rhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos + size - 1));
+      const auto lhs_eq = _mm_cmpeq_epi8(_mm_or_si128(lhs, first_case), first);
+      const auto rhs_eq = _mm_cmpeq_epi8(_mm_or_si128(rhs, last_case), back);
+      for (auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(lhs_eq, rhs_eq))); mask; mask &= mask - 1) {
+        const auto i = pos + static_cast<std::size_t>(std::countr_zero(mask));
+        if (Equal(text.data() + i)) {
+          return i;
+        }
+      }
+    }
+#endif
+    for (; pos <= last; pos++) {
+      if (Fold(text[pos]) == pattern_.front() && Equal(text.data() + pos)) {
+        return pos;
+      }
+    }
+    return npos;
+  }
+
+private:
+  static bool Letter(char c) noexcept {
+    return c >= 'a' && c <= 'z';
+  }
+
+  static char Fold(char c) noexcept {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c;
+  }
+
+  bool Equal(const char* text) const noexcept {
+    for (std::size_t i = 0; i < pattern_.size(); i++) {
+      if (Fold(text[i]) != pattern_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::string pattern_;
+};
+
+// Creates a kernel that keeps rows whose bytes contain a needle.
+// The bytes of consecutive rows must follow each other in memory, like the lines of a file,
+// so that a block of consecutive rows is searched in a single pass.
+inline Selector::Kernel SearchRows(Needle needle, std::function<std::string_view(std::size_t row)> row) noexcept {
+  return [needle = std::move(needle), row = std::move(row)](std::uint32_t* rows, std::uint32_t* positions, std::size_t size, bool contiguous) noexcept {
+    std::size_t count = 0;
+    if (!contiguous) {
+      for (std::size_t i = 0; i < size; i++) {
+        if (needle.Find(row(rows[i])) != Needle::npos) {
+          rows[count] = rows[i];
+          positions[count] = positions[i];
+          count++;
+        }
+      }
+      return count;
+    }
+    // A match never spans a line break, so it belongs to the last row that starts before it.
+    const auto first = row(rows[0]);
+    const auto back = row(rows[size - 1]);
+    const std::string_view block{ first.data(), static_cast<std::size_t>(back.data() + back.size() - first.data()) };
+    std::size_t i = 0;
+    for (auto pos = needle.Find(block); pos != Needle::npos && i < size; pos = needle.Find(block, pos)) {
+      while (i + 1 < size && static_cast<std::size_t>(row(rows[i + 1]).data() - first.data()) <= pos) {
+        i++;
+      }
+      rows[count] = rows[i];
+      positions[count] = positions[i];
+      count++;
+      if (++i == size) {
+        break;
+      }
+      pos = static_cast<std::size_t>(row(rows[i]).data() - first.data());
+    }
+    return count;
+  };
+}
@@ -0,0 +1,357 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <functional>
+#include <limits>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// Order in which the rows of a table are shown.
+class Permutation {
+public:
+  Permutation() = default;
+
+  Permutation(std::vector<std::uint32_t> rows, std::vector<std::uint32_t> positions) noexcept :
+    rows_(std::move(rows)), positions_(std::move(positions)) {
+  }
+
+  // Returns the row shown at a position. Rows that were added after sorting are shown in order at the end.
+  int Row(int position) const noexcept {
+    return position >= 0 && static_cast<std::size_t>(position) < rows_.size() ? static_cast<int>(rows_[position]) : position;
+  }
+
+  // Returns the position at which a row is shown.
+  int Position(int row) const noexcept {
+    return row >= 0 && static_cast<std::size_t>(row) < positions_.size() ? static_cast<int>(positions_[row]) : row;
+  }
+
+  std::size_t Size() const noexcept {
+    return rows_.size();
+  }
+
+private:
+  std::vector<std::uint32_t> rows_;
+  std::vector<std::uint32_t> positions_;
+};
+
+// Sorts rows by a key into a permutation without moving the rows.
+//
+// Integer keys are sorted with a least significant digit radix sort and text keys with a merge
+// sort. Both are stable, so rows with equal keys stay in order. The work is split into steps of
+// independent jobs, so that callers can run the jobs of a step in parallel and report progress
+// or cancel between steps.
+//
+// Sorter sorter;
+// sorter.Integers(rows, threads, descending, key);
+// do {
+//   std::vector<ice::task<void>> jobs;
+//   for (std::size_t job = 0; job < sorter.Jobs(); job++) {
+//     jobs.push_back(Run(sorter, job));
+//   }
+//   co_await ice::when_all(jobs);
+//   state.Set(fmt::format(L"Sorting... {}%", sorter.Progress()));
+// } while (sorter.Next());
+// auto permutation = sorter.Result();
+//
+class Sorter {
+public:
+  Sorter() = default;
+
+  Sorter(Sorter&& other) = delete;
+  Sorter(const Sorter& other) = delete;
+  Sorter& operator=(Sorter&& other) = delete;
+  Sorter& operator=(const Sorter& other) = delete;
+
+  ~Sorter() = default;
+
+  // Maps a signed integer to an unsigned integer with the same order.
+  static std::uint64_t Key(std::int64_t value) noexcept {
+    return static_cast<std::uint64_t>(value) ^ (std::uint64_t(1) << 63);
+  }
+
+  // Maps a double to an unsigned integer with the same order.
+  static std::uint64_t Key(double value) noexcept {
+    const auto bits = std::bit_cast<std::uint64_t>(value);
+    return bits >> 63 ? ~bits : bits | (std::uint64_t(1) << 63);
+  }
+
+  // Prepares a radix sort of rows 0 to rows by key(row) in up to jobs parallel jobs per step.
+  void Integers(std::size_t rows, std::size_t jobs, bool descending, std::function<std::uint64_t(std::size_t)> key) noexcept {
+    Start(rows, jobs, descending);
+    integer_ = std::move(key);
+    keys_.resize(rows);
+    limits_.assign(jobs_, { std::numeric_limits<std::uint64_t>::max(), 0 });
+    total_ = 2 + 2 * 8;
+  }
+
+  // Prepares a merge sort of rows 0 to rows by key(row) in up to jobs parallel jobs per step.
+  // The text must stay valid until the sort is complete.
+  void Strings(std::size_t rows, std::size_t jobs, bool descending, std::function<std::string_view(std::size_t)> key) noexcept {
+    Start(rows, jobs, descending);
+    string_ = std::move(key);
+    texts_.resize(rows);
+    total_ = 3 + static_cast<std::size_t>(std::bit_width(jobs_ - 1));
+  }
+
+  // Returns the number of jobs of the current step.
+  std::size_t Jobs() const noexcept {
+    return step_ == Step::Done ? 0 : jobs_;
+  }
+
+  // Runs a job of the current step. Different jobs may run concurrently.
+  void Run(std::size_t job) noexcept {
+    assert(job < jobs_);
+    const auto size = (rows_.size() + jobs_ - 1) / jobs_;
+    const auto begin = std::min(rows_.size(), job * size);
+    const auto end = std::min(rows_.size(), begin + size);
+    switch (step_) {
+    case Step::Load:
+      Load(job, begin, end);
+      break;
+    case Step::Count:
+      Count(job, begin, end);
+      break;
+    case Step::Scatter:
+      Scatter(job, begin, end);
+      break;
+    case Step::Sort:
+      std::stable_sort(rows_.begin() + begin, rows_.begin() + end, Less());
+      break;
+    case Step::Merge:
+      Merge(begin, end);
+      break;
+    case Step::Invert:
+      for (auto i = begin; i < end; i++) {
+        positions_[rows_[i]] = static_cast<std::uint32_t>(i);
+      }
+      break;
+    case Step::Done:
+      break;
+    }
+  }
+
+  // Completes the current step after all of its jobs ran. Returns false when the sort is complete.
+  bool Next() noexcept {
+    done_++;
+    switch (step_) {
+    case Step::Load:
+      if (integer_) {
+        Prepare();
+      } else {
+        step_ = Step::Sort;
+      }
+      break;
+    case Step::Count:
+      Distribute();
+      break;
+    case Step::Scatter:
+      std::swap(keys_, keys_swap_);
+      std::swap(rows_, rows_swap_);
+      pass_++;
+      step_ = pass_ < passes_ ? Step::Count : Step::Invert;
+      break;
+    case Step::Sort:
+      width_ = (rows_.size() + jobs_ - 1) / jobs_;
+      rows_swap_.resize(rows_.size());
+      step_ = width_ < rows_.size() ? Step::Merge : Step::Invert;
+      break;
+    case Step::Merge:
+      std::swap(rows_, rows_swap_);
+      width_ *= 2;
+      step_ = width_ < rows_.size() ? Step::Merge : Step::Invert;
+      break;
+    case Step::Invert:
+      step_ = Step::Done;
+      break;
+    case Step::Done:
+      break;
+    }
+    return step_ != Step::Done;
+  }
+
+  // Returns the progress in percent.
+  int Progress() const noexcept {
+    return step_ == Step::Done ? 100 : static_cast<int>(std::min(done_ * 100 / total_, std::size_t(99)));
+  }
+
+  // Returns the permutation once the sort is complete.
+  Permutation Result() noexcept {
+    assert(step_ == Step::Done);
+    return { std::move(rows_), std::move(positions_) };
+  }
+
+private:
+  enum class Step { Load, Count, Scatter, Sort, Merge, Invert, Done };
+
+  void Start(std::size_t rows, std::size_t jobs, bool descending) noexcept {
+    assert(rows <= std::numeric_limits<std::uint32_t>::max());
+    jobs_ = std::max(std::size_t(1), std::min(jobs, rows / 4096 + 1));
+    descending_ = descending;
+    step_ = rows ? Step::Load : Step::Done;
+    done_ = 0;
+    pass_ = 0;
+    passes_ = 0;
+    rows_.resize(rows);
+    positions_.resize(rows);
+  }
+
+  void Load(std::size_t job, std::size_t begin, std::size_t end) noexcept {
+    for (auto i = begin; i < end; i++) {
+      rows_[i] = static_cast<std::uint32_t>(i);
+    }
+    if (integer_) {
+      auto [min, max] = limits_[job];
+      for (auto i = begin; i < end; i++) {
+        const auto key = integer_(i);
+        keys_[i] = key;
+        min = std::min(min, key);
+        max = std::max(max, key);
+      }
+      limits_[job] = { min, max };
+    } else {
+      for (auto i = begin; i < end; i++) {
+        texts_[i] = string_(i);
+      }
+    }
+  }
+
+  // Counts only the bytes in which the keys differ, after subtracting the smallest key.
+  void Prepare() noexcept {
+    min_ = std::numeric_limits<std::uint64_t>::max();
+    max_ = 0;
+    for (const auto& [min, max] : limits_) {
+      min_ = std::min(min_, min);
+      max_ = std::max(max_, max);
+    }
+    passes_ = min_ < max_ ? static_cast<std::size_t>(std::bit_width(max_ - min_) + 7) / 8 : 0;
+    total_ = 2 + 2 * passes_;
+    counts_.resize(jobs_);
+    keys_swap_.resize(keys_.size());
+    rows_swap_.resize(rows_.size());
+    step_ = passes_ ? Step::Count : Step::Invert;
+  }
+
+  void Count(std::size_t job, std::size_t begin, std::size_t end) noexcept {
+    auto& counts = counts_[job];
+    counts.fill(0);
+    const auto shift = pass_ * 8;
+    if (pass_ == 0) {
+      for (auto i = begin; i < end; i++) {
+        keys_[i] = descending_ ? max_ - keys_[i] : keys_[i] - min_;
+      }
+    }
+    for (auto i = begin; i < end; i++) {
+      counts[(keys_[i] >> shift) & 0xFF]++;
+    }
+  }
+
+  // Turns the counts of every job into the positions to which its rows are scattered.
+  // Skips the pass when all keys have the same byte.
+  void Distribute() noexcept {
+    std::size_t offset = 0;
+    for (std::size_t digit = 0; digit < 256; digit++) {
+      std::size_t count = 0;
+      for (auto& counts : counts_) {
+        const auto next = counts[digit];
+        counts[digit] = offset + count;
+        count += next;
+      }
+      if (count == rows_.size()) {
+        pass_++;
+        step_ = pass_ < passes_ ? Step::Count : Step::Invert;
+        done_++;
+        return;
+      }
+      offset += count;
+    }
+    step_ = Step::Scatter;
+  }
+
+  void Scatter(std::size_t job, std::size_t begin, std::size_t end) noexcept {
+    auto& offsets = counts_[job];
+    const auto shift = pass_ * 8;
+    for (auto i = begin; i < end; i++) {
+      const auto key = keys_[i];
+      const auto pos = offsets[(key >> shift) & 0xFF]++;
+      keys_swap_[pos] = key;
+      rows_swap_[pos] = rows_[i];
+    }
+  }
+
+  // Orders rows by text.
+  struct Order {
+    const Sorter* sorter;
+
+    bool operator()(std::uint32_t lhs, std::uint32_t rhs) const noexcept {
+      const auto& texts = sorter->texts_;
+      return sorter->descending_ ? texts[rhs] < texts[lhs] : texts[lhs] < texts[rhs];
+    }
+  };
+
+  Order Less() const noexcept {
+    return { this };
+  }
+
+  // Returns how many of the first count rows of the merge of a and b come from a.
+  template <typename Iterator>
+  std::size_t Split(Iterator a, std::size_t a_size, Iterator b, std::size_t b_size, std::size_t count) const noexcept {
+    const auto less = Less();
+    auto lo = count > b_size ? count - b_size : 0;
+    auto hi = std::min(count, a_size);
+    while (lo < hi) {
+      const auto i = (lo + hi) / 2;
+      const auto j = count - i;
+      if (j > 0 && i < a_size && !less(b[j - 1], a[i])) {
+        lo = i + 1;
+      } else {
+        hi = i;
+      }
+    }
+    return lo;
+  }
+
+  // Merges the part of every pair of sorted runs that ends up at positions begin to end.
+  void Merge(std::size_t begin, std::size_t end) noexcept {
+    const auto size = rows_.size();
+    for (auto pair = begin / (2 * width_) * (2 * width_); pair < end; pair += 2 * width_) {
+      const auto a = rows_.begin() + pair;
+      const auto a_size = std::min(width_, size - pair);
+      const auto b = a + a_size;
+      const auto b_size = std::min(width_, size - pair - a_size);
+      const auto first = std::max(begin, pair) - pair;
+      const auto last = std::min(end, pair + a_size + b_size) - pair;
+      const auto i0 = Split(a, a_size, b, b_size, first);
+      const auto i1 = Split(a, a_size, b, b_size, last);
+      std::merge(a + i0, a + i1, b + (first - i0), b + (last - i1), rows_swap_.begin() + pair + first, Less());
+    }
+  }
+
+  Step step_ = Step::Done;
+  std::size_t jobs_ = 1;
+  bool descending_ = false;
+  std::size_t done_ = 0;
+  std::size_t total_ = 1;
+
+  std::vector<std::uint32_t> rows_;
+  std::vector<std::uint32_t> rows_swap_;
+  std::vector<std::uint32_t> positions_;
+
+  std::function<std::uint64_t(std::size_t)> integer_;
+  std::vector<std::uint64_t> keys_;
+  std::vector<std::uint64_t> keys_swap_;
+  std::vector<std::pair<std::uint64_t, std::uint64_t>> limits_;
+  std::vector<std::array<std::size_t, 256>> counts_;
+  std::uint64_t min_ = 0;
+  std::uint64_t max_ = 0;
+  std::size_t pass_ = 0;
+  std::size_t passes_ = 0;
+
+  std::function<std::string_view(std::size_t)> string_;
+  std::vector<std::string_view> texts_;
+  std::size_t width_ = 0;
+};
@@ -1,9 +1,11 @@
 #pragma once
 #include <windows.h>
+#include <iterator>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <cassert>
 
 class Status {
 public:
@@ -21,6 +23,11 @@ public:
     std::mutex mutex;
     std::list<std::wstring> stack;
 
+    // Returns true on the thread that owns the status bar.
+    bool Current() const noexcept {
+      return GetWindowThreadProcessId(hwnd, nullptr) == GetCurrentThreadId();
+    }
+
     void Update() noexcept {
       for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
         if (const auto pos = it->find_first_not_of(L" \f\n\r\t\v"); pos != std::wstring::npos) {
@@ -32,9 +39,12 @@ public:
     }
   };
 
+  // Text that is shown while the state exists. States must be created and destroyed on the UI thread, which
+  // would otherwise block in SendMessage while holding the mutex that the UI thread waits for.
   class State {
   public:
     State(std::shared_ptr<Info> info, std::wstring text) noexcept : info_(info) {
+      assert(info_->Current());
       std::lock_guard lock(info_->mutex);
       it_ = info_->stack.insert(info_->stack.end(), std::move(text));
       info_->Update();
@@ -46,6 +56,7 @@ public:
     State& operator=(const State& other) = delete;
 
     ~State() {
+      assert(info_->Current());
       std::lock_guard lock(info_->mutex);
       info_->stack.erase(it_);
       info_->Update();
@@ -70,7 +81,10 @@ public:
 
   Status() = default;
 
+  // Splits the status bar into the text of the current state and a summary that fills the rest.
   Status(HWND hwnd) noexcept : info_(std::make_shared<Info>(hwnd)) {
+    const int parts[] = { MulDiv(240, static_cast<int>(GetDpiForWindow(hwnd)), 96), -1 };
+    SendMessage(hwnd, SB_SETPARTS, std::size(parts), reinterpret_cast<LPARAM>(parts));
     info_->Update();
   }
 
@@ -78,6 +92,12 @@ public:
     return { info_, std::move(text) };
   }
 
+  // Shows text in the summary part, which does not change with the states.
+  void Summary(const std::wstring& text) noexcept {
+    std::lock_guard lock(info_->mutex);
+    SendMessage(info_->hwnd, SB_SETTEXT, 1, reinterpret_cast<LPARAM>(text.data()));
+  }
+
 private:
   std::shared_ptr<Info> info_;
 };
@@ -0,0 +1,316 @@
+#pragma once
+#include "format.hpp"
+#include <fmt/format.h>
+#if __has_include(<fmt/xchar.h>)
+#include <fmt/xchar.h>
+#endif
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// Allocator for column data that starts every vector on its own cache line.
+template <typename T, std::size_t Alignment = 64>
+class AlignedAllocator {
+public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  constexpr AlignedAllocator() noexcept = default;
+
+  template <typename U>
+  constexpr AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {
+  }
+
+  T* allocate(std::size_t size) {
+    return static_cast<T*>(::operator new(size * sizeof(T), std::align_val_t{ Alignment }));
+  }
+
+  void deallocate(T* data, std::size_t) noexcept {
+    ::operator delete(data, std::align_val_t{ Alignment });
+  }
+
+  friend constexpr bool operator==(const AlignedAllocator&, const AlignedAllocator&) noexcept {
+    return true;
+  }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+enum class ColumnType : unsigned char {
+  Int64,      // std::int64_t
+  Double,     // double
+  Timestamp,  // std::int64_t microseconds since 1970-01-01 00:00:00 UTC
+  String,     // std::uint32_t code into a dictionary of UTF-8 strings
+};
+
+// Unique UTF-8 strings of a column.
+class Dictionary {
+public:
+  Dictionary() = default;
+
+  Dictionary(Dictionary&& other) = default;
+  Dictionary(const Dictionary& other) = delete;
+  Dictionary& operator=(Dictionary&& other) = default;
+  Dictionary& operator=(const Dictionary& other) = delete;
+
+  ~Dictionary() = default;
+
+  // Returns the code of the value and adds it if it is new.
+  std::uint32_t Insert(std::string_view value) noexcept {
+    if (const auto it = codes_.find(value); it != codes_.end()) {
+      return it->second;
+    }
+    const auto code = static_cast<std::uint32_t>(values_.size());
+    codes_.emplace(values_.emplace_back(value), code);
+    return code;
+  }
+
+  std::string_view Get(std::uint32_t code) const noexcept {
+    assert(code < values_.size());
+    return values_[code];
+  }
+
+  std::size_t Size() const noexcept {
+    return values_.size();
+  }
+
+  // Returns the position of every code when the values are sorted.
+  std::vector<std::uint32_t> Ranks() const noexcept {
+    std::vector<std::uint32_t> codes(values_.size());
+    for (std::uint32_t code = 0; code < codes.size(); code++) {
+      codes[code] = code;
+    }
+    std::sort(codes.begin(), codes.end(), [this](std::uint32_t lhs, std::uint32_t rhs) noexcept {
+      return values_[lhs] < values_[rhs];
+    });
+    std::vector<std::uint32_t> ranks(codes.size());
+    for (std::uint32_t rank = 0; rank < codes.size(); rank++) {
+      ranks[codes[rank]] = rank;
+    }
+    return ranks;
+  }
+
+private:
+  // Elements of a deque are never moved, so the keys stay valid.
+  std::deque<std::string> values_;
+  std::unordered_map<std::string_view, std::uint32_t> codes_;
+};
+
+// Typed values of a single column in contiguous memory.
+class Column {
+public:
+  // Double values are shown with precision digits after the decimal point
+  // or in the shortest form that round trips when precision is negative.
+  Column(std::wstring name, ColumnType type, int precision = -1) noexcept :
+    name_(std::move(name)), type_(type), precision_(precision) {
+  }
+
+  Column(Column&& other) = default;
+  Column(const Column& other) = delete;
+  Column& operator=(Column&& other) = default;
+  Column& operator=(const Column& other) = delete;
+
+  ~Column() = default;
+
+  const std::wstring& Name() const noexcept {
+    return name_;
+  }
+
+  ColumnType Type() const noexcept {
+    return type_;
+  }
+
+  std::size_t Size() const noexcept {
+    switch (type_) {
+    case ColumnType::Int64:
+    case ColumnType::Timestamp:
+      return integers_.size();
+    case ColumnType::Double:
+      return doubles_.size();
+    case ColumnType::String:
+      return codes_.size();
+    }
+    return 0;
+  }
+
+  void Reserve(std::size_t size) noexcept {
+    switch (type_) {
+    case ColumnType::Int64:
+    case ColumnType::Timestamp:
+      integers_.reserve(size);
+      break;
+    case ColumnType::Double:
+      doubles_.reserve(size);
+      break;
+    case ColumnType::String:
+      codes_.reserve(size);
+      break;
+    }
+  }
+
+  // Appends a value to an Int64 or Timestamp column.
+  void Append(std::int64_t value) noexcept {
+    assert(type_ == ColumnType::Int64 || type_ == ColumnType::Timestamp);
+    integers_.push_back(value);
+  }
+
+  // Appends a value to a Double column.
+  void Append(double value) noexcept {
+    assert(type_ == ColumnType::Double);
+    doubles_.push_back(value);
+  }
+
+  // Appends a value to a String column.
+  void Append(std::string_view value) noexcept {
+    assert(type_ == ColumnType::String);
+    codes_.push_back(dictionary_.Insert(value));
+  }
+
+  std::span<const std::int64_t> Integers() const noexcept {
+    return integers_;
+  }
+
+  std::span<const double> Doubles() const noexcept {
+    return doubles_;
+  }
+
+  std::span<const std::uint32_t> Codes() const noexcept {
+    return codes_;
+  }
+
+  const ::Dictionary& Dictionary() const noexcept {
+    return dictionary_;
+  }
+
+  // Appends the text of a value.
+  template <typename Buffer>
+  void Format(Buffer& text, std::size_t row) const noexcept {
+    switch (type_) {
+    case ColumnType::Int64:
+      AppendInteger(text, integers_[row]);
+      break;
+    case ColumnType::Double:
+      FormatDouble(text, doubles_[row]);
+      break;
+    case ColumnType::Timestamp:
+      AppendTimestamp(text, integers_[row]);
+      break;
+    case ColumnType::String:
+      AppendUtf16(text, dictionary_.Get(codes_[row]));
+      break;
+    }
+  }
+
+private:
+  template <typename Buffer>
+  void FormatDouble(Buffer& text, double value) const noexcept {
+    switch (precision_) {
+    case 0:
+      return AppendDecimal<0>(text, value);
+    case 1:
+      return AppendDecimal<1>(text, value);
+    case 2:
+      return AppendDecimal<2>(text, value);
+    case 3:
+      return AppendDecimal<3>(text, value);
+    case 4:
+      return AppendDecimal<4>(text, value);
+    case 5:
+      return AppendDecimal<5>(text, value);
+    case 6:
+      return AppendDecimal<6>(text, value);
+    }
+    fmt::format_to(std::back_inserter(text), L"{}", value);
+  }
+
+  std::wstring name_;
+  ColumnType type_;
+  int precision_ = -1;
+  AlignedVector<std::int64_t> integers_;
+  AlignedVector<double> doubles_;
+  AlignedVector<std::uint32_t> codes_;
+  ::Dictionary dictionary_;
+};
+
+// Columnar in-memory table.
+// Values are stored by type and only converted to text for the rows a Table displays.
+//
+// BOOL OnCacheHint(NMLVCACHEHINT& hint) noexcept {
+//   return table_.Set(hint.iFrom, hint.iTo, [this](auto& text, int row, int col) noexcept {
+//     store_.Format(text, row, col);
+//   });
+// }
+//
+class Store {
+public:
+  Store() = default;
+
+  Store(Store&& other) = default;
+  Store(const Store& other) = delete;
+  Store& operator=(Store&& other) = default;
+  Store& operator=(const Store& other) = delete;
+
+  ~Store() = default;
+
+  // Adds an empty column. Rows are added by appending a value to every column.
+  Column& AddColumn(std::wstring name, ColumnType type, int precision = -1) noexcept {
+    return columns_.emplace_back(std::move(name), type, precision);
+  }
+
+  std::size_t Cols() const noexcept {
+    return columns_.size();
+  }
+
+  const std::wstring& Name(std::size_t col) const noexcept {
+    assert(col < columns_.size());
+    return columns_[col].Name();
+  }
+
+  // Returns the number of rows that have a value in every column.
+  std::size_t Rows() const noexcept {
+    if (columns_.empty()) {
+      return 0;
+    }
+    auto rows = columns_.front().Size();
+    for (const auto& column : columns_) {
+      rows = std::min(rows, column.Size());
+    }
+    return rows;
+  }
+
+  Column& operator[](std::size_t col) noexcept {
+    assert(col < columns_.size());
+    return columns_[col];
+  }
+
+  const Column& operator[](std::size_t col) const noexcept {
+    assert(col < columns_.size());
+    return columns_[col];
+  }
+
+  template <typename Buffer>
+  void Format(Buffer& text, int row, int col) const noexcept {
+    assert(row >= 0 && static_cast<std::size_t>(row) < Rows());
+    assert(col >= 0 && static_cast<std::size_t>(col) < columns_.size());
+    columns_[static_cast<std::size_t>(col)].Format(text, static_cast<std::size_t>(row));
+  }
+
+private:
+  // References returned by AddColumn stay valid when more columns are added.
+  std::deque<Column> columns_;
+};
@@ -1,8 +1,12 @@
 #pragma once
+#include "cells.hpp"
 #include <windows.h>
-#include <fmt/format.h>
 #include <algorithm>
+#include <iterator>
+#include <string>
+#include <utility>
 #include <cassert>
+#include <cstring>
 
 #include <commctrl.h>
 #pragma comment(lib, "comctl32.lib")
@@ -14,12 +18,14 @@
 //
 // BOOL OnCacheHint(NMLVCACHEHINT& hint) noexcept {
 //   return table_.Set(hint.iFrom, hint.iTo, [this](auto& text, int row, int col) noexcept {
-//     fmt::format_to(text, L"{:09}:{:02}", row, col);
+//     store_.Format(text, row, col);
 //   });
 // }
 //
 // BOOL OnFindItem(NMLVFINDITEM& item) noexcept {
-//   return FALSE;
+//   const auto row = index_.Find(item.lvfi.psz, item.iStart, item.iStart - 1, wrap, text);
+//   SetWindowLongPtr(hwnd_, DWLP_MSGRESULT, row);
+//   return TRUE;
 // }
 //
 // BOOL OnNotify(LPNMHDR msg) noexcept {
@@ -31,14 +37,22 @@
 //       return OnCacheHint(*reinterpret_cast<NMLVCACHEHINT*>(msg));
 //     case LVN_ODFINDITEM:
 //       return OnFindItem(*reinterpret_cast<NMLVFINDITEM*>(msg));
+//     case LVN_COLUMNCLICK:
+//       return OnColumnClick(*reinterpret_cast<NMLISTVIEW*>(msg));
 //     }
 //   }
+//   if (msg->hwndFrom == table_.Header() && msg->code == HDN_FILTERCHANGE) {
+//     return OnFilterChange();
+//   }
 //   return FALSE;
 // }
 //
 
 class Table {
 public:
+  // Maximum number of rows supported by Resize.
+  constexpr static std::size_t capacity = 100'000'000;
+
   Table() = default;
 
   Table(HWND hwnd) noexcept : hwnd_(hwnd) {
@@ -46,15 +60,20 @@ public:
     ListView_SetExtendedListViewStyleEx(hwnd_, LVS_EX_FULLROWSELECT, LVS_EX_FULLROWSELECT);
     ListView_SetExtendedListViewStyleEx(hwnd_, LVS_EX_GRIDLINES, LVS_EX_GRIDLINES);
     ListView_DeleteAllItems(hwnd_);
+    const auto header = Header();
+    SetWindowLongPtr(header, GWL_STYLE, GetWindowLongPtr(header, GWL_STYLE) | HDS_FILTERBAR);
+    Header_SetFilterChangeTimeout(header, 250);
+    SetWindowPos(hwnd_, nullptr, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED);
   }
 
   void Reset() noexcept {
-    max_ = 0;
-    min_ = 0;
-    cols_ = 0;
-    data_ = {};
-    text_ = fmt::wmemory_buffer{};
+    cells_.Reset();
+    next_.Reset();
+    rows_ = 0;
     ListView_DeleteAllItems(hwnd_);
+    while (cols_ > 0) {
+      ListView_DeleteColumn(hwnd_, --cols_);
+    }
   }
 
   BOOL AddColumn(LPCWSTR text, int width = 0, int format = LVCFMT_LEFT) noexcept {
@@ -70,51 +89,119 @@ public:
   }
 
   BOOL Resize(std::size_t rows) noexcept {
-    assert(rows <= 100'000'000);
+    assert(rows <= capacity);
+    rows_ = static_cast<int>(rows);
     return ListView_SetItemCountEx(hwnd_, static_cast<WPARAM>(rows), LVSICF_NOSCROLL) ? TRUE : FALSE;
   }
 
   template <typename Callback>
   BOOL Set(int min, int max, Callback callback) noexcept {
-    if (min < 0 || max < min) {
-      return FALSE;
+    return cells_.Set(min, max, cols_, std::move(callback)) ? TRUE : FALSE;
+  }
+
+  // Drops all formatted rows and formats the visible rows again, for example after the rows were reordered.
+  template <typename Callback>
+  BOOL Reload(Callback callback) noexcept {
+    cells_.Reset();
+    next_.Reset();
+    auto result = TRUE;
+    if (rows_ > 0) {
+      const auto min = std::clamp(ListView_GetTopIndex(hwnd_), 0, rows_ - 1);
+      const auto max = std::clamp(min + ListView_GetCountPerPage(hwnd_), min, rows_ - 1);
+      result = Set(min, max, std::move(callback));
     }
-    text_.clear();
-    data_.resize(static_cast<std::size_t>((max - min + 1) * cols_) + 1);
-    std::size_t pos = 0;
-    for (int row = min; row <= max; row++) {
-      for (int col = 0; col < cols_; col++) {
-        data_[pos++] = text_.size();
-        callback(text_, row, col);
-        text_.push_back(L'\0');
+    InvalidateRect(hwnd_, nullptr, FALSE);
+    return result;
+  }
+
+  // Returns the header, which sends HDN_FILTERCHANGE when the user stops typing into the filter of a column.
+  HWND Header() const noexcept {
+    return ListView_GetHeader(hwnd_);
+  }
+
+  // Returns the text of the filter of a column.
+  std::wstring Filter(int col) const noexcept {
+    wchar_t text[256] = {};
+    HD_TEXTFILTER filter = { text, static_cast<INT>(std::size(text)) };
+    HDITEM item = {};
+    item.mask = HDI_FILTER;
+    item.type = HDFT_ISSTRING;
+    item.pvFilter = &filter;
+    if (!Header_GetItem(Header(), col, &item)) {
+      return {};
+    }
+    return text;
+  }
+
+  // Shows the sort direction in the header of a column and removes it from the others.
+  void Sort(int col, bool descending) noexcept {
+    const auto header = Header();
+    for (int i = 0; i < cols_; i++) {
+      HDITEM item = {};
+      item.mask = HDI_FORMAT;
+      if (!Header_GetItem(header, i, &item)) {
+        continue;
+      }
+      item.fmt &= ~(HDF_SORTUP | HDF_SORTDOWN);
+      if (i == col) {
+        item.fmt |= descending ? HDF_SORTDOWN : HDF_SORTUP;
       }
+      Header_SetItem(header, i, &item);
     }
-    data_[pos++] = text_.size();
-    min_ = min;
-    max_ = max;
-    return TRUE;
+  }
+
+  // Returns true if rows min to max are formatted and makes prefetched rows current if needed.
+  bool Swap(int min, int max) noexcept {
+    if (cells_.Contains(min, max)) {
+      return true;
+    }
+    if (!next_.Contains(min, max)) {
+      return false;
+    }
+    std::swap(cells_, next_);
+    return true;
+  }
+
+  // Returns true if rows min to max are formatted or prefetched.
+  bool Contains(int min, int max) const noexcept {
+    return cells_.Contains(min, max) || next_.Contains(min, max);
+  }
+
+  // Stores rows that were formatted ahead of the next cache hint.
+  // The cells must have been formatted with Cols() columns.
+  void Prefetch(Cells cells) noexcept {
+    next_ = std::move(cells);
+  }
+
+  int Cols() const noexcept {
+    return cols_;
+  }
+
+  int Rows() const noexcept {
+    return rows_;
   }
 
   BOOL Get(LVITEM& item) noexcept {
     assert(item.iSubItem >= 0);
     assert(item.iSubItem < cols_);
-    if (!(item.mask & LVIF_TEXT) || item.iItem < min_ || item.iItem > max_) {
+    if (!(item.mask & LVIF_TEXT) || item.cchTextMax < 1) {
+      return FALSE;
+    }
+    const auto& cells = cells_.Contains(item.iItem) ? cells_ : next_;
+    if (!cells.Contains(item.iItem)) {
       return FALSE;
     }
-    const auto pos = static_cast<std::size_t>((item.iItem - min_) * cols_ + item.iSubItem);
-    const auto beg = data_[pos];
-    const auto end = data_[pos + 1];
-    const auto max = std::min(static_cast<int>(end - beg), item.cchTextMax) - 1;
-    std::memcpy(item.pszText, text_.data() + beg, static_cast<std::size_t>(max) * sizeof(wchar_t));
-    item.pszText[max] = L'\0';
+    const auto text = cells.Get(item.iItem, item.iSubItem);
+    const auto size = std::min(text.size(), static_cast<std::size_t>(item.cchTextMax - 1));
+    std::memcpy(item.pszText, text.data(), size * sizeof(wchar_t));
+    item.pszText[size] = L'\0';
     return TRUE;
   }
 
 private:
-  int min_ = 0;
-  int max_ = 0;
   int cols_ = 0;
-  fmt::wmemory_buffer text_;
-  std::vector<std::size_t> data_;
+  int rows_ = 0;
+  Cells cells_;
+  Cells next_;
   HWND hwnd_{ nullptr };
 };
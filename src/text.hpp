@@ -0,0 +1,172 @@
+#pragma once
+#include <bit>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define CARTA_SSE2 1
+#endif
+
+namespace detail {
+
+// Resizes text by size characters and returns a pointer to the first new character.
+template <typename Buffer>
+inline wchar_t* Grow(Buffer& text, std::size_t size) noexcept {
+  const auto pos = text.size();
+  text.resize(pos + size);
+  return text.data() + pos;
+}
+
+#ifdef CARTA_SSE2
+
+// Zero extends 8 UTF-16 code units to wchar_t and stores them at dst.
+inline void Store(wchar_t* dst, __m128i units) noexcept {
+  if constexpr (sizeof(wchar_t) == 2) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), units);
+  } else {
+    const auto zero = _mm_setzero_si128();
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi16(units, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4), _mm_unpackhi_epi16(units, zero));
+  }
+}
+
+// Zero extends 16 bytes to wchar_t and stores them at dst.
+inline void Widen(wchar_t* dst, __m128i bytes) noexcept {
+  const auto zero = _mm_setzero_si128();
+  Store(dst, _mm_unpacklo_epi8(bytes, zero));
+  Store(dst + 8, _mm_unpackhi_epi8(bytes, zero));
+}
+
+#endif
+
+// Zero extends size bytes to wchar_t.
+inline void Widen(wchar_t* dst, const char* src, std::size_t size) noexcept {
+  std::size_t i = 0;
+#ifdef CARTA_SSE2
+  for (; i + 16 <= size; i += 16) {
+    Widen(dst + i, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+  }
+#endif
+  for (; i < size; i++) {
+    dst[i] = static_cast<wchar_t>(static_cast<unsigned char>(src[i]));
+  }
+}
+
+// Returns the number of bytes before the first byte that is not ASCII.
+inline std::size_t Ascii(std::string_view value) noexcept {
+  std::size_t i = 0;
+#ifdef CARTA_SSE2
+  for (; i + 16 <= value.size(); i += 16) {
+    const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(value.data() + i));
+    if (const auto mask = static_cast<unsigned>(_mm_movemask_epi8(block))) {
+      return i + static_cast<std::size_t>(std::countr_zero(mask));
+    }
+  }
+#endif
+  while (i < value.size() && static_cast<unsigned char>(value[i]) < 0x80) {
+    i++;
+  }
+  return i;
+}
+
+// Decodes the UTF-8 sequence at value[i] and advances i.
+// Returns U+FFFD for invalid sequences.
+inline char32_t Decode(std::string_view value, std::size_t& i) noexcept {
+  const auto c = static_cast<unsigned char>(value[i]);
+  const auto length = c >= 0xF0 ? 4u : c >= 0xE0 ? 3u : c >= 0xC0 ? 2u : c < 0x80 ? 1u : 0u;
+  if (!length || i + length > value.size()) {
+    i++;
+    return U'\xFFFD';
+  }
+  char32_t code = c & (0x7F >> length);
+  std::size_t j = 1;
+  for (; j < length; j++) {
+    const auto next = static_cast<unsigned char>(value[i + j]);
+    if ((next & 0xC0) != 0x80) {
+      break;
+    }
+    code = (code << 6) | (next & 0x3F);
+  }
+  i += j;
+  return j < length || code > 0x10FFFF ? U'\xFFFD' : code;
+}
+
+}  // namespace detail
+
+// Appends UTF-8 text as UTF-16. Invalid sequences are replaced with U+FFFD.
+// Runs of ASCII characters are widened 16 bytes at a time.
+template <typename Buffer>
+inline void AppendUtf16(Buffer& text, std::string_view value) noexcept {
+  for (std::size_t i = 0; i < value.size();) {
+    if (const auto ascii = detail::Ascii(value.substr(i))) {
+      detail::Widen(detail::Grow(text, ascii), value.data() + i, ascii);
+      i += ascii;
+      continue;
+    }
+    auto code = detail::Decode(value, i);
+    if constexpr (sizeof(wchar_t) == 2) {
+      if (code >= 0x10000) {
+        code -= 0x10000;
+        text.push_back(static_cast<wchar_t>(0xD800 + (code >> 10)));
+        text.push_back(static_cast<wchar_t>(0xDC00 + (code & 0x3FF)));
+        continue;
+      }
+    }
+    text.push_back(static_cast<wchar_t>(code));
+  }
+}
+
+// Appends Windows-1252 text as UTF-16.
+// Bytes are widened 16 at a time and only 0x80 to 0x9F are looked up.
+template <typename Buffer>
+inline void AppendWindows1252(Buffer& text, std::string_view value) noexcept {
+  constexpr wchar_t table[32] = {
+    0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+    0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178,
+  };
+  const auto dst = detail::Grow(text, value.size());
+  std::size_t i = 0;
+#ifdef CARTA_SSE2
+  const auto high = _mm_set1_epi8(static_cast<char>(0xE0));
+  const auto c1 = _mm_set1_epi8(static_cast<char>(0x80));
+  for (; i + 16 <= value.size(); i += 16) {
+    const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(value.data() + i));
+    detail::Widen(dst + i, block);
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(block, high), c1)));
+    for (; mask; mask &= mask - 1) {
+      const auto pos = i + static_cast<std::size_t>(std::countr_zero(mask));
+      dst[pos] = table[static_cast<unsigned char>(value[pos]) - 0x80];
+    }
+  }
+#endif
+  for (; i < value.size(); i++) {
+    const auto c = static_cast<unsigned char>(value[i]);
+    dst[i] = c >= 0x80 && c < 0xA0 ? table[c - 0x80] : static_cast<wchar_t>(c);
+  }
+}
+
+// Folds ASCII and Latin-1 letters to lower case.
+inline wchar_t FoldCase(wchar_t c) noexcept {
+  if ((c >= L'A' && c <= L'Z') || (c >= 0xC0 && c <= 0xDE && c != 0xD7)) {
+    return static_cast<wchar_t>(c + 32);
+  }
+  return c;
+}
+
+// Returns true if text is valid UTF-8.
+// Errors in the last three bytes are ignored, because a sample may end inside a sequence.
+inline bool ValidUtf8(std::string_view value) noexcept {
+  for (std::size_t i = 0; i < value.size();) {
+    i += detail::Ascii(value.substr(i));
+    if (i == value.size()) {
+      break;
+    }
+    const auto begin = i;
+    if (detail::Decode(value, i) == U'\xFFFD' && value.substr(begin, 3) != "\xEF\xBF\xBD" && begin + 4 <= value.size()) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,204 @@
+#include "test.hpp"
+#include <aggregate.hpp>
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+constexpr std::size_t rows = 30'000;
+
+// Values of a column aggregated one at a time.
+struct reference {
+  std::uint64_t count = 0;
+  std::uint64_t numbers = 0;
+  double sum = 0.0;
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  std::set<std::string> distinct;
+
+  void add(double number, std::string key) {
+    count++;
+    numbers++;
+    sum += number;
+    min = std::min(min, number);
+    max = std::max(max, number);
+    distinct.insert(std::move(key));
+  }
+
+  void add(std::string key) {
+    count++;
+    distinct.insert(std::move(key));
+  }
+};
+
+// Columns of integers, doubles with both zeros and NaN, dictionary codes and text fields.
+// Numbers are multiples of a quarter, so that their sums are exact in any order.
+struct table {
+  std::vector<std::int64_t> integers;
+  std::vector<double> doubles;
+  std::vector<std::uint32_t> codes;
+  std::vector<std::string> texts;
+
+  table() : integers(rows), doubles(rows), codes(rows), texts(rows) {
+    constexpr std::string_view words[] = { "", "apple", "1.25", "-7", "nan", "1e3", "12x", "banana" };
+    std::mt19937_64 random{ 11 };
+    for (std::size_t row = 0; row < rows; row++) {
+      integers[row] = static_cast<std::int64_t>(random() % 20'000) - 10'000;
+      const auto value = random() % 100;
+      doubles[row] = value == 0 ? std::nan("") : value == 1 ? -0.0 : static_cast<double>(value) / 4.0 - 12.0;
+      codes[row] = static_cast<std::uint32_t>(random() % 37);
+      texts[row] = random() % 2 ? std::string{ words[random() % std::size(words)] } : std::to_string(random() % 500);
+    }
+  }
+
+  std::vector<reference> aggregate(const std::vector<std::uint32_t>& rows) const {
+    std::vector<reference> cols(4);
+    for (const auto row : rows) {
+      cols[0].add(static_cast<double>(integers[row]), std::to_string(integers[row]));
+      if (std::isnan(doubles[row])) {
+        cols[1].add("nan");
+      } else {
+        cols[1].add(doubles[row], std::to_string(doubles[row] + 0.0));
+      }
+      cols[2].add(std::to_string(codes[row]));
+      if (const auto& text = texts[row]; !text.empty()) {
+        double number = 0.0;
+        const auto end = text.data() + text.size();
+        if (const auto [ptr, ec] = std::from_chars(text.data(), end, number); ec == std::errc{} && ptr == end && !std::isnan(number)) {
+          cols[3].add(number, text);
+        } else {
+          cols[3].add(text);
+        }
+      }
+    }
+    return cols;
+  }
+
+  void add(Aggregator& aggregator) const {
+    aggregator.Add(Aggregator::Integers(integers));
+    aggregator.Add(Aggregator::Doubles(doubles));
+    aggregator.Add(Aggregator::Codes(codes));
+    aggregator.Add(Aggregator::Texts([this](std::size_t row) { return std::string_view{ texts[row] }; }));
+  }
+};
+
+Totals aggregate(const table& table, std::size_t begin, std::size_t end, const Selection* view, std::size_t jobs) {
+  Aggregator aggregator;
+  table.add(aggregator);
+  aggregator.Start(begin, end, view, jobs);
+  for (auto job = aggregator.Jobs(); job > 0; job--) {
+    aggregator.Run(job - 1, {});
+  }
+  return aggregator.Result();
+}
+
+// Compares the totals with the reference. The distinct values are estimated within 5%.
+bool matches(const Totals& totals, const std::vector<reference>& expected, std::size_t rows) {
+  if (!CHECK(totals.rows == rows) || !CHECK(totals.cols.size() == expected.size())) {
+    return false;
+  }
+  for (std::size_t col = 0; col < expected.size(); col++) {
+    const auto& aggregate = totals.cols[col];
+    const auto& reference = expected[col];
+    const auto distinct = static_cast<double>(reference.distinct.size());
+    const auto estimate = static_cast<double>(aggregate.Distinct());
+    if (!CHECK(aggregate.Count() == reference.count) || !CHECK(aggregate.Numbers() == reference.numbers) ||
+        !CHECK(aggregate.Sum() == reference.sum) || !CHECK(aggregate.Min() == reference.min) || !CHECK(aggregate.Max() == reference.max) ||
+        !CHECK(std::abs(estimate - distinct) <= std::max(2.0, distinct * 0.05))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Aggregates ranges of rows in several jobs and compares them with aggregating every row one at a time.
+void aggregator_matches_row_by_row() {
+  const table table;
+  for (const auto& [begin, end] : { std::pair{ std::size_t(0), rows }, std::pair{ std::size_t(1'000), std::size_t(1'100) }, std::pair{ rows, rows } }) {
+    std::vector<std::uint32_t> range;
+    for (auto row = begin; row < end; row++) {
+      range.push_back(static_cast<std::uint32_t>(row));
+    }
+    const auto expected = table.aggregate(range);
+    for (const std::size_t jobs : { 1, 3, 8 }) {
+      if (!matches(aggregate(table, begin, end, nullptr, jobs), expected, range.size())) {
+        return;
+      }
+    }
+  }
+}
+
+// Aggregates the rows shown by a filtered selection of a random order.
+void aggregator_matches_view() {
+  const table table;
+  std::vector<std::uint32_t> order(rows);
+  std::vector<std::uint32_t> positions(rows);
+  for (std::uint32_t i = 0; i < rows; i++) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937_64{ 12 });
+  for (std::size_t i = 0; i < rows; i++) {
+    positions[order[i]] = static_cast<std::uint32_t>(i);
+  }
+  std::vector<std::uint32_t> selected;
+  std::vector<std::uint32_t> shown;
+  for (std::uint32_t position = 0; position < rows; position += 3) {
+    selected.push_back(position);
+    shown.push_back(order[position]);
+  }
+  Predicate predicate;
+  Predicate::Search(L"x", predicate);
+  Filter filter;
+  filter.Add(predicate);
+  const auto permutation = std::make_shared<const Permutation>(std::move(order), std::move(positions));
+  const Selection view{ permutation, filter, selected };
+  const auto expected = table.aggregate(shown);
+  for (const std::size_t jobs : { 1, 4 }) {
+    if (!matches(aggregate(table, 0, selected.size(), &view, jobs), expected, shown.size())) {
+      return;
+    }
+  }
+}
+
+// Totals of consecutive ranges merge into the totals of both, like the totals of a growing table.
+void totals_merge_ranges() {
+  const table table;
+  auto totals = aggregate(table, 0, 10'000, nullptr, 2);
+  totals.Merge(aggregate(table, 10'000, rows, nullptr, 3));
+  std::vector<std::uint32_t> all(rows);
+  for (std::uint32_t i = 0; i < rows; i++) {
+    all[i] = i;
+  }
+  matches(totals, table.aggregate(all), rows);
+}
+
+// The estimate of distinct hashes stays within three standard errors over a range of cardinalities.
+void distinct_estimates_cardinality() {
+  for (const std::uint64_t size : { 1, 10, 100, 1'000, 10'000, 100'000, 1'000'000 }) {
+    Distinct distinct;
+    for (std::uint64_t i = 0; i < size; i++) {
+      distinct.Add(Hash(i));
+      distinct.Add(Hash(i));
+    }
+    const auto error = std::abs(static_cast<double>(distinct.Estimate()) - static_cast<double>(size));
+    CHECK(error <= std::max(1.0, static_cast<double>(size) * 3 * 0.0163));
+  }
+}
+
+}  // namespace
+
+TEST("aggregate/aggregator_matches_row_by_row", aggregator_matches_row_by_row);
+TEST("aggregate/aggregator_matches_view", aggregator_matches_view);
+TEST("aggregate/totals_merge_ranges", totals_merge_ranges);
+TEST("aggregate/distinct_estimates_cardinality", distinct_estimates_cardinality);
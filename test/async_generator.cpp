@@ -0,0 +1,106 @@
+#include "test.hpp"
+#include <ice/async_generator.hpp>
+#include <ice/pool.hpp>
+#include <ice/task.hpp>
+#include <atomic>
+#include <latch>
+#include <thread>
+#include <utility>
+#include <cstddef>
+
+namespace {
+
+// Counts the coroutine frames that were destroyed. Parameters live until the frame is destroyed.
+class frame {
+public:
+  explicit frame(std::atomic_int& destroyed) noexcept : destroyed_(&destroyed) {
+  }
+
+  frame(frame&& other) noexcept : destroyed_(std::exchange(other.destroyed_, nullptr)) {
+  }
+
+  frame(const frame& other) = delete;
+  frame& operator=(frame&& other) = delete;
+  frame& operator=(const frame& other) = delete;
+
+  ~frame() {
+    if (destroyed_) {
+      destroyed_->fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+private:
+  std::atomic_int* destroyed_;
+};
+
+// Switches to a pool thread before every value, so that the consumer is resumed on changing threads.
+ice::async_generator<std::size_t> produce(ice::pool& pool, std::size_t size, frame) {
+  for (std::size_t i = 0; i < size; i++) {
+    co_await pool.schedule(true);
+    co_yield i;
+  }
+}
+
+ice::task<void> consume(ice::pool& pool, std::size_t size, std::atomic_int& destroyed, std::thread::id caller, std::latch& done) {
+  std::size_t expected = 0;
+  auto foreign = true;
+  auto values = produce(pool, size, frame{ destroyed });
+  while (const auto value = co_await values.next()) {
+    if (!CHECK(*value == expected)) {
+      break;
+    }
+    foreign = foreign && std::this_thread::get_id() != caller;
+    expected++;
+  }
+  CHECK(expected == size);
+  CHECK(foreign);
+  done.count_down();
+}
+
+// The consumer receives every value in order on the pool threads that produced them.
+void yields_across_threads() {
+  constexpr std::size_t consumers = 8;
+  std::atomic_int destroyed = 0;
+  std::latch done{ consumers };
+  {
+    ice::pool pool{ 4 };
+    for (std::size_t i = 0; i < consumers; i++) {
+      consume(pool, 10'000, destroyed, std::this_thread::get_id(), done).detach();
+    }
+    done.wait();
+  }
+  CHECK(destroyed.load() == static_cast<int>(consumers));
+}
+
+ice::task<void> take(ice::pool& pool, std::size_t size, std::atomic_int& destroyed, std::latch& done) {
+  {
+    auto values = produce(pool, 1'000'000, frame{ destroyed });
+    for (std::size_t i = 0; i < size; i++) {
+      const auto value = co_await values.next();
+      if (!CHECK(value && *value == i)) {
+        break;
+      }
+    }
+  }
+  done.count_down();
+}
+
+// A generator that is suspended at a yield on another thread, or was never resumed, is destroyed before it finished.
+void destroys_unfinished_generator() {
+  constexpr std::size_t consumers = 16;
+  std::atomic_int destroyed = 0;
+  std::latch done{ consumers };
+  {
+    ice::pool pool{ 4 };
+    for (std::size_t i = 0; i < consumers; i++) {
+      take(pool, i, destroyed, done).detach();
+    }
+    done.wait();
+  }
+  CHECK(destroyed.load() == static_cast<int>(consumers));
+}
+
+}  // namespace
+
+TEST("async_generator/yields_across_threads", yields_across_threads);
+TEST("async_generator/destroys_unfinished_generator", destroys_unfinished_generator);
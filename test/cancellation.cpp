@@ -0,0 +1,117 @@
+#include "test.hpp"
+#include <ice/cancellation.hpp>
+#include <ice/context.hpp>
+#include <ice/task.hpp>
+#include <atomic>
+#include <chrono>
+#include <stop_token>
+#include <thread>
+#include <utility>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+ice::task<void> sleep(ice::context& context, std::stop_token token, int& result) {
+  result = co_await context.schedule_after(1h, std::move(token)) ? 1 : 0;
+  context.stop();
+}
+
+ice::task<void> request_stop(ice::context& context, std::stop_source& source) {
+  co_await context.schedule(true);
+  source.request_stop();
+}
+
+// The timer is in the heap of the run loop when the stop is requested on the context thread.
+// The stop callback makes the loop expire it before its deadline.
+void cancels_pending_timer() {
+  ice::context context;
+  std::stop_source source;
+  auto result = -1;
+  auto sleeper = sleep(context, source.get_token(), result);
+  auto stopper = request_stop(context, source);
+  const auto start = std::chrono::steady_clock::now();
+  context.run();
+  CHECK(result == 0);
+  CHECK(sleeper.is_ready());
+  CHECK(stopper.is_ready());
+  CHECK(std::chrono::steady_clock::now() - start < 1min);
+}
+
+ice::task<void> sleep(ice::context& context, std::stop_token token, std::atomic_int& result) {
+  co_await context.schedule(true);
+  result.store(co_await context.schedule_after(1h, std::move(token)) ? 1 : 0);
+  context.stop();
+}
+
+// The stop is requested from another thread while the run loop waits for the deadline.
+void cancels_waiting_timer() {
+  ice::context context;
+  std::stop_source source;
+  std::atomic_int result = -1;
+  auto sleeper = sleep(context, source.get_token(), result);
+  std::thread thread{ [&]() { context.run(); } };
+  std::this_thread::sleep_for(10ms);
+  source.request_stop();
+  thread.join();
+  CHECK(result.load() == 0);
+  CHECK(sleeper.is_ready());
+}
+
+// A timer that is awaited with a stop request does not suspend.
+void skips_stopped_timer() {
+  ice::context context;
+  std::stop_source source;
+  source.request_stop();
+  auto result = -1;
+  auto sleeper = sleep(context, source.get_token(), result);
+  CHECK(result == 0);
+  CHECK(sleeper.is_ready());
+}
+
+ice::task<void> wait(std::stop_token token, int& result) {
+  result = co_await ice::when_stopped(std::move(token)) ? 1 : 0;
+}
+
+// The awaiter is resumed by the thread that requests the stop.
+void resumes_when_stopped() {
+  std::stop_source source;
+  auto result = -1;
+  auto waiter = wait(source.get_token(), result);
+  CHECK(!waiter.is_ready());
+  source.request_stop();
+  CHECK(waiter.is_ready());
+  CHECK(result == 1);
+}
+
+// A token without a source can never be stopped, so there is nothing to wait for.
+void skips_unstoppable_token() {
+  auto result = -1;
+  auto waiter = wait({}, result);
+  CHECK(waiter.is_ready());
+  CHECK(result == 0);
+}
+
+ice::task<void> hop(ice::context& context, std::stop_token token, int& result) {
+  result = co_await context.schedule(std::move(token), true) ? 1 : 0;
+}
+
+// A schedule with a stop request completes without posting to the scheduler.
+void skips_stopped_schedule() {
+  ice::context context;
+  std::stop_source source;
+  source.request_stop();
+  auto result = -1;
+  auto task = hop(context, source.get_token(), result);
+  CHECK(task.is_ready());
+  CHECK(result == 0);
+}
+
+}  // namespace
+
+TEST("cancellation/cancels_pending_timer", cancels_pending_timer);
+TEST("cancellation/cancels_waiting_timer", cancels_waiting_timer);
+TEST("cancellation/skips_stopped_timer", skips_stopped_timer);
+TEST("cancellation/resumes_when_stopped", resumes_when_stopped);
+TEST("cancellation/skips_unstoppable_token", skips_unstoppable_token);
+TEST("cancellation/skips_stopped_schedule", skips_stopped_schedule);
@@ -0,0 +1,213 @@
+#include "test.hpp"
+#include <ice/channel.hpp>
+#include <ice/pool.hpp>
+#include <ice/task.hpp>
+#include <ice/when_all.hpp>
+#include <array>
+#include <atomic>
+#include <latch>
+#include <optional>
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+constexpr std::size_t producers = 4;
+constexpr std::size_t consumers = 4;
+constexpr std::size_t values = 50'000;
+
+using channel = ice::channel<std::uint64_t, 16>;
+
+struct totals {
+  std::atomic_uint64_t count = 0;
+  std::atomic_uint64_t sum = 0;
+};
+
+ice::task<void> produce(ice::pool& pool, channel& channel, std::uint64_t first) {
+  co_await pool.schedule(true);
+  for (auto value = first; value < values; value += producers) {
+    if (!co_await channel.send(value)) {
+      co_return;
+    }
+  }
+}
+
+ice::task<void> consume(ice::pool& pool, channel& channel, totals& totals, std::latch& done) {
+  co_await pool.schedule(true);
+  while (const auto value = co_await channel.receive(pool)) {
+    totals.count.fetch_add(1, std::memory_order_relaxed);
+    totals.sum.fetch_add(*value, std::memory_order_relaxed);
+  }
+  done.count_down();
+}
+
+// Sends in chunks and stops at the first chunk that was not sent completely.
+ice::task<void> produce_many(ice::pool& pool, channel& channel, std::uint64_t first) {
+  co_await pool.schedule(true);
+  std::array<std::uint64_t, 64> chunk;
+  auto value = first;
+  while (value < values) {
+    std::size_t size = 0;
+    for (; size < chunk.size() && value < values; value += producers) {
+      chunk[size++] = value;
+    }
+    if (co_await channel.send_many(std::span{ chunk.data(), size }) != size) {
+      co_return;
+    }
+  }
+}
+
+ice::task<void> consume_many(ice::pool& pool, channel& channel, totals& totals, std::latch& done) {
+  co_await pool.schedule(true);
+  std::array<std::uint64_t, 24> chunk;
+  while (const auto size = co_await channel.receive_many(chunk, pool)) {
+    totals.count.fetch_add(size, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < size; i++) {
+      totals.sum.fetch_add(chunk[i], std::memory_order_relaxed);
+    }
+  }
+  done.count_down();
+}
+
+ice::task<void> close(channel& channel, std::vector<ice::task<void>> tasks) {
+  co_await ice::when_all(tasks);
+  channel.close();
+}
+
+// Every value that the producers send on the pool is received by exactly one consumer.
+template <bool Batched>
+void transfers_every_value() {
+  totals totals;
+  std::latch done{ consumers };
+  {
+    ice::pool pool{ 4 };
+    channel channel;
+    for (std::size_t i = 0; i < consumers; i++) {
+      if constexpr (Batched) {
+        consume_many(pool, channel, totals, done).detach();
+      } else {
+        consume(pool, channel, totals, done).detach();
+      }
+    }
+    std::vector<ice::task<void>> tasks;
+    for (std::size_t i = 0; i < producers; i++) {
+      tasks.push_back(Batched ? produce_many(pool, channel, i) : produce(pool, channel, i));
+    }
+    close(channel, std::move(tasks)).detach();
+    done.wait();
+  }
+  CHECK(totals.count.load() == values);
+  CHECK(totals.sum.load() == values * (values - 1) / 2);
+}
+
+ice::task<void> send(ice::channel<int, 1>& channel, int value, int& result) {
+  result = co_await channel.send(value) ? 1 : 0;
+}
+
+ice::task<void> receive(ice::channel<int, 1>& channel, std::optional<int>& result, bool& resumed) {
+  result = co_await channel.receive();
+  resumed = true;
+}
+
+// Closing resumes suspended senders with false and suspended receivers with std::nullopt.
+// Values that were sent before can still be received.
+void close_resumes_waiters() {
+  ice::channel<int, 1> full;
+  auto first = -1;
+  auto second = -1;
+  auto sent = send(full, 1, first);
+  auto blocked = send(full, 2, second);
+  CHECK(sent.is_ready() && first == 1);
+  CHECK(!blocked.is_ready());
+
+  ice::channel<int, 1> empty;
+  std::array<std::optional<int>, 2> results{ 0, 0 };
+  std::array<bool, 2> resumed{};
+  auto receiver0 = receive(empty, results[0], resumed[0]);
+  auto receiver1 = receive(empty, results[1], resumed[1]);
+  CHECK(!resumed[0] && !resumed[1]);
+
+  full.close();
+  empty.close();
+  CHECK(blocked.is_ready() && second == 0);
+  CHECK(resumed[0] && !results[0]);
+  CHECK(resumed[1] && !results[1]);
+
+  std::optional<int> value;
+  auto resumed_after = false;
+  auto drain = receive(full, value, resumed_after);
+  CHECK(value == 1);
+  drain = receive(full, value, resumed_after);
+  CHECK(!value);
+  CHECK(full.is_closed());
+}
+
+ice::task<void> send_many(ice::channel<int, 4>& channel, std::span<int> values, std::size_t& result) {
+  result = co_await channel.send_many(values);
+}
+
+ice::task<void> receive_many(ice::channel<int, 4>& channel, std::span<int> values, std::size_t& result) {
+  result = co_await channel.receive_many(values);
+}
+
+// A sender that does not fit is suspended with the values that did, receivers take what is there
+// and refill the buffer from the sender, and a suspended receiver takes what the next sender has.
+void transfers_batches() {
+  ice::channel<int, 4> channel;
+  std::array<int, 10> sent{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  auto sent_size = std::size_t(0);
+  auto sender = send_many(channel, sent, sent_size);
+  CHECK(!sender.is_ready());
+
+  std::array<int, 8> received{};
+  auto received_size = std::size_t(0);
+  auto receiver = receive_many(channel, std::span{ received.data(), 3 }, received_size);
+  CHECK(receiver.is_ready() && received_size == 3);
+  CHECK(received[0] == 0 && received[1] == 1 && received[2] == 2);
+  CHECK(!sender.is_ready());
+
+  receiver = receive_many(channel, received, received_size);
+  CHECK(receiver.is_ready() && received_size == 7);
+  for (std::size_t i = 0; i < received_size; i++) {
+    CHECK(received[i] == static_cast<int>(i + 3));
+  }
+  CHECK(sender.is_ready() && sent_size == 10);
+
+  receiver = receive_many(channel, received, received_size);
+  CHECK(!receiver.is_ready());
+  sender = send_many(channel, std::span{ sent.data(), 2 }, sent_size);
+  CHECK(sender.is_ready() && sent_size == 2);
+  CHECK(receiver.is_ready() && received_size == 2);
+  CHECK(received[0] == 0 && received[1] == 1);
+}
+
+// Closing resumes a sender that did not fit with the number of values it sent, and those can be received.
+void close_returns_partial_batches() {
+  ice::channel<int, 4> channel;
+  std::array<int, 6> sent{ 0, 1, 2, 3, 4, 5 };
+  auto sent_size = std::size_t(0);
+  auto sender = send_many(channel, sent, sent_size);
+  CHECK(!sender.is_ready());
+  channel.close();
+  CHECK(sender.is_ready() && sent_size == 4);
+
+  std::array<int, 8> received{};
+  auto received_size = std::size_t(0);
+  auto receiver = receive_many(channel, received, received_size);
+  CHECK(receiver.is_ready() && received_size == 4);
+  CHECK(received[0] == 0 && received[3] == 3);
+  receiver = receive_many(channel, received, received_size);
+  CHECK(receiver.is_ready() && received_size == 0);
+  sender = send_many(channel, sent, sent_size);
+  CHECK(sender.is_ready() && sent_size == 0);
+}
+
+}  // namespace
+
+TEST("channel/transfers_every_value", transfers_every_value<false>);
+TEST("channel/transfers_every_value/batched", transfers_every_value<true>);
+TEST("channel/close_resumes_waiters", close_resumes_waiters);
+TEST("channel/transfers_batches", transfers_batches);
+TEST("channel/close_returns_partial_batches", close_returns_partial_batches);
@@ -0,0 +1,132 @@
+#include "test.hpp"
+#include <csv.hpp>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+namespace {
+
+// Returns a field with quoted delimiters, quoted line breaks and escaped quotes.
+std::string field(std::mt19937_64& random) {
+  constexpr std::string_view words[] = { "", "a", "bc", "d e", "\"f,g\"", "\"h\nij\"", "\"k\"\"l\"", "\"m\r\n\"\"n\"\"\n\"" };
+  return std::string{ words[random() % std::size(words)] };
+}
+
+// Splits rows at line breaks that are not quoted, without the line breaks.
+std::vector<std::string_view> split(std::string_view data) {
+  std::vector<std::string_view> rows;
+  std::size_t begin = 0;
+  auto quoted = false;
+  for (std::size_t pos = 0; pos < data.size(); pos++) {
+    if (data[pos] == '"') {
+      quoted = !quoted;
+    } else if (data[pos] == '\n' && !quoted) {
+      auto row = data.substr(begin, pos - begin);
+      if (row.ends_with('\r')) {
+        row.remove_suffix(1);
+      }
+      rows.push_back(row);
+      begin = pos + 1;
+    }
+  }
+  if (begin < data.size()) {
+    rows.push_back(data.substr(begin));
+  }
+  return rows;
+}
+
+// Splits a row at delimiters that are not quoted.
+std::vector<std::string_view> fields(std::string_view row) {
+  std::vector<std::string_view> fields;
+  std::size_t begin = 0;
+  auto quoted = false;
+  for (std::size_t pos = 0; pos <= row.size(); pos++) {
+    if (pos == row.size() || (row[pos] == ',' && !quoted)) {
+      fields.push_back(row.substr(begin, pos - begin));
+      begin = pos + 1;
+    } else if (row[pos] == '"') {
+      quoted = !quoted;
+    }
+  }
+  return fields;
+}
+
+// Temporary file that is removed when it is destroyed.
+class file {
+public:
+  explicit file(std::string_view data) : path_(std::filesystem::temp_directory_path() / "carta-test.csv") {
+    std::ofstream{ path_, std::ios::binary }.write(data.data(), static_cast<std::streamsize>(data.size()));
+  }
+
+  file(file&& other) = delete;
+  file(const file& other) = delete;
+  file& operator=(file&& other) = delete;
+  file& operator=(const file& other) = delete;
+
+  ~file() {
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+  }
+
+  const std::filesystem::path& path() const noexcept {
+    return path_;
+  }
+
+private:
+  std::filesystem::path path_;
+};
+
+// Indexes a file in chunks of different sizes, scanned in reverse order and appended in order,
+// and compares the rows and fields with a naive split.
+void scan_matches_naive_split() {
+  std::mt19937_64 random{ 4 };
+  for (const auto newline : { false, true }) {
+    std::string data = "first,second,third\n";
+    for (std::size_t row = 0; row < 2'000; row++) {
+      data += field(random) + "," + field(random) + "," + field(random);
+      data += random() % 4 ? "\n" : "\r\n";
+    }
+    if (!newline) {
+      data += "\"last\",row";
+    }
+    const file file{ data };
+    const auto rows = split(data);
+    for (const std::size_t size : { 1, 7, 16, 17, 64, 1000, 1 << 20 }) {
+      Csv csv;
+      if (!CHECK(csv.Open(file.path()))) {
+        return;
+      }
+      CHECK(csv.Cols() == 3);
+      auto chunks = csv.Split(size, size);
+      for (auto it = chunks.rbegin(); it != chunks.rend(); ++it) {
+        Csv::Scan(csv.Data(), *it);
+      }
+      for (const auto& chunk : chunks) {
+        csv.Append(chunk);
+      }
+      CHECK(csv.Complete());
+      if (!CHECK(csv.Rows() == rows.size() - 1)) {
+        return;
+      }
+      for (std::size_t row = 0; row < csv.Rows(); row++) {
+        const auto expected = fields(rows[row + 1]);
+        if (!CHECK(csv.Row(row) == rows[row + 1])) {
+          return;
+        }
+        for (std::size_t col = 0; col < expected.size(); col++) {
+          if (!CHECK(csv.Field(row, col) == expected[col])) {
+            return;
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST("csv/scan_matches_naive_split", scan_matches_naive_split);
@@ -0,0 +1,253 @@
+#include "test.hpp"
+#include <filter.hpp>
+#include <sort.hpp>
+#include <text.hpp>
+#include <fmt/format.h>
+#include <fmt/xchar.h>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+constexpr std::size_t rows = 20'000;
+
+// Columns of integers, doubles with NaN and dictionary codes.
+struct table {
+  std::vector<std::int64_t> integers;
+  std::vector<double> doubles;
+  std::vector<std::wstring> words{ L"apple", L"Banana", L"cherry", L"", L"5" };
+  std::vector<std::uint32_t> codes;
+
+  table() : integers(rows), doubles(rows), codes(rows) {
+    std::mt19937_64 random{ 7 };
+    for (std::size_t row = 0; row < rows; row++) {
+      integers[row] = static_cast<std::int64_t>(random() % 101) - 50;
+      doubles[row] = random() % 50 ? static_cast<double>(random() % 2001) / 100.0 - 10.0 : std::nan("");
+      codes[row] = static_cast<std::uint32_t>(random() % words.size());
+    }
+  }
+
+  // Appends the text of a value like the table shows it.
+  void format(fmt::wmemory_buffer& buffer, std::size_t col, std::size_t row) const {
+    switch (col) {
+    case 0:
+      fmt::format_to(std::back_inserter(buffer), L"{}", integers[row]);
+      break;
+    case 1:
+      fmt::format_to(std::back_inserter(buffer), L"{}", doubles[row]);
+      break;
+    default:
+      buffer.append(words[codes[row]]);
+      break;
+    }
+  }
+
+  // Returns the kernel that the table uses for a predicate.
+  Selector::Kernel kernel(const Predicate& predicate, std::size_t col) const {
+    if (col == 2) {
+      return Selector::Codes(predicate, codes, words.size(), [this](fmt::wmemory_buffer& buffer, std::size_t code) {
+        buffer.append(words[code]);
+      });
+    }
+    if (predicate.Numeric()) {
+      return col ? Selector::Doubles(predicate, doubles) : Selector::Integers(predicate, integers);
+    }
+    return Selector::Texts(predicate, [this, col](fmt::wmemory_buffer& buffer, std::size_t row) {
+      format(buffer, col, row);
+    });
+  }
+
+  // Matches a value with a predicate one at a time.
+  bool match(const Predicate& predicate, std::size_t col, std::size_t row) const {
+    if (predicate.Numeric() && col < 2) {
+      return predicate.Match(col ? doubles[row] : static_cast<double>(integers[row]));
+    }
+    fmt::wmemory_buffer buffer;
+    format(buffer, col, row);
+    std::transform(buffer.begin(), buffer.end(), buffer.begin(), FoldCase);
+    return predicate.Match(std::wstring_view{ buffer.data(), buffer.size() });
+  }
+};
+
+struct condition {
+  std::size_t col;
+  const wchar_t* text;
+};
+
+std::vector<std::uint32_t> select(Selector& selector, const Permutation& order, const std::vector<std::uint32_t>* input, std::size_t jobs) {
+  selector.Start(order, rows, input, jobs);
+  for (auto job = selector.Jobs(); job > 0; job--) {
+    selector.Run(job - 1, {});
+  }
+  return selector.Result();
+}
+
+// Returns a random order, or the order of an unsorted table when shuffle is false.
+std::shared_ptr<const Permutation> order(bool shuffle) {
+  if (!shuffle) {
+    return std::make_shared<const Permutation>();
+  }
+  std::vector<std::uint32_t> order(rows);
+  std::vector<std::uint32_t> positions(rows);
+  std::iota(order.begin(), order.end(), 0u);
+  std::shuffle(order.begin(), order.end(), std::mt19937_64{ 8 });
+  for (std::size_t i = 0; i < rows; i++) {
+    positions[order[i]] = static_cast<std::uint32_t>(i);
+  }
+  return std::make_shared<const Permutation>(std::move(order), std::move(positions));
+}
+
+// Selects positions with the kernels of the table and compares them with matching every row one at a time,
+// for sorted and unsorted tables, several job counts and previous selections that the filter implies.
+void selector_matches_row_by_row() {
+  const table table;
+  const std::vector<std::vector<condition>> filters{
+    { { 0, L"=5" } },
+    { { 0, L"-3..7" }, { 1, L">=0" } },
+    { { 1, L"-2.5..2.5" } },
+    { { 1, L"<=-9.99" }, { 2, L"a" } },
+    { { 0, L"1" }, { 1, L"5" } },
+    { { 2, L"=banana" } },
+    { { 2, L"b..c" }, { 0, L">=-10" } },
+    { { 2, L"=5" } },
+    { { 0, L"..0" }, { 1, L"nan" } },
+    { { 0, L"x" } },
+  };
+  for (const auto shuffle : { false, true }) {
+    const auto order = ::order(shuffle);
+    for (const auto& conditions : filters) {
+      std::vector<Predicate> predicates;
+      for (const auto& [col, text] : conditions) {
+        if (!CHECK(Predicate::Parse(col, text, predicates.emplace_back()))) {
+          return;
+        }
+      }
+      std::vector<std::uint32_t> expected;
+      for (std::uint32_t position = 0; position < rows; position++) {
+        const auto row = static_cast<std::size_t>(order->Row(static_cast<int>(position)));
+        if (std::all_of(predicates.begin(), predicates.end(), [&](const Predicate& p) { return table.match(p, p.Col(), row); })) {
+          expected.push_back(position);
+        }
+      }
+      for (const std::size_t jobs : { 1, 3, 5 }) {
+        Selector selector;
+        for (const auto& predicate : predicates) {
+          selector.Add(table.kernel(predicate, predicate.Col()));
+        }
+        if (!CHECK(select(selector, *order, nullptr, jobs) == expected)) {
+          return;
+        }
+
+        // Evaluates the first predicate alone and then all of them over its selection.
+        Selector first;
+        first.Add(table.kernel(predicates[0], predicates[0].Col()));
+        const auto input = select(first, *order, nullptr, jobs);
+        Selector refined;
+        for (const auto& predicate : predicates) {
+          refined.Add(table.kernel(predicate, predicate.Col()));
+        }
+        if (!CHECK(select(refined, *order, &input, jobs) == expected)) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+// Searches all columns with a kernel that keeps rows that match any of them.
+void selector_any_matches_row_by_row() {
+  const table table;
+  for (const std::wstring_view text : { L"an", L"5", L"-1", L"e" }) {
+    Predicate predicate;
+    if (!CHECK(Predicate::Search(text, predicate))) {
+      return;
+    }
+    std::vector<std::uint32_t> expected;
+    for (std::uint32_t row = 0; row < rows; row++) {
+      if (table.match(predicate, 0, row) || table.match(predicate, 1, row) || table.match(predicate, 2, row)) {
+        expected.push_back(row);
+      }
+    }
+    Selector selector;
+    selector.Add(Selector::Any({ table.kernel(predicate, 0), table.kernel(predicate, 1), table.kernel(predicate, 2) }));
+    if (!CHECK(select(selector, Permutation{}, nullptr, 4) == expected)) {
+      return;
+    }
+  }
+}
+
+// Every value that matches a predicate must match the predicates it implies.
+void implies_is_sound() {
+  const wchar_t* texts[] = {
+    L"=5", L"=5.0", L"=abc", L"=b", L"1..10", L"2..3", L"..4", L">=3", L">=1", L"<=4", L"<=-1", L"b..c", L"a..d", L"..b",
+    L"abc", L"b", L"bc", L"5", L"1", L"x..", L"=", L"1..", L"..10",
+  };
+  const std::wstring_view values[] = {
+    L"", L"0", L"1", L"2.5", L"3", L"5", L"10", L"-1", L"1e3", L"a", L"abc", L"b", L"bc", L"c", L"d", L"ab", L"zz", L"5a", L"15", L"inf",
+  };
+  std::vector<Predicate> predicates;
+  for (const auto text : texts) {
+    if (!CHECK(Predicate::Parse(0, text, predicates.emplace_back()))) {
+      return;
+    }
+  }
+  std::size_t implied = 0;
+  for (const auto& lhs : predicates) {
+    for (const auto& rhs : predicates) {
+      if (!lhs.Implies(rhs)) {
+        continue;
+      }
+      implied++;
+      for (const auto value : values) {
+        if (!CHECK(!lhs.Match(value) || rhs.Match(value))) {
+          return;
+        }
+      }
+    }
+  }
+  CHECK(implied > predicates.size());
+}
+
+bool implies(std::vector<condition> lhs, std::vector<condition> rhs) {
+  const auto filter = [](const std::vector<condition>& conditions) {
+    Filter filter;
+    for (const auto& [col, text] : conditions) {
+      Predicate predicate;
+      Predicate::Parse(col, text, predicate);
+      filter.Add(std::move(predicate));
+    }
+    return filter;
+  };
+  return filter(lhs).Implies(filter(rhs));
+}
+
+// Predicates and filters that narrow a previous one imply it, others do not.
+void implies_narrower_filters() {
+  CHECK(implies({ { 0, L"=5" } }, { { 0, L"1..10" } }));
+  CHECK(implies({ { 0, L"abc" } }, { { 0, L"b" } }));
+  CHECK(implies({ { 0, L"=abc" } }, { { 0, L"b" } }));
+  CHECK(implies({ { 0, L">=3" } }, { { 0, L">=1" } }));
+  CHECK(implies({ { 0, L"b..c" } }, { { 0, L"a..d" } }));
+  CHECK(implies({ { 0, L"2..3" }, { 1, L"x" } }, { { 0, L"<=4" } }));
+  CHECK(!implies({ { 0, L"b" } }, { { 0, L"abc" } }));
+  CHECK(!implies({ { 0, L"1..10" } }, { { 0, L"=5" } }));
+  CHECK(!implies({ { 0, L"=5" } }, { { 1, L"=5" } }));
+  CHECK(!implies({ { 0, L"=5" } }, { { 0, L"=5" }, { 1, L"x" } }));
+}
+
+}  // namespace
+
+TEST("filter/selector_matches_row_by_row", selector_matches_row_by_row);
+TEST("filter/selector_any_matches_row_by_row", selector_any_matches_row_by_row);
+TEST("filter/implies_is_sound", implies_is_sound);
+TEST("filter/implies_narrower_filters", implies_narrower_filters);
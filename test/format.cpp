@@ -0,0 +1,61 @@
+#include "test.hpp"
+#include <format.hpp>
+#include <fmt/format.h>
+#include <fmt/xchar.h>
+#include <array>
+#include <random>
+#include <string>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+// Formats a value with AppendDecimal and fmt and reports the first one that differs.
+template <std::size_t Precision>
+bool matches(double value) {
+  std::wstring text;
+  AppendDecimal<Precision>(text, value);
+  return CHECK(text == fmt::format(L"{:.{}f}", value, Precision));
+}
+
+template <std::size_t Precision>
+void decimal_matches_fmt() {
+  constexpr std::array values{
+    0.0, -0.0, 0.125, 0.375, 2.675, 1.005, 0.5, 1.5, 2.5, -0.5, -2.5, 0.001, -0.001, 0.0049, 123456.789, -987654.321,
+    1e15 + 0.125, 49179315193389552.0, 1e-300, 5e-324, 1e300, 0x1p52, 0x1p53 - 1, 9.999999999, 0.1, 0.2, 0.3,
+  };
+  for (const auto value : values) {
+    if (!matches<Precision>(value)) {
+      return;
+    }
+  }
+
+  // Values around the threshold where the fmt fallback starts.
+  const auto limit = 0x1p52 / static_cast<double>(detail::Power10(Precision));
+  for (auto value = std::nextafter(limit, 0.0), i = 0.0; i < 64; value = std::nextafter(value, 0.0), i++) {
+    if (!matches<Precision>(value) || !matches<Precision>(-value)) {
+      return;
+    }
+  }
+
+  // Exact ties at the last digit and values of many magnitudes.
+  std::mt19937_64 random{ Precision };
+  for (std::size_t i = 0; i < 100'000; i++) {
+    const auto digits = static_cast<double>(random() % 1'000'000'000);
+    const auto tie = (digits + 0.5) / static_cast<double>(detail::Power10(Precision));
+    const auto any = std::ldexp(static_cast<double>(random() >> 11), -static_cast<int>(random() % 96));
+    if (!matches<Precision>(tie) || !matches<Precision>(-tie) || !matches<Precision>(any)) {
+      return;
+    }
+  }
+}
+
+}  // namespace
+
+TEST("format/decimal_matches_fmt/precision:0", decimal_matches_fmt<0>);
+TEST("format/decimal_matches_fmt/precision:1", decimal_matches_fmt<1>);
+TEST("format/decimal_matches_fmt/precision:2", decimal_matches_fmt<2>);
+TEST("format/decimal_matches_fmt/precision:3", decimal_matches_fmt<3>);
+TEST("format/decimal_matches_fmt/precision:6", decimal_matches_fmt<6>);
+TEST("format/decimal_matches_fmt/precision:9", decimal_matches_fmt<9>);
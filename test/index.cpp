@@ -0,0 +1,141 @@
+#include "test.hpp"
+#include <index.hpp>
+#include <text.hpp>
+#include <fmt/format.h>
+#include <fmt/xchar.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+constexpr std::size_t rows = 3'000;
+
+std::u16string fold(std::wstring_view text) {
+  std::u16string folded;
+  for (const auto c : text) {
+    folded.push_back(static_cast<char16_t>(FoldCase(c)));
+  }
+  return folded;
+}
+
+// Finds rows like Index::Find with a linear scan over the rows in sort order.
+class reference {
+public:
+  explicit reference(const std::vector<std::wstring>& texts) : texts_(texts.size()), order_(texts.size()) {
+    std::transform(texts.begin(), texts.end(), texts_.begin(), fold);
+    std::iota(order_.begin(), order_.end(), 0);
+    std::stable_sort(order_.begin(), order_.end(), [&](int lhs, int rhs) { return texts_[lhs] < texts_[rhs]; });
+  }
+
+  int find(std::wstring_view prefix, int start, int previous, bool wrap) const {
+    const auto value = fold(prefix);
+    const auto matches = [&](int row) {
+      return row >= 0 && static_cast<std::size_t>(row) < texts_.size() && texts_[row].starts_with(value);
+    };
+    const auto first = std::find_if(order_.begin(), order_.end(), matches);
+    if (matches(start)) {
+      return start;
+    }
+    if (matches(previous)) {
+      const auto it = std::find_if(std::find(order_.begin(), order_.end(), previous) + 1, order_.end(), matches);
+      if (it != order_.end()) {
+        return *it;
+      }
+      return wrap && first != order_.end() ? *first : -1;
+    }
+    return first != order_.end() ? *first : -1;
+  }
+
+private:
+  std::vector<std::u16string> texts_;
+  std::vector<int> order_;
+};
+
+// Returns a text with shared prefixes, letters of both cases and text after the first 8 and 24 characters.
+std::wstring text(std::mt19937_64& random, std::size_t max) {
+  constexpr wchar_t letters[] = { L'a', L'B', L'b', L'\xE4', L'\xC4', L' ', L'z' };
+  std::wstring text;
+  const auto size = random() % (max + 1);
+  for (std::size_t i = 0; i < size; i++) {
+    text.push_back(letters[random() % std::size(letters)]);
+  }
+  return text;
+}
+
+// Compares lookups of random prefixes, start rows and previous rows with the reference,
+// for an index built from runs of different sizes.
+void find_matches_linear_scan() {
+  std::mt19937_64 random{ 5 };
+  std::vector<std::wstring> texts(rows);
+  for (auto& value : texts) {
+    value = random() % 4 ? text(random, 4) : text(random, 30);
+  }
+  const auto format = [&](fmt::wmemory_buffer& buffer, std::size_t row) {
+    buffer.append(texts[row]);
+  };
+  const reference reference{ texts };
+  for (const std::size_t size : { std::size_t(1), std::size_t(97), rows }) {
+    Index index;
+    for (std::size_t begin = 0; begin < rows; begin += size) {
+      index.Add(Index::Sort(begin, std::min(rows, begin + size), format), format);
+    }
+    CHECK(index.Rows() == rows);
+    for (std::size_t i = 0; i < 2'000; i++) {
+      auto prefix = i % 2 ? texts[random() % rows].substr(0, random() % 12 + 1) : text(random, 10) + L"a";
+      if (prefix.empty()) {
+        prefix = L"a";
+      }
+      const auto start = static_cast<int>(random() % (rows + 2)) - 1;
+      const auto previous = random() % 2 ? start - 1 : static_cast<int>(random() % rows);
+      const auto wrap = random() % 2 != 0;
+      if (!CHECK(index.Find(prefix, start, previous, wrap, format) == reference.find(prefix, start, previous, wrap))) {
+        return;
+      }
+    }
+  }
+}
+
+// Repeated lookups from the previous match visit every match once in sort order and then wrap.
+void find_cycles_through_matches() {
+  std::mt19937_64 random{ 6 };
+  std::vector<std::wstring> texts(rows);
+  for (auto& value : texts) {
+    value = text(random, 12);
+  }
+  const auto format = [&](fmt::wmemory_buffer& buffer, std::size_t row) {
+    buffer.append(texts[row]);
+  };
+  Index index;
+  for (std::size_t begin = 0; begin < rows; begin += 500) {
+    index.Add(Index::Sort(begin, begin + 500, format), format);
+  }
+  const reference reference{ texts };
+  for (const std::wstring_view prefix : { L"a", L"\xC4" L"b", L"bb", L"z a" }) {
+    const auto matches = static_cast<std::size_t>(std::count_if(texts.begin(), texts.end(), [&](const std::wstring& value) {
+      return fold(value).starts_with(fold(prefix));
+    }));
+    CHECK(matches > 1);
+    const auto first = index.Find(prefix, -1, -1, false, format);
+    auto row = first;
+    for (std::size_t i = 1; i < matches; i++) {
+      const auto next = index.Find(prefix, -1, row, true, format);
+      if (!CHECK(next == reference.find(prefix, -1, row, true)) || !CHECK(next != first)) {
+        return;
+      }
+      row = next;
+    }
+    CHECK(index.Find(prefix, -1, row, true, format) == first);
+    CHECK(index.Find(prefix, -1, row, false, format) == -1);
+  }
+}
+
+}  // namespace
+
+TEST("index/find_matches_linear_scan", find_matches_linear_scan);
+TEST("index/find_cycles_through_matches", find_cycles_through_matches);
@@ -0,0 +1,188 @@
+#include "test.hpp"
+#include <ice/io_context.hpp>
+#include <ice/task.hpp>
+#include <ice/when_all.hpp>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <latch>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <unistd.h>
+
+namespace {
+
+// Returns the byte at a position of the test file.
+char pattern(std::uint64_t position) noexcept {
+  return static_cast<char>(((position ^ (position >> 13)) * 0x9E3779B97F4A7C15ULL) >> 56);
+}
+
+bool matches(const std::vector<char>& data, std::uint64_t offset, std::size_t size) noexcept {
+  for (std::size_t i = 0; i < size; i++) {
+    if (data[i] != pattern(offset + i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Temporary file with a known pattern, which is removed when it is closed.
+class file {
+public:
+  constexpr static std::size_t size = std::size_t(64) << 20;
+
+  file() {
+    auto path = (std::filesystem::temp_directory_path() / "carta-test-XXXXXX").string();
+    handle_ = mkstemp(path.data());
+    if (!CHECK(handle_ >= 0)) {
+      return;
+    }
+    unlink(path.c_str());
+    std::vector<char> data(size);
+    for (std::size_t i = 0; i < size; i++) {
+      data[i] = pattern(i);
+    }
+    CHECK(::write(handle_, data.data(), size) == static_cast<ssize_t>(size));
+  }
+
+  file(file&& other) = delete;
+  file(const file& other) = delete;
+  file& operator=(file&& other) = delete;
+  file& operator=(const file& other) = delete;
+
+  ~file() {
+    if (handle_ >= 0) {
+      ::close(handle_);
+    }
+  }
+
+  int handle() const noexcept {
+    return handle_;
+  }
+
+private:
+  int handle_ = -1;
+};
+
+using test_function = ice::task<void> (*)(ice::io_context& context, int file);
+
+ice::task<void> start(ice::io_context& context, int file, test_function function, std::latch& done) {
+  co_await function(context, file);
+  done.count_down();
+}
+
+// Runs a test against io_uring with a small completion queue, or against the pool when fallback is true.
+void run(bool fallback, test_function function) {
+  static const file file;
+  ice::io_context context{ fallback ? 0u : 8u, 4 };
+  if (fallback) {
+    CHECK(context.is_fallback());
+  }
+  std::thread thread{ [&]() { context.run(); } };
+  std::latch done{ 1 };
+  start(context, file.handle(), function, done).detach();
+  done.wait();
+  context.stop();
+  thread.join();
+}
+
+ice::task<void> read(ice::io_context& context, int file, std::uint64_t offset, std::size_t size, std::atomic_int& failures) {
+  std::vector<char> data(size);
+  const auto result = co_await context.read_at(file, offset, data.data(), size);
+  const auto expected = offset < file::size ? std::min<std::uint64_t>(size, file::size - offset) : 0;
+  if (!result || result.size != expected || !matches(data, offset, result.size)) {
+    failures++;
+  }
+}
+
+// Reads the file in blocks that are all in flight at once, more than fit into the completion queue.
+ice::task<void> reads_sequentially(ice::io_context& context, int file) {
+  constexpr std::size_t block = 1 << 20;
+  std::atomic_int failures = 0;
+  std::vector<ice::task<void>> reads;
+  for (std::size_t offset = 0; offset < file::size; offset += block) {
+    reads.push_back(read(context, file, offset, block, failures));
+  }
+  co_await ice::when_all(reads);
+  CHECK(failures.load() == 0);
+}
+
+// Reads blocks of random sizes at random offsets, some of which end past the end of the file.
+ice::task<void> reads_randomly(ice::io_context& context, int file) {
+  std::mt19937_64 random{ 0 };
+  std::atomic_int failures = 0;
+  std::vector<ice::task<void>> reads;
+  for (std::size_t i = 0; i < 2048; i++) {
+    const auto offset = random() % file::size;
+    const auto size = static_cast<std::size_t>(random() % (1 << 16) + 1);
+    reads.push_back(read(context, file, offset, size, failures));
+  }
+  co_await ice::when_all(reads);
+  CHECK(failures.load() == 0);
+}
+
+ice::task<void> reads_whole_file(ice::io_context& context, int file) {
+  std::atomic_int failures = 0;
+  co_await read(context, file, 0, file::size, failures);
+  CHECK(failures.load() == 0);
+}
+
+// A read that reaches the end of the file returns the bytes up to it.
+ice::task<void> stops_at_end_of_file(ice::io_context& context, int file) {
+  std::atomic_int failures = 0;
+  co_await read(context, file, file::size - 100, 4096, failures);
+  co_await read(context, file, file::size, 4096, failures);
+  CHECK(failures.load() == 0);
+}
+
+ice::task<void> reports_errors(ice::io_context& context, int) {
+  char data[16];
+  const auto result = co_await context.read_at(-1, 0, data, sizeof(data));
+  CHECK(!result);
+  CHECK(result.error == std::error_code(EBADF, std::system_category()));
+}
+
+ice::task<void> writes_and_reads_back(ice::io_context& context, int) {
+  auto path = (std::filesystem::temp_directory_path() / "carta-test-XXXXXX").string();
+  const auto file = mkstemp(path.data());
+  if (!CHECK(file >= 0)) {
+    co_return;
+  }
+  unlink(path.c_str());
+  std::vector<char> data(1 << 20);
+  for (std::size_t i = 0; i < data.size(); i++) {
+    data[i] = pattern(i + 4096);
+  }
+  const auto written = co_await context.write_at(file, 4096, data.data(), data.size());
+  CHECK(written && written.size == data.size());
+  std::vector<char> copy(data.size());
+  const auto read = co_await context.read_at(file, 4096, copy.data(), copy.size());
+  CHECK(read && read.size == copy.size() && matches(copy, 4096, copy.size()));
+  ::close(file);
+}
+
+}  // namespace
+
+TEST("io_context/ring/reads_sequentially", []() { run(false, reads_sequentially); });
+TEST("io_context/ring/reads_randomly", []() { run(false, reads_randomly); });
+TEST("io_context/ring/reads_whole_file", []() { run(false, reads_whole_file); });
+TEST("io_context/ring/stops_at_end_of_file", []() { run(false, stops_at_end_of_file); });
+TEST("io_context/ring/reports_errors", []() { run(false, reports_errors); });
+TEST("io_context/ring/writes_and_reads_back", []() { run(false, writes_and_reads_back); });
+TEST("io_context/pool/reads_sequentially", []() { run(true, reads_sequentially); });
+TEST("io_context/pool/reads_randomly", []() { run(true, reads_randomly); });
+TEST("io_context/pool/reads_whole_file", []() { run(true, reads_whole_file); });
+TEST("io_context/pool/stops_at_end_of_file", []() { run(true, stops_at_end_of_file); });
+TEST("io_context/pool/reports_errors", []() { run(true, reports_errors); });
+TEST("io_context/pool/writes_and_reads_back", []() { run(true, writes_and_reads_back); });
+
+#endif
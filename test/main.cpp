@@ -0,0 +1,54 @@
+#include "test.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+#include <cstdlib>
+
+// Runs the registered tests whose names contain any of the filters, or all tests without filters.
+//
+// carta-test [--list] [filter...]
+//
+// Prints one line per test and fails if any check failed.
+
+int main(int argc, char* argv[]) {
+  auto list = false;
+  std::vector<std::string_view> filters;
+  for (int i = 1; i < argc; i++) {
+    const std::string_view arg{ argv[i] };
+    if (arg == "--list") {
+      list = true;
+    } else if (arg.starts_with("--")) {
+      std::fputs("usage: carta-test [--list] [filter...]\n", stderr);
+      return EXIT_FAILURE;
+    } else {
+      filters.push_back(arg);
+    }
+  }
+
+  auto units = test::registry();
+  std::stable_sort(units.begin(), units.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.name < rhs.name;
+  });
+
+  std::size_t failed = 0;
+  for (const auto& unit : units) {
+    const auto selected = filters.empty() || std::any_of(filters.begin(), filters.end(), [&](std::string_view filter) {
+      return unit.name.find(filter) != std::string::npos;
+    });
+    if (!selected) {
+      continue;
+    }
+    if (list) {
+      std::printf("%s\n", unit.name.data());
+      continue;
+    }
+    const auto failures = test::failures().load();
+    unit.function();
+    const auto passed = test::failures().load() == failures;
+    failed += !passed;
+    std::printf("%-48s %s\n", unit.name.data(), passed ? "ok" : "FAILED");
+    std::fflush(stdout);
+  }
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
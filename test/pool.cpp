@@ -0,0 +1,214 @@
+#include "test.hpp"
+#include <ice/pool.hpp>
+#include <ice/task.hpp>
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+ice::task<void> count(ice::pool& pool, std::atomic_int& counter, std::latch& done) {
+  co_await pool.schedule(true);
+  counter.fetch_add(1, std::memory_order_relaxed);
+  done.count_down();
+}
+
+// Posts tasks from a worker, where they go to its deque.
+ice::task<void> spawn(ice::pool& pool, std::vector<std::atomic_int>& counters, std::size_t begin, std::size_t end, std::latch& done) {
+  co_await pool.schedule(true);
+  for (auto i = begin; i < end; i++) {
+    count(pool, counters[i], done).detach();
+  }
+}
+
+// Posts half of the tasks from a worker and half from outside of the pool.
+void runs_every_task_once() {
+  constexpr std::size_t size = 100'000;
+  std::vector<std::atomic_int> counters(size);
+  std::latch done{ static_cast<std::ptrdiff_t>(size) };
+  {
+    ice::pool pool{ 4 };
+    spawn(pool, counters, 0, size / 2, done).detach();
+    for (auto i = size / 2; i < size; i++) {
+      count(pool, counters[i], done).detach();
+    }
+    done.wait();
+  }
+  for (std::size_t i = 0; i < size; i++) {
+    if (!CHECK(counters[i].load() == 1)) {
+      break;
+    }
+  }
+}
+
+ice::task<void> child(ice::pool& pool, std::thread::id parent, std::atomic_int& stolen, std::latch& done) {
+  co_await pool.schedule(true);
+  if (std::this_thread::get_id() != parent) {
+    stolen.fetch_add(1, std::memory_order_relaxed);
+  }
+  done.count_down();
+}
+
+// Posts children to the deque of a worker and blocks that worker until they ran.
+ice::task<void> parent(ice::pool& pool, std::atomic_int& stolen, std::latch& done, std::size_t children) {
+  co_await pool.schedule(true);
+  std::latch finished{ static_cast<std::ptrdiff_t>(children) };
+  for (std::size_t i = 0; i < children; i++) {
+    child(pool, std::this_thread::get_id(), stolen, finished).detach();
+  }
+  finished.wait();
+  done.count_down();
+}
+
+// Every child must be stolen by another worker, because its owner is blocked.
+void steals_from_busy_workers() {
+  constexpr std::size_t children = 1'000;
+  std::atomic_int stolen = 0;
+  std::latch done{ 1 };
+  ice::pool pool{ 4 };
+  parent(pool, stolen, done, children).detach();
+  done.wait();
+  CHECK(stolen.load() == static_cast<int>(children));
+}
+
+ice::task<void> tree(ice::pool& pool, std::atomic_int& counter, int depth) {
+  co_await pool.schedule(true);
+  counter.fetch_add(1, std::memory_order_relaxed);
+  if (depth > 0) {
+    tree(pool, counter, depth - 1).detach();
+    tree(pool, counter, depth - 1).detach();
+  }
+}
+
+// Destroying a pool runs the work that is still queued, including work that the queued work posts.
+void drains_work_on_shutdown() {
+  std::atomic_int counter = 0;
+  {
+    ice::pool pool{ 4 };
+    tree(pool, counter, 12).detach();
+  }
+  CHECK(counter.load() == (1 << 13) - 1);
+}
+
+// Destroying an idle or stopped pool wakes and joins all workers.
+void stops_when_idle() {
+  for (int i = 0; i < 100; i++) {
+    ice::pool pool{ 4 };
+  }
+  ice::pool pool{ 2 };
+  std::this_thread::sleep_for(10ms);
+  pool.stop();
+}
+
+// Order in which schedules of each priority ran.
+class recorder {
+public:
+  void add(ice::priority priority) noexcept {
+    std::lock_guard lock{ mutex_ };
+    order_.push_back(priority);
+  }
+
+  // Checks that interactive work ran first and that bulk work took at most one in starvation_limit turns
+  // of higher priority work, starting at the given index.
+  void check(std::size_t begin) noexcept {
+    std::lock_guard lock{ mutex_ };
+    std::size_t last = begin;
+    std::size_t higher = 0;
+    auto normal = false;
+    for (auto i = begin; i < order_.size(); i++) {
+      if (order_[i] != ice::priority::bulk) {
+        last = i + 1;
+        higher++;
+      }
+      if (order_[i] == ice::priority::normal) {
+        normal = true;
+      }
+      CHECK(!(normal && order_[i] == ice::priority::interactive));
+    }
+    const auto bulk = last - begin - higher;
+    CHECK(bulk <= higher / ice::pool::starvation_limit + 1);
+  }
+
+  std::size_t size() noexcept {
+    std::lock_guard lock{ mutex_ };
+    return order_.size();
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<ice::priority> order_;
+};
+
+ice::task<void> record(ice::pool& pool, ice::priority priority, recorder& recorder, std::latch& done) {
+  co_await pool.schedule(priority, true);
+  recorder.add(priority);
+  done.count_down();
+}
+
+// Posts bulk work first, then normal and interactive work.
+void post(ice::pool& pool, recorder& recorder, std::latch& done, std::size_t bulk, std::size_t normal, std::size_t interactive) {
+  for (std::size_t i = 0; i < bulk; i++) {
+    record(pool, ice::priority::bulk, recorder, done).detach();
+  }
+  for (std::size_t i = 0; i < normal; i++) {
+    record(pool, ice::priority::normal, recorder, done).detach();
+  }
+  for (std::size_t i = 0; i < interactive; i++) {
+    record(pool, ice::priority::interactive, recorder, done).detach();
+  }
+}
+
+ice::task<void> post_from_worker(ice::pool& pool, recorder& recorder, std::latch& done) {
+  co_await pool.schedule(true);
+  post(pool, recorder, done, 500, 200, 100);
+}
+
+// Work posted from a worker goes to its deques, which are taken in priority order.
+void orders_local_work() {
+  recorder recorder;
+  std::latch done{ 800 };
+  ice::pool pool{ 1 };
+  post_from_worker(pool, recorder, done).detach();
+  done.wait();
+  recorder.check(0);
+}
+
+ice::task<void> trigger(ice::pool& pool, recorder& recorder, std::latch& done, std::atomic_bool& triggered, std::size_t& begin) {
+  co_await pool.schedule(ice::priority::bulk, true);
+  recorder.add(ice::priority::bulk);
+  if (!triggered.exchange(true)) {
+    begin = recorder.size();
+    std::thread([&]() { post(pool, recorder, done, 0, 200, 100); }).join();
+  }
+  done.count_down();
+}
+
+// Normal and interactive work posted from outside of the pool is not delayed by the rest of
+// a bulk lane that a worker already took.
+void orders_shared_work() {
+  constexpr std::size_t bulk = 500;
+  recorder recorder;
+  std::latch done{ bulk + 300 };
+  std::atomic_bool triggered = false;
+  std::size_t begin = 0;
+  ice::pool pool{ 1 };
+  for (std::size_t i = 0; i < bulk; i++) {
+    trigger(pool, recorder, done, triggered, begin).detach();
+  }
+  done.wait();
+  recorder.check(begin);
+}
+
+TEST("pool/runs_every_task_once", runs_every_task_once);
+TEST("pool/steals_from_busy_workers", steals_from_busy_workers);
+TEST("pool/drains_work_on_shutdown", drains_work_on_shutdown);
+TEST("pool/stops_when_idle", stops_when_idle);
+TEST("pool/orders_local_work", orders_local_work);
+TEST("pool/orders_shared_work", orders_shared_work);
+
+}  // namespace
@@ -0,0 +1,92 @@
+#include "test.hpp"
+#include <ice/context.hpp>
+#include <ice/pool.hpp>
+#include <ice/scheduler.hpp>
+#include <ice/task.hpp>
+#include <atomic>
+#include <latch>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+namespace {
+
+ice::task<void> append(ice::batch<ice::context>& batch, std::vector<std::size_t>& order, std::size_t index) {
+  co_await batch.schedule();
+  order.push_back(index);
+}
+
+// Schedules wait until the batch is posted and run in the order they were added.
+void posts_batch_in_order() {
+  constexpr std::size_t size = 100;
+  ice::context context;
+  std::vector<std::size_t> order;
+  std::vector<ice::task<void>> tasks;
+  ice::batch batch{ context };
+  for (std::size_t i = 0; i < size; i++) {
+    tasks.push_back(append(batch, order, i));
+  }
+  CHECK(batch.size() == size);
+  context.stop();
+  context.run();
+  CHECK(order.empty());
+  batch.post();
+  CHECK(batch.size() == 0);
+  context.run();
+  CHECK(order.size() == size);
+  for (std::size_t i = 0; i < order.size(); i++) {
+    CHECK(order[i] == i);
+  }
+  for (const auto& task : tasks) {
+    CHECK(task.is_ready());
+  }
+}
+
+// A batch posts the schedules that are left when it is destroyed.
+void posts_batch_on_destruction() {
+  ice::context context;
+  std::vector<std::size_t> order;
+  std::vector<ice::task<void>> tasks;
+  {
+    ice::batch batch{ context };
+    tasks.push_back(append(batch, order, 0));
+    tasks.push_back(append(batch, order, 1));
+  }
+  context.stop();
+  context.run();
+  CHECK(order.size() == 2);
+}
+
+ice::task<void> count(ice::batch<ice::pool>& batch, ice::pool& pool, std::atomic_int& counter, std::latch& done) {
+  co_await batch.schedule();
+  if (pool.is_current()) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
+  done.count_down();
+}
+
+// Every schedule of batches of each priority runs once on the pool.
+void posts_batches_to_pool() {
+  constexpr std::size_t size = 1'000;
+  for (const auto priority : { ice::priority::interactive, ice::priority::normal, ice::priority::bulk }) {
+    std::atomic_int counter = 0;
+    std::latch done{ static_cast<std::ptrdiff_t>(size) };
+    ice::pool pool{ 4 };
+    ice::batch batch{ pool, priority };
+    for (std::size_t i = 0; i < size; i++) {
+      count(batch, pool, counter, done).detach();
+      if (batch.size() == 64) {
+        batch.post();
+      }
+    }
+    batch.post();
+    done.wait();
+    CHECK(counter.load() == static_cast<int>(size));
+  }
+}
+
+}  // namespace
+
+TEST("scheduler/posts_batch_in_order", posts_batch_in_order);
+TEST("scheduler/posts_batch_on_destruction", posts_batch_on_destruction);
+TEST("scheduler/posts_batches_to_pool", posts_batches_to_pool);
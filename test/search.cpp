@@ -0,0 +1,148 @@
+#include "test.hpp"
+#include <search.hpp>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+constexpr std::string_view reserved = "\n\r\",";
+
+char fold(char c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c;
+}
+
+// Finds a pattern ignoring the case of ASCII letters by comparing at every position.
+std::size_t scan(std::string_view text, std::string_view pattern, std::size_t pos) {
+  for (; pos + pattern.size() <= text.size(); pos++) {
+    if (std::equal(pattern.begin(), pattern.end(), text.begin() + static_cast<std::ptrdiff_t>(pos), [](char lhs, char rhs) { return fold(lhs) == fold(rhs); })) {
+      return pos;
+    }
+  }
+  return Needle::npos;
+}
+
+// Returns text with letters of both cases, characters next to letters in ASCII and bytes that are not ASCII.
+std::string text(std::mt19937_64& random, std::size_t size) {
+  constexpr char characters[] = { 'a', 'b', 'A', 'B', 'z', 'Z', '@', '[', '`', '{', ' ', '\xC3', '\xA1', '\xE1', '\xC1' };
+  std::string text(size, ' ');
+  for (auto& c : text) {
+    c = characters[random() % std::size(characters)];
+  }
+  return text;
+}
+
+// Compares the needle with the reference for patterns of every length up to 20 at every start position.
+void needle_matches_linear_search() {
+  std::mt19937_64 random{ 9 };
+  for (std::size_t i = 0; i < 2'000; i++) {
+    const auto haystack = text(random, random() % 300);
+    auto pattern = text(random, random() % 20 + 1);
+    for (auto& c : pattern) {
+      if (static_cast<unsigned char>(c) >= 0x80) {
+        c = 'b';
+      }
+    }
+    if (i % 2 && haystack.size() > pattern.size()) {
+      pattern = haystack.substr(random() % (haystack.size() - pattern.size()), pattern.size());
+      std::replace_if(pattern.begin(), pattern.end(), [](char c) { return static_cast<unsigned char>(c) >= 0x80; }, 'a');
+    }
+    Needle needle;
+    if (!CHECK(Needle::Create(std::wstring(pattern.begin(), pattern.end()), reserved, needle))) {
+      return;
+    }
+    std::string folded(pattern.size(), ' ');
+    std::transform(pattern.begin(), pattern.end(), folded.begin(), fold);
+    for (std::size_t pos = 0; pos <= haystack.size(); pos++) {
+      if (!CHECK(needle.Find(haystack, pos) == scan(haystack, folded, pos))) {
+        return;
+      }
+    }
+  }
+}
+
+// Needles are not created from empty text, reserved characters or characters that are not ASCII.
+void needle_rejects_text() {
+  Needle needle;
+  CHECK(!Needle::Create(L"", reserved, needle));
+  CHECK(!Needle::Create(L"a,b", reserved, needle));
+  CHECK(!Needle::Create(L"a\nb", reserved, needle));
+  CHECK(!Needle::Create(L"\xE4", reserved, needle));
+  CHECK(Needle::Create(L"aB", reserved, needle));
+  CHECK(needle.Size() == 2);
+}
+
+// Lines of a file in one buffer and the rows that slice them.
+struct lines {
+  std::string data;
+  std::vector<std::string_view> rows;
+
+  explicit lines(std::mt19937_64& random) {
+    std::vector<std::size_t> offsets;
+    for (std::size_t row = 0; row < 10'000; row++) {
+      offsets.push_back(data.size());
+      data += text(random, random() % 40);
+      data += random() % 2 ? "\n" : "\r\n";
+    }
+    offsets.push_back(data.size());
+    for (std::size_t row = 0; row + 1 < offsets.size(); row++) {
+      auto line = std::string_view{ data }.substr(offsets[row], offsets[row + 1] - offsets[row] - 1);
+      if (line.ends_with('\r')) {
+        line.remove_suffix(1);
+      }
+      rows.push_back(line);
+    }
+  }
+};
+
+// Searches blocks of consecutive rows in one pass and scattered rows one at a time.
+void search_rows_matches_linear_search() {
+  std::mt19937_64 random{ 10 };
+  const lines lines{ random };
+  for (const std::wstring_view pattern : { L"a", L"ab", L"zA", L"b@", L"aaa", L"{ba", L"bzab" }) {
+    Needle needle;
+    if (!CHECK(Needle::Create(pattern, reserved, needle))) {
+      return;
+    }
+    const std::string folded(pattern.begin(), pattern.end());
+    const auto kernel = SearchRows(needle, [&](std::size_t row) { return lines.rows[row]; });
+    for (const auto contiguous : { true, false }) {
+      for (std::size_t begin = 0; begin < lines.rows.size();) {
+        const auto size = std::min<std::size_t>(random() % 700 + 1, lines.rows.size() - begin);
+        std::vector<std::uint32_t> rows(size);
+        if (contiguous) {
+          std::iota(rows.begin(), rows.end(), static_cast<std::uint32_t>(begin));
+        } else {
+          for (auto& row : rows) {
+            row = static_cast<std::uint32_t>(random() % lines.rows.size());
+          }
+        }
+        std::vector<std::uint32_t> positions(size);
+        std::iota(positions.begin(), positions.end(), 0u);
+        std::vector<std::uint32_t> expected;
+        for (std::uint32_t i = 0; i < size; i++) {
+          if (scan(lines.rows[rows[i]], folded, 0) != Needle::npos) {
+            expected.push_back(i);
+          }
+        }
+        const auto count = kernel(rows.data(), positions.data(), size, contiguous);
+        positions.resize(count);
+        if (!CHECK(positions == expected)) {
+          return;
+        }
+        begin += size;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST("search/needle_matches_linear_search", needle_matches_linear_search);
+TEST("search/needle_rejects_text", needle_rejects_text);
+TEST("search/search_rows_matches_linear_search", search_rows_matches_linear_search);
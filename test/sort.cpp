@@ -0,0 +1,135 @@
+#include "test.hpp"
+#include <sort.hpp>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+constexpr std::size_t rows = 40'000;
+constexpr std::size_t jobs[] = { 1, 2, 3, 4, 7 };
+
+// Runs the jobs of every step in reverse order, which must not matter.
+Permutation sort(Sorter& sorter) {
+  do {
+    for (auto job = sorter.Jobs(); job > 0; job--) {
+      sorter.Run(job - 1);
+    }
+  } while (sorter.Next());
+  CHECK(sorter.Progress() == 100);
+  return sorter.Result();
+}
+
+// Returns the rows in the order of a stable sort by key.
+template <typename Key>
+std::vector<std::uint32_t> reference(const std::vector<Key>& keys, bool descending) {
+  std::vector<std::uint32_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0u);
+  std::stable_sort(order.begin(), order.end(), [&](std::uint32_t lhs, std::uint32_t rhs) {
+    return descending ? keys[rhs] < keys[lhs] : keys[lhs] < keys[rhs];
+  });
+  return order;
+}
+
+bool matches(const Permutation& permutation, const std::vector<std::uint32_t>& order) {
+  if (!CHECK(permutation.Size() == order.size())) {
+    return false;
+  }
+  for (std::size_t i = 0; i < order.size(); i++) {
+    const auto position = static_cast<int>(i);
+    if (!CHECK(permutation.Row(position) == static_cast<int>(order[i])) || !CHECK(permutation.Position(permutation.Row(position)) == position)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Sorts integers with few distinct values, so that the order of equal keys is checked, and with the full range.
+void integers_match_stable_sort() {
+  std::mt19937_64 random{ 1 };
+  for (const auto distinct : { std::uint64_t(16), std::uint64_t(0) }) {
+    std::vector<std::int64_t> values(rows);
+    for (auto& value : values) {
+      value = static_cast<std::int64_t>(distinct ? random() % distinct : random()) - static_cast<std::int64_t>(distinct / 2);
+    }
+    for (const auto descending : { false, true }) {
+      const auto order = reference(values, descending);
+      for (const auto count : jobs) {
+        Sorter sorter;
+        sorter.Integers(rows, count, descending, [&](std::size_t row) { return Sorter::Key(values[row]); });
+        if (!matches(sort(sorter), order)) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+// Sorts doubles of different signs and magnitudes, including both zeros.
+void doubles_match_stable_sort() {
+  std::mt19937_64 random{ 2 };
+  std::vector<double> values(rows);
+  for (auto& value : values) {
+    value = std::ldexp(static_cast<double>(random() % 2001) - 1000.0, static_cast<int>(random() % 64) - 32);
+  }
+  values[0] = 0.0;
+  values[1] = -0.0;
+  for (const auto descending : { false, true }) {
+    // Both zeros have different keys, so the reference compares the keys.
+    std::vector<std::uint64_t> keys(rows);
+    std::transform(values.begin(), values.end(), keys.begin(), [](double value) { return Sorter::Key(value); });
+    const auto order = reference(keys, descending);
+    for (const auto count : jobs) {
+      Sorter sorter;
+      sorter.Integers(rows, count, descending, [&](std::size_t row) { return Sorter::Key(values[row]); });
+      if (!matches(sort(sorter), order)) {
+        return;
+      }
+    }
+  }
+}
+
+// Sorts texts with shared prefixes and duplicates.
+void strings_match_stable_sort() {
+  std::mt19937_64 random{ 3 };
+  std::vector<std::string> texts(rows);
+  for (auto& text : texts) {
+    const auto size = random() % 6;
+    for (std::size_t i = 0; i < size; i++) {
+      text.push_back(static_cast<char>('a' + random() % 3));
+    }
+  }
+  std::vector<std::string_view> keys(texts.begin(), texts.end());
+  for (const auto descending : { false, true }) {
+    const auto order = reference(keys, descending);
+    for (const auto count : jobs) {
+      Sorter sorter;
+      sorter.Strings(rows, count, descending, [&](std::size_t row) { return keys[row]; });
+      if (!matches(sort(sorter), order)) {
+        return;
+      }
+    }
+  }
+}
+
+// An empty table and a single row are sorted without any steps.
+void sorts_small_tables() {
+  for (const std::size_t size : { 0, 1 }) {
+    Sorter sorter;
+    sorter.Integers(size, 4, false, [](std::size_t) { return std::uint64_t(0); });
+    CHECK(sort(sorter).Size() == size);
+  }
+}
+
+}  // namespace
+
+TEST("sort/integers_match_stable_sort", integers_match_stable_sort);
+TEST("sort/doubles_match_stable_sort", doubles_match_stable_sort);
+TEST("sort/strings_match_stable_sort", strings_match_stable_sort);
+TEST("sort/sorts_small_tables", sorts_small_tables);
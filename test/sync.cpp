@@ -0,0 +1,200 @@
+#include "test.hpp"
+#include <ice/pool.hpp>
+#include <ice/sync.hpp>
+#include <ice/task.hpp>
+#include <array>
+#include <atomic>
+#include <latch>
+#include <vector>
+#include <cstddef>
+
+namespace {
+
+constexpr std::size_t tasks = 16;
+constexpr std::size_t iterations = 5'000;
+
+// Tracks how many tasks are inside of a section at the same time.
+struct section {
+  std::atomic_int inside = 0;
+  std::atomic_int most = 0;
+
+  void enter() noexcept {
+    const auto count = inside.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto most = this->most.load(std::memory_order_relaxed);
+    while (count > most && !this->most.compare_exchange_weak(most, count, std::memory_order_relaxed)) {
+    }
+  }
+
+  void leave() noexcept {
+    inside.fetch_sub(1, std::memory_order_relaxed);
+  }
+};
+
+// Alternates between locks that resume on the unlocking thread and locks that resume on the pool.
+ice::task<void> increment(ice::pool& pool, ice::async_mutex& mutex, section& section, std::size_t& counter, std::latch& done) {
+  co_await pool.schedule(true);
+  for (std::size_t i = 0; i < iterations; i++) {
+    if (i % 2) {
+      co_await mutex.lock();
+      section.enter();
+      counter++;
+      section.leave();
+      mutex.unlock();
+    } else {
+      const auto lock = co_await mutex.scoped_lock(pool);
+      section.enter();
+      counter++;
+      section.leave();
+    }
+  }
+  done.count_down();
+}
+
+// Only one task holds the mutex, and the increments of a plain counter under it are not lost.
+void mutex_excludes_others() {
+  ice::async_mutex mutex;
+  section section;
+  std::size_t counter = 0;
+  std::latch done{ tasks };
+  {
+    ice::pool pool{ 4 };
+    for (std::size_t i = 0; i < tasks; i++) {
+      increment(pool, mutex, section, counter, done).detach();
+    }
+    done.wait();
+  }
+  CHECK(section.most.load() == 1);
+  CHECK(counter == tasks * iterations);
+}
+
+ice::task<void> append(ice::async_mutex& mutex, std::vector<int>& order, int value) {
+  const auto lock = co_await mutex.scoped_lock();
+  order.push_back(value);
+}
+
+// The mutex is handed to the awaiters in the order in which they were queued.
+void mutex_is_fifo() {
+  ice::async_mutex mutex;
+  std::vector<int> order;
+  CHECK(mutex.try_lock());
+  std::array<ice::task<void>, 4> awaiters{ append(mutex, order, 0), append(mutex, order, 1), append(mutex, order, 2), append(mutex, order, 3) };
+  CHECK(order.empty());
+  mutex.unlock();
+  CHECK((order == std::vector<int>{ 0, 1, 2, 3 }));
+  CHECK(mutex.try_lock());
+  mutex.unlock();
+}
+
+ice::task<void> acquire(ice::pool& pool, ice::async_semaphore& semaphore, section& section, std::latch& done) {
+  co_await pool.schedule(true);
+  for (std::size_t i = 0; i < iterations; i++) {
+    co_await semaphore.acquire(pool);
+    section.enter();
+    section.leave();
+    semaphore.release();
+  }
+  done.count_down();
+}
+
+// No more tasks than the semaphore was created with hold it at the same time.
+void semaphore_limits_holders() {
+  constexpr std::ptrdiff_t limit = 3;
+  ice::async_semaphore semaphore{ limit };
+  section section;
+  std::latch done{ tasks };
+  {
+    ice::pool pool{ 4 };
+    for (std::size_t i = 0; i < tasks; i++) {
+      acquire(pool, semaphore, section, done).detach();
+    }
+    done.wait();
+  }
+  CHECK(section.most.load() >= 1);
+  CHECK(section.most.load() <= limit);
+  for (std::ptrdiff_t i = 0; i < limit; i++) {
+    CHECK(semaphore.try_acquire());
+  }
+  CHECK(!semaphore.try_acquire());
+}
+
+ice::task<void> acquire(ice::async_semaphore& semaphore, int& acquired) {
+  co_await semaphore.acquire();
+  acquired++;
+}
+
+// Releasing n units resumes n of the queued awaiters and keeps the rest queued.
+void semaphore_release_resumes_waiters() {
+  ice::async_semaphore semaphore{ 0 };
+  auto acquired = 0;
+  std::array<ice::task<void>, 5> awaiters{ acquire(semaphore, acquired), acquire(semaphore, acquired), acquire(semaphore, acquired),
+    acquire(semaphore, acquired), acquire(semaphore, acquired) };
+  CHECK(acquired == 0);
+  semaphore.release(3);
+  CHECK(acquired == 3);
+  CHECK(awaiters[0].is_ready() && awaiters[2].is_ready() && !awaiters[3].is_ready());
+  semaphore.release(4);
+  CHECK(acquired == 5);
+  CHECK(semaphore.try_acquire());
+  CHECK(semaphore.try_acquire());
+  CHECK(!semaphore.try_acquire());
+}
+
+ice::task<void> wait(ice::latch& latch, std::atomic_int& resumed) {
+  co_await latch.wait();
+  resumed.fetch_add(1, std::memory_order_relaxed);
+}
+
+// All awaiters are resumed by the last count down, and later awaiters do not suspend.
+void latch_resumes_all_waiters() {
+  ice::latch latch{ 2 };
+  std::atomic_int resumed = 0;
+  std::array<ice::task<void>, 4> awaiters{ wait(latch, resumed), wait(latch, resumed), wait(latch, resumed), wait(latch, resumed) };
+  latch.count_down();
+  CHECK(resumed.load() == 0);
+  latch.count_down();
+  CHECK(resumed.load() == 4);
+  auto late = wait(latch, resumed);
+  CHECK(late.is_ready());
+  CHECK(resumed.load() == 5);
+}
+
+ice::task<void> wait(ice::pool& pool, ice::latch& latch, std::atomic_int& resumed, std::latch& done) {
+  co_await pool.schedule(true);
+  co_await latch.wait(pool);
+  resumed.fetch_add(1, std::memory_order_relaxed);
+  done.count_down();
+}
+
+ice::task<void> count_down(ice::pool& pool, ice::latch& latch) {
+  co_await pool.schedule(true);
+  latch.count_down();
+}
+
+// Awaiters on the pool are resumed when the latch is counted down by other workers.
+void latch_resumes_waiters_on_pool() {
+  constexpr std::size_t waiters = 64;
+  constexpr std::size_t counts = 8;
+  ice::latch latch{ counts };
+  std::atomic_int resumed = 0;
+  std::latch done{ waiters };
+  {
+    ice::pool pool{ 4 };
+    for (std::size_t i = 0; i < waiters; i++) {
+      wait(pool, latch, resumed, done).detach();
+    }
+    for (std::size_t i = 0; i < counts; i++) {
+      count_down(pool, latch).detach();
+    }
+    done.wait();
+  }
+  CHECK(resumed.load() == static_cast<int>(waiters));
+}
+
+}  // namespace
+
+TEST("sync/mutex_excludes_others", mutex_excludes_others);
+TEST("sync/mutex_is_fifo", mutex_is_fifo);
+TEST("sync/semaphore_limits_holders", semaphore_limits_holders);
+TEST("sync/semaphore_release_resumes_waiters", semaphore_release_resumes_waiters);
+TEST("sync/latch_resumes_all_waiters", latch_resumes_all_waiters);
+TEST("sync/latch_resumes_waiters_on_pool", latch_resumes_waiters_on_pool);
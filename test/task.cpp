@@ -0,0 +1,44 @@
+#include "test.hpp"
+#include <ice/sync.hpp>
+#include <ice/task.hpp>
+#include <vector>
+#include <cstdint>
+
+namespace {
+
+ice::task<std::uint64_t> link(ice::latch& trigger) {
+  co_await trigger.wait();
+  co_return 0;
+}
+
+ice::task<std::uint64_t> link(ice::task<std::uint64_t>& previous) {
+  co_return co_await previous + 1;
+}
+
+ice::task<void> last(ice::task<std::uint64_t>& previous, std::uint64_t& result) {
+  result = co_await previous;
+}
+
+// Completes a chain of a million tasks where each one awaits the previous one.
+// The chain must unwind through final_suspend in constant stack once the trigger is released,
+// which relies on the tail call that optimized builds emit for the symmetric transfer.
+void completes_long_chain() {
+  constexpr std::uint64_t size = 1'000'000;
+  ice::latch trigger{ 1 };
+  std::vector<ice::task<std::uint64_t>> tasks;
+  tasks.reserve(size);
+  tasks.push_back(link(trigger));
+  for (std::uint64_t i = 1; i < size; i++) {
+    tasks.push_back(link(tasks.back()));
+  }
+  std::uint64_t result = 0;
+  auto awaiter = last(tasks.back(), result);
+  CHECK(!awaiter.is_ready());
+  trigger.count_down();
+  CHECK(awaiter.is_ready());
+  CHECK(result == size - 1);
+}
+
+}  // namespace
+
+TEST("task/completes_long_chain", completes_long_chain);
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace test {
+
+using function = void (*)();
+
+struct unit {
+  std::string name;
+  test::function function;
+};
+
+inline std::vector<unit>& registry() {
+  static std::vector<unit> units;
+  return units;
+}
+
+struct registration {
+  registration(std::string name, test::function function) {
+    registry().push_back({ std::move(name), function });
+  }
+};
+
+// Number of failed checks. Checks may fail on any thread.
+inline std::atomic_size_t& failures() noexcept {
+  static std::atomic_size_t failures = 0;
+  return failures;
+}
+
+inline bool check(bool result, const char* expression, const char* file, int line) noexcept {
+  if (!result) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    failures().fetch_add(1, std::memory_order_relaxed);
+  }
+  return result;
+}
+
+}  // namespace test
+
+#define TEST_CONCAT_IMPL(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_IMPL(a, b)
+
+// Registers a test with a name and a function.
+#define TEST(name, function) \
+  static const test::registration TEST_CONCAT(registration_, __LINE__) { name, function }
+
+// Records a failure when the condition is false and returns the condition.
+#define CHECK(condition) test::check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
@@ -0,0 +1,232 @@
+#include "test.hpp"
+#include <ice/coroutine.hpp>
+#include <ice/pool.hpp>
+#include <ice/task.hpp>
+#include <ice/when_all.hpp>
+#include <ice/when_any.hpp>
+#include <array>
+#include <atomic>
+#include <latch>
+#include <memory>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <cstddef>
+
+namespace {
+
+// Suspends the awaiter until the gate is opened on the calling thread.
+class gate {
+public:
+  constexpr bool await_ready() const noexcept {
+    return false;
+  }
+
+  void await_suspend(ice::coroutine_handle<> awaiter) noexcept {
+    awaiter_ = awaiter;
+  }
+
+  constexpr void await_resume() const noexcept {
+  }
+
+  void open() noexcept {
+    std::exchange(awaiter_, nullptr).resume();
+  }
+
+private:
+  ice::coroutine_handle<> awaiter_;
+};
+
+// Counts the coroutine frames that were destroyed. Parameters live until the frame is destroyed.
+class frame {
+public:
+  explicit frame(std::atomic_int& destroyed) noexcept : destroyed_(&destroyed) {
+  }
+
+  frame(frame&& other) noexcept : destroyed_(std::exchange(other.destroyed_, nullptr)) {
+  }
+
+  frame(const frame& other) = delete;
+  frame& operator=(frame&& other) = delete;
+  frame& operator=(const frame& other) = delete;
+
+  ~frame() {
+    if (destroyed_) {
+      destroyed_->fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+private:
+  std::atomic_int* destroyed_;
+};
+
+ice::task<int> wait(gate& gate, int value, frame) {
+  co_await gate;
+  co_return value;
+}
+
+ice::task<void> all(std::array<ice::task<int>, 3>& tasks, bool& resumed) {
+  co_await ice::when_all(tasks);
+  resumed = true;
+}
+
+// The awaiter is resumed by the last task and the results stay with the caller.
+void all_waits_for_every_task() {
+  std::atomic_int destroyed = 0;
+  std::array<gate, 3> gates;
+  std::array<ice::task<int>, 3> tasks{ wait(gates[0], 0, frame{ destroyed }), wait(gates[1], 1, frame{ destroyed }), wait(gates[2], 2, frame{ destroyed }) };
+  auto resumed = false;
+  auto awaiter = all(tasks, resumed);
+  gates[2].open();
+  gates[0].open();
+  CHECK(!resumed);
+  gates[1].open();
+  CHECK(resumed);
+  CHECK(awaiter.is_ready());
+  for (std::size_t i = 0; i < tasks.size(); i++) {
+    CHECK(tasks[i].is_ready());
+  }
+  CHECK(destroyed.load() == 0);
+}
+
+ice::task<void> any(std::array<gate, 3>& gates, std::atomic_int& destroyed, std::size_t& index, int& value) {
+  const auto result = co_await ice::when_any(wait(gates[0], 10, frame{ destroyed }), wait(gates[1], 11, frame{ destroyed }), wait(gates[2], 12, frame{ destroyed }));
+  index = result.index;
+  value = result.value;
+}
+
+// The awaiter is resumed by the first task, and the others are destroyed once they are ready.
+void any_returns_first_task() {
+  std::atomic_int destroyed = 0;
+  std::array<gate, 3> gates;
+  auto index = ice::detail::when_any_state::npos;
+  auto value = -1;
+  auto awaiter = any(gates, destroyed, index, value);
+  gates[1].open();
+  CHECK(index == 1);
+  CHECK(value == 11);
+  CHECK(awaiter.is_ready());
+  CHECK(destroyed.load() == 0);
+  gates[2].open();
+  CHECK(destroyed.load() == 0);
+  gates[0].open();
+  CHECK(index == 1);
+  CHECK(destroyed.load() == 3);
+}
+
+ice::task<void> any(std::vector<ice::task<int>> tasks, std::size_t& index) {
+  index = (co_await ice::when_any(std::move(tasks))).index;
+}
+
+ice::task<int> ready(int value) {
+  co_return value;
+}
+
+// A range with a task that is ready before it is awaited does not suspend.
+void any_takes_ready_tasks() {
+  std::atomic_int destroyed = 0;
+  gate gate;
+  std::vector<ice::task<int>> tasks;
+  tasks.push_back(wait(gate, 0, frame{ destroyed }));
+  tasks.push_back(ready(1));
+  auto index = ice::detail::when_any_state::npos;
+  auto awaiter = any(std::move(tasks), index);
+  CHECK(index == 1);
+  CHECK(awaiter.is_ready());
+  gate.open();
+  CHECK(destroyed.load() == 1);
+}
+
+ice::task<int> scheduled(ice::pool& pool, int value) {
+  co_await pool.schedule(true);
+  co_return value;
+}
+
+ice::task<void> race(ice::pool& pool, std::size_t size, std::atomic_int& invalid, std::latch& done) {
+  std::vector<ice::task<int>> tasks;
+  tasks.reserve(size);
+  for (std::size_t i = 0; i < size; i++) {
+    tasks.push_back(scheduled(pool, static_cast<int>(i)));
+  }
+  const auto [index, value] = co_await ice::when_any(std::move(tasks));
+  if (index >= size || value != static_cast<int>(index)) {
+    invalid.fetch_add(1, std::memory_order_relaxed);
+  }
+  done.count_down();
+}
+
+// Races tasks that complete on different workers and must report exactly one of them.
+void any_races_on_pool() {
+  constexpr std::size_t races = 10'000;
+  std::atomic_int invalid = 0;
+  std::latch done{ static_cast<std::ptrdiff_t>(races) };
+  {
+    ice::pool pool{ 4 };
+    for (std::size_t i = 0; i < races; i++) {
+      race(pool, 1 + i % 8, invalid, done).detach();
+    }
+    done.wait();
+  }
+  CHECK(invalid.load() == 0);
+}
+
+ice::task<std::unique_ptr<std::string>> text(gate& gate, const char* text) {
+  co_await gate;
+  co_return std::make_unique<std::string>(text);
+}
+
+ice::task<void> any(std::vector<ice::task<std::unique_ptr<std::string>>> tasks, std::unique_ptr<std::string>& value) {
+  value = (co_await ice::when_any(std::move(tasks))).value;
+}
+
+// A result that can only be moved is moved out of the winner, which the state still owns.
+void any_moves_result() {
+  std::array<gate, 2> gates;
+  std::vector<ice::task<std::unique_ptr<std::string>>> tasks;
+  tasks.push_back(text(gates[0], "first"));
+  tasks.push_back(text(gates[1], "second"));
+  std::unique_ptr<std::string> value;
+  auto awaiter = any(std::move(tasks), value);
+  gates[1].open();
+  CHECK(value && *value == "second");
+  gates[0].open();
+  CHECK(awaiter.is_ready());
+}
+
+ice::task<void> done(gate& gate) {
+  co_await gate;
+}
+
+ice::task<void> any(std::array<gate, 3>& gates, std::atomic_int& destroyed, std::size_t& index, std::string& value) {
+  auto result = co_await ice::when_any(wait(gates[0], 0, frame{ destroyed }), done(gates[1]), text(gates[2], "text"));
+  index = result.index;
+  if (const auto text = std::get_if<2>(&result.value)) {
+    value = **text;
+  }
+}
+
+// Tasks with different result types return the result in a variant at the index of the winner.
+void any_returns_variant() {
+  std::atomic_int destroyed = 0;
+  std::array<gate, 3> gates;
+  auto index = ice::detail::when_any_state::npos;
+  std::string value;
+  auto awaiter = any(gates, destroyed, index, value);
+  gates[2].open();
+  CHECK(index == 2);
+  CHECK(value == "text");
+  gates[0].open();
+  gates[1].open();
+  CHECK(awaiter.is_ready());
+  CHECK(destroyed.load() == 1);
+}
+
+}  // namespace
+
+TEST("when/all_waits_for_every_task", all_waits_for_every_task);
+TEST("when/any_returns_first_task", any_returns_first_task);
+TEST("when/any_takes_ready_tasks", any_takes_ready_tasks);
+TEST("when/any_races_on_pool", any_races_on_pool);
+TEST("when/any_moves_result", any_moves_result);
+TEST("when/any_returns_variant", any_returns_variant);